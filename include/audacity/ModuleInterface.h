@@ -133,6 +133,12 @@ public:
 
    // When appropriate, DeleteInstance() will be called to delete the plugin.
    virtual void DeleteInstance(ComponentInterface *instance) = 0;
+
+   // Called before a series of calls to DiscoverPluginsAtPath() for the given
+   // paths, so that a module whose discovery is slow (as when it is done in
+   // separate processes) may examine many paths at once.  Default does nothing.
+   // Declared last so that the vtable of existing modules is unchanged.
+   virtual void PrepareToDiscoverPluginsAtPaths(const PluginPaths & WXUNUSED(paths)) {}
 };
 
 // ============================================================================
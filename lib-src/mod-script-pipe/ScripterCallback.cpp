@@ -17,6 +17,12 @@
 #include "ScripterCallback.h"
 #include "../../src/Audacity.h"
 
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+
 #if defined(__WXMSW__)
 #include <wx/init.h>
 #  if defined(__WXDEBUG__)
@@ -105,17 +111,20 @@ DLL_API const wxChar * GetVersionString()
    return AUDACITY_VERSION_STRING;
 }
 
+static void StopJobs();
+
 extern int DLL_API  ModuleDispatch(ModuleDispatchTypes type);
 // ModuleDispatch
 // is called by Audacity to initialize/terminate the module
-// We don't (yet) do anything in this, since we have a special function for the scripter
-// all we need to do is return 1.
+// We have a special function for the scripter, so all we do here is stop
+// the job thread when Audacity quits, and return 1.
 int ModuleDispatch(ModuleDispatchTypes type){
    switch (type){
       case AppInitialized:{
       }
       break;
       case AppQuiting: {
+         StopJobs();
       }
       break;
       case ProjectInitialized: {
@@ -145,6 +154,135 @@ wxArrayString aStr;
 unsigned int currentLine;
 size_t currentPosition;
 
+// Batches.
+// "BeginBatch:" starts collecting command lines, without replying to them,
+// until "EndBatch:".  The whole batch then goes to Audacity in one call, one
+// command per line, and the responses to all the commands are sent back
+// together, in order.
+static bool bBatching = false;
+static wxString batch;
+
+// Jobs.
+// "StartJob: <command>" replies at once with "JobId=<n>" and queues the
+// command for the job thread, which runs the jobs one at a time, in order.
+// "JobStatus: Id=<n>" replies "Running" until the command is done, and then
+// with the command's own response, after which the job is forgotten.  The
+// job thread is started by the first job and joined when Audacity quits.
+struct Job
+{
+   wxString command;
+   bool done;
+   wxString response;
+};
+static std::mutex jobMutex;
+static std::condition_variable jobAvailable;
+static std::map<long, Job> jobs;
+static std::deque<long> pendingJobs;
+static long nextJobId = 0;
+static bool jobRunning = false;
+static bool stopJobs = false;
+static std::thread jobThread;
+
+static wxString Finished(const wxString &command, bool ok)
+{
+   return command + wxT(" finished: ") + (ok ? wxT("OK") : wxT("Failed!"))
+      + wxT("\n");
+}
+
+static void RunJobs()
+{
+   std::unique_lock<std::mutex> lock(jobMutex);
+   while (true)
+   {
+      jobAvailable.wait(lock, []{ return stopJobs || !pendingJobs.empty(); });
+      if (stopJobs)
+         return;
+
+      const long id = pendingJobs.front();
+      pendingJobs.pop_front();
+      wxString in = jobs[id].command;
+      jobRunning = true;
+      lock.unlock();
+
+      wxString out;
+      (*pScriptServerFn)( &in, &out);
+
+      lock.lock();
+      jobRunning = false;
+      jobs[id].done = true;
+      jobs[id].response = out;
+   }
+}
+
+static wxString StartJob(const wxString &command)
+{
+   if (command.empty())
+      return wxT("Syntax error!\nExpected a command\n")
+         + Finished(wxT("StartJob"), false);
+
+   long id;
+   {
+      std::lock_guard<std::mutex> lock(jobMutex);
+      if (stopJobs)
+         return Finished(wxT("StartJob"), false);
+      id = ++nextJobId;
+      jobs[id] = Job{ command, false, {} };
+      pendingJobs.push_back(id);
+      if (!jobThread.joinable())
+         jobThread = std::thread(RunJobs);
+   }
+   jobAvailable.notify_one();
+
+   return wxString::Format(wxT("JobId=%ld\n"), id)
+      + Finished(wxT("StartJob"), true);
+}
+
+// Called on the main thread
+static void StopJobs()
+{
+   {
+      std::lock_guard<std::mutex> lock(jobMutex);
+      stopJobs = true;
+      pendingJobs.clear();
+   }
+   jobAvailable.notify_one();
+
+   if (!jobThread.joinable())
+      return;
+
+   // A running command waits for the main thread, so keep serving it
+   while (true)
+   {
+      {
+         std::lock_guard<std::mutex> lock(jobMutex);
+         if (!jobRunning)
+            break;
+      }
+      if (wxTheApp)
+         wxTheApp->ProcessPendingEvents();
+      wxMilliSleep(10);
+   }
+   jobThread.join();
+}
+
+static wxString JobStatus(const wxString &params)
+{
+   long id;
+   if (!params.AfterFirst(wxT('=')).ToLong(&id))
+      return wxT("Syntax error!\nExpected Id=<job number>\n");
+
+   std::lock_guard<std::mutex> lock(jobMutex);
+   auto iter = jobs.find(id);
+   if (iter == jobs.end())
+      return wxT("Unknown job\n") + Finished(wxT("JobStatus"), false);
+   if (!iter->second.done)
+      return wxT("Running\n") + Finished(wxT("JobStatus"), true);
+
+   auto response = iter->second.response;
+   jobs.erase(iter);
+   return response;
+}
+
 // Send the received command to Audacity and build an array of response lines.
 // The response lines can be retrieved by calling DoSrvMore repeatedly.
 int DoSrv(char *pIn)
@@ -157,7 +295,42 @@ int DoSrv(char *pIn)
    Str1.Replace( wxT("\r"), wxT(""));
    Str1.Replace( wxT("\n"), wxT(""));
    Str2 = wxEmptyString;
-   (*pScriptServerFn)( &Str1 , &Str2);
+
+   const auto name = Str1.BeforeFirst(wxT(':')).Trim(true).Trim(false);
+   if (bBatching && name != wxT("EndBatch"))
+   {
+      batch += Str1 + wxT('\n');
+      // Nothing to send until the batch is complete
+      aStr.Clear();
+      currentLine     = 0;
+      currentPosition = 0;
+      return 1;
+   }
+
+   if (name == wxT("BeginBatch"))
+   {
+      bBatching = true;
+      batch = wxEmptyString;
+      aStr.Clear();
+      currentLine     = 0;
+      currentPosition = 0;
+      return 1;
+   }
+   else if (bBatching)
+   {
+      bBatching = false;
+      if (batch.empty())
+         Str2 = wxT("Empty batch\n") + Finished(wxT("EndBatch"), false);
+      else
+         (*pScriptServerFn)( &batch , &Str2);
+      batch = wxEmptyString;
+   }
+   else if (name == wxT("StartJob"))
+      Str2 = StartJob(Str1.AfterFirst(wxT(':')).Trim(false));
+   else if (name == wxT("JobStatus"))
+      Str2 = JobStatus(Str1.AfterFirst(wxT(':')));
+   else
+      (*pScriptServerFn)( &Str1 , &Str2);
 
    Str2 += wxT('\n');
    size_t outputLength = Str2.Length();
@@ -45,6 +45,7 @@ It handles initialization and termination by subclassing wxApp.
 
 #include <wx/fs_zip.h>
 #include <wx/image.h>
+#include <wx/stopwatch.h>
 
 #include <wx/dir.h>
 #include <wx/file.h>
@@ -102,6 +103,7 @@ It handles initialization and termination by subclassing wxApp.
 #include "SplashDialog.h"
 #include "FFT.h"
 #include "BlockFile.h"
+#include "blockfile/SimpleBlockFile.h"
 #include "ondemand/ODManager.h"
 #include "widgets/AudacityMessageBox.h"
 #include "prefs/DirectoriesPrefs.h"
@@ -281,6 +283,30 @@ static void wxOnAssert(const wxChar *fileName, int lineNumber, const wxChar *msg
 
 namespace {
 
+// Records how long each phase of OnInit takes, and writes the timings to
+// the log (Help > Diagnostics > Show Log...) so that slow starts can be
+// diagnosed without a profiler.
+class StartupTrace
+{
+public:
+   StartupTrace() { mTotal.Start(); mPhase.Start(); }
+
+   void Mark(const wxChar *phase)
+   {
+      wxLogMessage(wxT("Startup: %s took %ld ms"), phase, mPhase.Time());
+      mPhase.Start();
+   }
+
+   void Finish()
+   {
+      wxLogMessage(wxT("Startup: total %ld ms"), mTotal.Time());
+   }
+
+private:
+   wxStopWatch mTotal;
+   wxStopWatch mPhase;
+};
+
 void PopulatePreferences()
 {
    bool resetPrefs = false;
@@ -1215,6 +1241,8 @@ bool AudacityApp::OnInit()
    // cause initialization of wxWidgets' global logger target
    (void) AudacityLogger::Get();
 
+   StartupTrace trace;
+
 #if defined(__WXMAC__)
    // Disable window animation
    wxSystemOptions::SetOption(wxMAC_WINDOW_PLAIN_TRANSITION, 1);
@@ -1385,6 +1413,9 @@ bool AudacityApp::OnInit()
          UnwritablePreferencesErrorMessage( configFileName ) );
       return false;
    }
+   trace.Mark(wxT("preferences and locale"));
+
+   SampleBlockCache::Get().ReadPrefs();
 
 #if defined(__WXMSW__) && !defined(__WXUNIVERSAL__) && !defined(__CYGWIN__)
    this->AssociateFileTypes();
@@ -1394,6 +1425,7 @@ bool AudacityApp::OnInit()
 
    // AColor depends on theTheme.
    AColor::Init();
+   trace.Mark(wxT("theme"));
 
    // Init DirManager, which initializes the temp directory
    // If this fails, we must exit the program.
@@ -1401,6 +1433,7 @@ bool AudacityApp::OnInit()
       FinishPreferences();
       return false;
    }
+   trace.Mark(wxT("temporary directory"));
 
    //<<<< Try to avoid dialogs before this point.
    // The reason is that InitTempDir starts the single instance checker.
@@ -1412,9 +1445,11 @@ bool AudacityApp::OnInit()
 
    // Initialize the PluginManager
    PluginManager::Get().Initialize();
+   trace.Mark(wxT("plug-in registry"));
 
    // Initialize the ModuleManager, including loading found modules
    ModuleManager::Get().Initialize(*mCmdHandler);
+   trace.Mark(wxT("modules"));
 
    // Parse command line and handle options that might require
    // immediate exit...no need to initialize all of the audio
@@ -1510,6 +1545,7 @@ bool AudacityApp::OnInit()
 
       InitDitherers();
       AudioIO::Init();
+      trace.Mark(wxT("audio I/O"));
 
 #ifdef __WXMAC__
 
@@ -1564,6 +1600,7 @@ bool AudacityApp::OnInit()
          pWnd->Show(true);
       }
    }
+   trace.Mark(wxT("first project window"));
 
    if( ProjectSettings::Get( *project ).GetShowSplashScreen() ){
       // This may do a check-for-updates at every start up.
@@ -1578,6 +1615,13 @@ bool AudacityApp::OnInit()
    #endif
 
    Importer::Get().Initialize();
+   trace.Mark(wxT("importers"));
+
+   // Searching the plug-in folders for plug-ins not yet in the registry
+   // walks whole directory trees, but only the registration dialog needs
+   // the result, so do it on another thread.
+   if (gPrefs->ReadBool(wxT("/Plugins/CheckForUpdates"), true))
+      PluginManager::Get().FindNewPluginsInBackground();
 
    // Bug1561: delay the recovery dialog, to avoid crashes.
    CallAfter( [=] () mutable {
@@ -1626,6 +1670,7 @@ bool AudacityApp::OnInit()
    gInited = true;
 
    ModuleManager::Get().Dispatch(AppInitialized);
+   trace.Finish();
 
    mTimer.SetOwner(this, kAudacityAppTimerID);
    mTimer.Start(200);
@@ -461,6 +461,7 @@ time warp info and AudioIOListener and whether the playback is looped.
 #include "Prefs.h"
 #include "Project.h"
 #include "WaveTrack.h"
+#include "blockfile/SimpleBlockFile.h"
 #include "AutoRecovery.h"
 
 #include "effects/RealtimeEffectManager.h"
@@ -2405,6 +2406,8 @@ void AudioIO::StopStream()
    bool wasMonitoring = mStreamToken == 0;
    mStreamToken = 0;
 
+   SampleBlockCache::Get().Unpin();
+
    if (mNumPlaybackChannels > 0)
    {
       wxCommandEvent e(EVT_AUDIOIO_PLAYBACK);
@@ -2584,6 +2587,8 @@ AudioThread::ExitCode AudioThread::Entry()
 
       // Set LoopActive outside the tests to avoid race condition
       gAudioIO->mAudioThreadFillBuffersLoopActive = true;
+      // Keep what playback reads in memory, in case it loops or replays
+      SampleBlockCache::Pinning pinning;
       if( gAudioIO->mAudioThreadShouldCallFillBuffersOnce )
       {
          gAudioIO->FillBuffers();
@@ -26,6 +26,8 @@ text or binary format to a file.
 
 #include <wx/wxprec.h>
 #include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/ffile.h>
 #include <wx/dir.h>
 #include <wx/dialog.h>
 #include <wx/app.h>
@@ -226,6 +228,13 @@ XMLTagHandler* RecordingRecoveryHandler::HandleXMLChild(const wxChar *tag)
 // All strings are in native unicode format, 2-byte or 4-byte.
 //
 // All "lengths" are 2-byte signed, so are limited to 32767 bytes long.
+//
+// A journaled file (see AutoSaveJournal) has instead, after the ident, a
+// sequence of slot records, each holding a subtree as written by
+// WriteSubTree, and commit records giving the number of slots that make up
+// the document at that point.  Decoding replays the journal, up to the last
+// complete commit, into the plain form above.  Anything after the journal
+// (such as recording recovery logs) follows the replayed document.
 
 enum FieldTypes
 {
@@ -243,7 +252,9 @@ enum FieldTypes
    FT_Raw,           // type, string length, string
    FT_Push,          // type only
    FT_Pop,           // type only
-   FT_Name           // type, ID, name length, name
+   FT_Name,          // type, ID, name length, name
+   FT_Slot,          // type, slot number, length, subtree
+   FT_Commit         // type, count of slots
 };
 
 TranslatableString AutoSaveFile::FailureMessage( const FilePath &/*filePath*/ )
@@ -381,6 +392,46 @@ void AutoSaveFile::WriteSubTree(const AutoSaveFile & value)
    mBuffer.PutC(FT_Pop);
 }
 
+std::vector<char> AutoSaveFile::GetSubTree() const
+{
+   wxStreamBuffer *dict = mDict.GetOutputStreamBuffer();
+   wxStreamBuffer *buf = mBuffer.GetOutputStreamBuffer();
+
+   std::vector<char> result;
+   result.reserve(dict->GetIntPosition() + buf->GetIntPosition() + 2);
+
+   const auto start = [](wxStreamBuffer *b){
+      return static_cast<const char *>(b->GetBufferStart()); };
+
+   result.push_back(FT_Push);
+   result.insert(result.end(),
+      start(dict), start(dict) + dict->GetIntPosition());
+   result.insert(result.end(),
+      start(buf), start(buf) + buf->GetIntPosition());
+   result.push_back(FT_Pop);
+
+   return result;
+}
+
+std::vector<char> AutoSaveFile::GetBytes() const
+{
+   wxStreamBuffer *dict = mDict.GetOutputStreamBuffer();
+   wxStreamBuffer *buf = mBuffer.GetOutputStreamBuffer();
+
+   std::vector<char> result;
+   result.reserve(dict->GetIntPosition() + buf->GetIntPosition());
+
+   const auto start = [](wxStreamBuffer *b){
+      return static_cast<const char *>(b->GetBufferStart()); };
+
+   result.insert(result.end(),
+      start(dict), start(dict) + dict->GetIntPosition());
+   result.insert(result.end(),
+      start(buf), start(buf) + buf->GetIntPosition());
+
+   return result;
+}
+
 bool AutoSaveFile::Write(wxFFile & file) const
 {
    bool success = file.Write(AutoSaveIdent, strlen(AutoSaveIdent)) == strlen(AutoSaveIdent);
@@ -450,6 +501,69 @@ bool AutoSaveFile::IsEmpty() const
    return mBuffer.GetLength() == 0;
 }
 
+// Rewrite the journal at the start of data as the plain encoding of its
+// last committed version, followed by the rest of data
+static void ReplayJournal(const char *data, size_t len, ArrayOf<char> &result,
+                          size_t &resultLen)
+{
+   std::vector< std::pair<const char *, size_t> > slots, committed;
+   const char *pos = data, *end = data + len;
+
+   auto read = [&](void *dest, size_t size){
+      if (size_t(end - pos) < size)
+         return false;
+      memcpy(dest, pos, size);
+      pos += size;
+      return true;
+   };
+
+   // The journal ends at the first byte that is not a journal record, or
+   // at an incomplete record left by a crash while appending
+   const char *journalEnd = pos;
+   while (pos < end) {
+      char type = *pos++;
+      if (type == FT_Slot) {
+         int id;
+         size_t size;
+         if (!read(&id, sizeof(id)) || !read(&size, sizeof(size)) ||
+             id < 0 || size_t(end - pos) < size)
+            break;
+         if (slots.size() <= size_t(id))
+            slots.resize(id + 1);
+         slots[id] = { pos, size };
+         pos += size;
+      }
+      else if (type == FT_Commit) {
+         int count;
+         if (!read(&count, sizeof(count)) || count < 0)
+            break;
+         slots.resize(count);
+         committed = slots;
+         journalEnd = pos;
+      }
+      else {
+         // Not part of the journal; keep this byte
+         --pos;
+         journalEnd = pos;
+         break;
+      }
+   }
+
+   // Slots after the last commit are discarded, but whatever follows a
+   // complete journal is kept
+   const char *rest = (pos == journalEnd) ? journalEnd : end;
+
+   resultLen = end - rest;
+   for (const auto &slot : committed)
+      resultLen += slot.second;
+
+   result.reinit(resultLen);
+   char *out = result.get();
+   for (const auto &slot : committed)
+      memcpy(out, slot.first, slot.second), out += slot.second;
+   memcpy(out, rest, end - rest);
+}
+
 bool AutoSaveFile::Decode(const FilePath & fileName)
 {
    char ident[sizeof(AutoSaveIdent)];
@@ -519,10 +633,17 @@ bool AutoSaveFile::Decode(const FilePath & fileName)
       return false;
    }
 
-   wxMemoryInputStream in(buf.get(), len);
-
    file.Close();
 
+   if (len > 0 && (buf[0] == FT_Slot || buf[0] == FT_Commit))
+   {
+      Chars replayed;
+      ReplayJournal(buf.get(), len, replayed, len);
+      buf = std::move(replayed);
+   }
+
+   wxMemoryInputStream in(buf.get(), len);
+
    // JKC: ANSWER-ME: Is the try catch actually doing anything?
    // If it is useful, why are we not using it everywhere?
    // If it isn't useful, why are we doing it here?
@@ -726,3 +847,119 @@ bool AutoSaveFile::Decode(const FilePath & fileName)
       return true;
    } );
 }
+
+///
+/// AutoSaveJournal class
+///
+
+// Rewrite the whole file when the journal exceeds this multiple of the size
+// of the live document
+static const size_t JournalCompactionRatio = 2;
+
+AutoSaveJournal::AutoSaveJournal()
+{
+}
+
+AutoSaveJournal::~AutoSaveJournal()
+{
+}
+
+void AutoSaveJournal::AddSlot(const AutoSaveFile & contents)
+{
+   mPending.push_back(contents.GetSubTree());
+   mPendingSize += mPending.back().size();
+}
+
+bool AutoSaveJournal::CanAppend(const FilePath & fileName) const
+{
+   if (mFileLength == 0)
+      return false;
+
+   // Recording logs are appended by others, and then the journal can't
+   // continue after them
+   if (wxFileName::GetSize(fileName) != wxULongLong(mFileLength))
+      return false;
+
+   return mFileLength <= JournalCompactionRatio * mPendingSize;
+}
+
+bool AutoSaveJournal::Append(wxFFile & file)
+{
+   Bytes bytes;
+   const auto count = mPending.size();
+   for (size_t id = 0; id < count; ++id)
+      if (id >= mSlots.size() || mPending[id] != mSlots[id])
+         PutSlot(bytes, id, mPending[id]);
+
+   if (bytes.empty() && count == mSlots.size()) {
+      // Nothing changed
+      Commit();
+      return true;
+   }
+
+   PutCommit(bytes, count);
+   return WriteBytes(file, bytes);
+}
+
+bool AutoSaveJournal::Write(wxFFile & file)
+{
+   Bytes bytes;
+   bytes.reserve(strlen(AutoSaveIdent) + mPendingSize +
+      mPending.size() * (1 + sizeof(int) + sizeof(size_t)));
+   bytes.insert(bytes.end(), AutoSaveIdent, AutoSaveIdent + strlen(AutoSaveIdent));
+
+   const auto count = mPending.size();
+   for (size_t id = 0; id < count; ++id)
+      PutSlot(bytes, id, mPending[id]);
+   PutCommit(bytes, count);
+
+   mFileLength = 0;
+   return WriteBytes(file, bytes);
+}
+
+void AutoSaveJournal::Reset()
+{
+   mSlots.clear();
+   mPending.clear();
+   mPendingSize = 0;
+   mFileLength = 0;
+}
+
+void AutoSaveJournal::PutSlot(Bytes & out, int id, const Bytes & contents)
+{
+   size_t size = contents.size();
+   out.push_back(FT_Slot);
+   out.insert(out.end(), (const char *)&id, (const char *)&id + sizeof(id));
+   out.insert(out.end(),
+      (const char *)&size, (const char *)&size + sizeof(size));
+   out.insert(out.end(), contents.begin(), contents.end());
+}
+
+void AutoSaveJournal::PutCommit(Bytes & out, int count)
+{
+   out.push_back(FT_Commit);
+   out.insert(out.end(),
+      (const char *)&count, (const char *)&count + sizeof(count));
+}
+
+bool AutoSaveJournal::WriteBytes(wxFFile & file, const Bytes & bytes)
+{
+   if (!file.IsOpened() ||
+       file.Write(bytes.data(), bytes.size()) != bytes.size() ||
+       !file.Flush()) {
+      // Don't trust the file any more; the next save writes a complete one
+      Reset();
+      return false;
+   }
+
+   mFileLength += bytes.size();
+   Commit();
+   return true;
+}
+
+void AutoSaveJournal::Commit()
+{
+   mSlots.swap(mPending);
+   mPending.clear();
+   mPendingSize = 0;
+}
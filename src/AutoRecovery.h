@@ -16,6 +16,7 @@
 #include <wx/mstream.h> // member variables
 
 #include <unordered_map>
+#include <vector>
 #include "audacity/Types.h"
 
 class wxFFile;
@@ -84,6 +85,12 @@ public:
    // Non-override functions
    void WriteSubTree(const AutoSaveFile & value);
 
+   // The bytes that WriteSubTree would insert into another AutoSaveFile
+   std::vector<char> GetSubTree() const;
+
+   // The bytes that Append would write
+   std::vector<char> GetBytes() const;
+
    bool Write(wxFFile & file) const;
    bool Append(wxFFile & file) const;
 
@@ -102,5 +109,54 @@ private:
    size_t mAllocSize;
 };
 
+///
+/// AutoSaveJournal
+///
+
+// Remembers what was last written to an autosave file that is kept as a
+// journal of numbered "slots" (the project header, then one per track).
+// Each auto-save supplies all slots again, but only the ones whose encoding
+// changed are appended, followed by a commit record.  When the journal has
+// grown too large relative to the live data, or the file was changed by
+// someone else (as by the recording log), a complete file is written
+// instead, which also compacts it.  AutoSaveFile::Decode replays the journal.
+class AUDACITY_DLL_API AutoSaveJournal final
+{
+public:
+   AutoSaveJournal();
+   ~AutoSaveJournal();
+
+   // Supply the slots of the next version of the document, in order
+   void AddSlot(const AutoSaveFile & contents);
+
+   // Whether the added slots may be appended to the named file
+   bool CanAppend(const FilePath & fileName) const;
+
+   // Append changed slots and a commit record
+   bool Append(wxFFile & file);
+   // Write a complete NEW journal, containing only the added slots
+   bool Write(wxFFile & file);
+
+   // Forget the file; the next save must Write
+   void Reset();
+
+private:
+   using Bytes = std::vector<char>;
+
+   static void PutSlot(Bytes & out, int id, const Bytes & contents);
+   static void PutCommit(Bytes & out, int count);
+   bool WriteBytes(wxFFile & file, const Bytes & bytes);
+   void Commit();
+
+   // Slots as last written to the file
+   std::vector<Bytes> mSlots;
+   // Slots added since then
+   std::vector<Bytes> mPending;
+   size_t mPendingSize{ 0 };
+
+   // Length of the file after the last write, or zero if none
+   size_t mFileLength{ 0 };
+};
+
 
 #endif
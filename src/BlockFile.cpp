@@ -43,6 +43,7 @@ out.
 #include "BlockFile.h"
 
 #include <float.h>
+#include <algorithm>
 #include <cmath>
 
 #include <wx/utils.h>
@@ -51,9 +52,25 @@ out.
 #include <wx/log.h>
 
 #include "sndfile.h"
+#include "CPUFeatures.h"
 #include "FileException.h"
 #include "FileFormats.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+   (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SUMMARY_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef CPU_AVX_KERNELS
+#define SUMMARY_AVX
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define SUMMARY_NEON
+#include <arm_neon.h>
+#endif
+
 // msmeyer: Define this to add debug output via wxPrintf()
 //#define DEBUG_BLOCKFILE
 
@@ -208,49 +225,205 @@ void *BlockFile::CalcSummary(samplePtr buffer, size_t len,
    return fullSummary.get();
 }
 
+namespace {
+
+// Min, max and sum of squares of len > 0 samples, all in one pass.
+// Like the loop they replace, these ignore NaN samples after the first.
+using SummaryKernel = void (*)(const float *buffer, size_t len,
+   float &outMin, float &outMax, float &outSumsq);
+
+#if !defined(SUMMARY_SSE2) && !defined(SUMMARY_NEON)
+void SummarizeScalar(const float *buffer, size_t len,
+   float &outMin, float &outMax, float &outSumsq)
+{
+   float min = buffer[0], max = buffer[0];
+   float sumsq = buffer[0] * buffer[0];
+   for (size_t i = 1; i < len; i++) {
+      const float f1 = buffer[i];
+      sumsq += f1 * f1;
+      if (f1 < min)
+         min = f1;
+      else if (f1 > max)
+         max = f1;
+   }
+   outMin = min, outMax = max, outSumsq = sumsq;
+}
+#endif
+
+// Combine the lanes of the vector kernels, then the samples left over
+template<size_t Lanes>
+void FinishSummary(const float (&mins)[Lanes], const float (&maxs)[Lanes],
+   const float (&sums)[Lanes], const float *rest, size_t restLen,
+   float &outMin, float &outMax, float &outSumsq)
+{
+   float min = mins[0], max = maxs[0], sumsq = 0;
+   for (size_t i = 1; i < Lanes; i++) {
+      if (mins[i] < min)
+         min = mins[i];
+      if (maxs[i] > max)
+         max = maxs[i];
+   }
+   for (size_t i = 0; i < Lanes; i++)
+      sumsq += sums[i];
+   for (size_t i = 0; i < restLen; i++) {
+      const float f1 = rest[i];
+      sumsq += f1 * f1;
+      if (f1 < min)
+         min = f1;
+      else if (f1 > max)
+         max = f1;
+   }
+   outMin = min, outMax = max, outSumsq = sumsq;
+}
+
+// The vector kernels pass the new sample as the first operand of min and
+// max, because the second is returned where either is NaN
+
+#ifdef SUMMARY_SSE2
+void SummarizeSSE2(const float *buffer, size_t len,
+   float &outMin, float &outMax, float &outSumsq)
+{
+   __m128 min = _mm_set1_ps(buffer[0]), max = min;
+   __m128 sumsq = _mm_setzero_ps();
+   size_t i = 0;
+   for (; i + 4 <= len; i += 4) {
+      const __m128 x = _mm_loadu_ps(buffer + i);
+      min = _mm_min_ps(x, min);
+      max = _mm_max_ps(x, max);
+      sumsq = _mm_add_ps(sumsq, _mm_mul_ps(x, x));
+   }
+   float mins[4], maxs[4], sums[4];
+   _mm_storeu_ps(mins, min);
+   _mm_storeu_ps(maxs, max);
+   _mm_storeu_ps(sums, sumsq);
+   FinishSummary(mins, maxs, sums, buffer + i, len - i,
+      outMin, outMax, outSumsq);
+}
+#endif
+
+#ifdef SUMMARY_AVX
+CPU_TARGET("avx")
+void SummarizeAVX(const float *buffer, size_t len,
+   float &outMin, float &outMax, float &outSumsq)
+{
+   __m256 min = _mm256_set1_ps(buffer[0]), max = min;
+   __m256 sumsq = _mm256_setzero_ps();
+   size_t i = 0;
+   for (; i + 8 <= len; i += 8) {
+      const __m256 x = _mm256_loadu_ps(buffer + i);
+      min = _mm256_min_ps(x, min);
+      max = _mm256_max_ps(x, max);
+      sumsq = _mm256_add_ps(sumsq, _mm256_mul_ps(x, x));
+   }
+   float mins[8], maxs[8], sums[8];
+   _mm256_storeu_ps(mins, min);
+   _mm256_storeu_ps(maxs, max);
+   _mm256_storeu_ps(sums, sumsq);
+   FinishSummary(mins, maxs, sums, buffer + i, len - i,
+      outMin, outMax, outSumsq);
+}
+#endif
+
+#ifdef SUMMARY_NEON
+void SummarizeNEON(const float *buffer, size_t len,
+   float &outMin, float &outMax, float &outSumsq)
+{
+   float32x4_t min = vdupq_n_f32(buffer[0]), max = min;
+   float32x4_t sumsq = vdupq_n_f32(0);
+   size_t i = 0;
+   for (; i + 4 <= len; i += 4) {
+      const float32x4_t x = vld1q_f32(buffer + i);
+      // NEON min and max propagate NaN, so select instead
+      min = vbslq_f32(vcltq_f32(x, min), x, min);
+      max = vbslq_f32(vcgtq_f32(x, max), x, max);
+      sumsq = vmlaq_f32(sumsq, x, x);
+   }
+   float mins[4], maxs[4], sums[4];
+   vst1q_f32(mins, min);
+   vst1q_f32(maxs, max);
+   vst1q_f32(sums, sumsq);
+   FinishSummary(mins, maxs, sums, buffer + i, len - i,
+      outMin, outMax, outSumsq);
+}
+#endif
+
+SummaryKernel ChooseSummaryKernel()
+{
+#ifdef SUMMARY_AVX
+   if (CPUHasAVX())
+      return SummarizeAVX;
+#endif
+#if defined(SUMMARY_SSE2)
+   return SummarizeSSE2;
+#elif defined(SUMMARY_NEON)
+   return SummarizeNEON;
+#else
+   return SummarizeScalar;
+#endif
+}
+
+}
+
 void BlockFile::CalcSummaryFromBuffer(const float *fbuffer, size_t len,
                                       float *summary256, float *summary64K)
 {
-   decltype(len) sumLen;
+   static const SummaryKernel summarize = ChooseSummaryKernel();
 
    float min, max;
    float sumsq;
    double totalSquares = 0.0;
    double fraction { 0.0 };
 
-   // Recalc 256 summaries
-   sumLen = (len + 255) / 256;
-   int summaries = 256;
-
-   for (decltype(sumLen) i = 0; i < sumLen; i++) {
-      min = fbuffer[i * 256];
-      max = fbuffer[i * 256];
-      sumsq = ((float)min) * ((float)min);
-      decltype(len) jcount = 256;
-      if (jcount > len - i * 256) {
-         jcount = len - i * 256;
-         fraction = 1.0 - (jcount / 256.0);
-      }
-      for (decltype(jcount) j = 1; j < jcount; j++) {
-         float f1 = fbuffer[i * 256 + j];
-         sumsq += ((float)f1) * ((float)f1);
-         if (f1 < min)
-            min = f1;
-         else if (f1 > max)
-            max = f1;
+   const auto sumLen256 = (len + 255) / 256;
+   const auto sumLen64K = (len + 65535) / 65536;
+
+   // Remaining 256 summaries get non-harming/contributing values, but
+   // rms values are not "non-harming", so keep count of them
+   const int summaries =
+      256 - (int)(mSummaryInfo.frames256 - std::min<size_t>(
+         sumLen256, mSummaryInfo.frames256));
+
+   // Calculate both summary levels in one pass over the samples
+   for (decltype(len) k = 0; k < sumLen64K; k++) {
+      float min64K = 0, max64K = 0, sumsq64K = 0;
+
+      const auto end = std::min<size_t>((k + 1) * 256, sumLen256);
+      for (auto i = k * 256; i < end; i++) {
+         decltype(len) jcount = 256;
+         if (jcount > len - i * 256) {
+            jcount = len - i * 256;
+            fraction = 1.0 - (jcount / 256.0);
+         }
+         summarize(fbuffer + i * 256, jcount, min, max, sumsq);
+
+         totalSquares += sumsq;
+         float rms = (float)sqrt(sumsq / jcount);
+
+         summary256[i * 3] = min;
+         summary256[i * 3 + 1] = max;
+         summary256[i * 3 + 2] = rms;  // The rms is correct, but this may be for less than 256 samples in last loop.
+
+         if (i == k * 256)
+            min64K = min, max64K = max, sumsq64K = rms * rms;
+         else {
+            if (min < min64K)
+               min64K = min;
+            if (max > max64K)
+               max64K = max;
+            sumsq64K += rms * rms;
+         }
       }
 
-      totalSquares += sumsq;
-      float rms = (float)sqrt(sumsq / jcount);
+      double denom = (k < sumLen64K - 1) ? 256.0 : summaries - fraction;
+      float rms = (float)sqrt(sumsq64K / denom);
 
-      summary256[i * 3] = min;
-      summary256[i * 3 + 1] = max;
-      summary256[i * 3 + 2] = rms;  // The rms is correct, but this may be for less than 256 samples in last loop.
+      summary64K[k * 3] = min64K;
+      summary64K[k * 3 + 1] = max64K;
+      summary64K[k * 3 + 2] = rms;
    }
-   for (auto i = sumLen; i < mSummaryInfo.frames256; i++) {
+
+   for (auto i = sumLen256; i < mSummaryInfo.frames256; i++) {
       // filling in the remaining bits with non-harming/contributing values
-      // rms values are not "non-harming", so keep  count of them:
-      summaries--;
       summary256[i * 3] = FLT_MAX;  // min
       summary256[i * 3 + 1] = -FLT_MAX;   // max
       summary256[i * 3 + 2] = 0.0f; // rms
@@ -259,31 +432,7 @@ void BlockFile::CalcSummaryFromBuffer(const float *fbuffer, size_t len,
    // Calculate now while we can do it accurately
    mRMS = sqrt(totalSquares/len);
 
-   // Recalc 64K summaries
-   sumLen = (len + 65535) / 65536;
-
-   for (decltype(sumLen) i = 0; i < sumLen; i++) {
-      min = summary256[3 * i * 256];
-      max = summary256[3 * i * 256 + 1];
-      sumsq = (float)summary256[3 * i * 256 + 2];
-      sumsq *= sumsq;
-      for (decltype(len) j = 1; j < 256; j++) {   // we can overflow the useful summary256 values here, but have put non-harmful values in them
-         if (summary256[3 * (i * 256 + j)] < min)
-            min = summary256[3 * (i * 256 + j)];
-         if (summary256[3 * (i * 256 + j) + 1] > max)
-            max = summary256[3 * (i * 256 + j) + 1];
-         float r1 = summary256[3 * (i * 256 + j) + 2];
-         sumsq += r1*r1;
-      }
-
-      double denom = (i < sumLen - 1) ? 256.0 : summaries - fraction;
-      float rms = (float)sqrt(sumsq / denom);
-
-      summary64K[i * 3] = min;
-      summary64K[i * 3 + 1] = max;
-      summary64K[i * 3 + 2] = rms;
-   }
-   for (auto i = sumLen; i < mSummaryInfo.frames64K; i++) {
+   for (auto i = sumLen64K; i < mSummaryInfo.frames64K; i++) {
       wxASSERT_MSG(false, wxT("Out of data for mSummaryInfo"));   // Do we ever get here?
       summary64K[i * 3] = 0.0f;  // probably should be FLT_MAX, need a test case
       summary64K[i * 3 + 1] = 0.0f; // probably should be -FLT_MAX, need a test case
@@ -294,7 +443,7 @@ void BlockFile::CalcSummaryFromBuffer(const float *fbuffer, size_t len,
    min = summary64K[0];
    max = summary64K[1];
 
-   for (decltype(sumLen) i = 1; i < sumLen; i++) {
+   for (decltype(len) i = 1; i < sumLen64K; i++) {
       if (summary64K[3*i] < min)
          min = summary64K[3*i];
       if (summary64K[3*i+1] > max)
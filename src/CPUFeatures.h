@@ -0,0 +1,56 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  CPUFeatures.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_CPU_FEATURES__
+#define __AUDACITY_CPU_FEATURES__
+
+// Vector kernels are compiled for the instruction sets the build targets,
+// but AVX and AVX2 ones only where the compiler builds them on request; those
+// may run only after the CPU check below succeeds
+
+#if (defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))) || \
+   (defined(_MSC_VER) && defined(_M_X64))
+#define CPU_AVX_KERNELS
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#ifdef __GNUC__
+#define CPU_TARGET(name) __attribute__((target(name)))
+#else
+#define CPU_TARGET(name)
+#endif
+
+inline bool CPUHasAVX()
+{
+#ifdef _MSC_VER
+   int info[4];
+   __cpuid(info, 1);
+   // The OS must also save the AVX registers
+   const bool osxsave = (info[2] & (1 << 27)) != 0;
+   const bool avx = (info[2] & (1 << 28)) != 0;
+   return osxsave && avx && (_xgetbv(0) & 6) == 6;
+#else
+   return __builtin_cpu_supports("avx");
+#endif
+}
+
+inline bool CPUHasAVX2()
+{
+#ifdef _MSC_VER
+   int info[4];
+   __cpuidex(info, 7, 0);
+   return CPUHasAVX() && (info[1] & (1 << 5)) != 0;
+#else
+   return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+#endif
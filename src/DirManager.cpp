@@ -64,6 +64,9 @@
 #include "Audacity.h" // for __UNIX__
 #include "DirManager.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <time.h> // to use time() for srand()
 
 #include <wx/wxcrtvararg.h>
@@ -86,6 +89,8 @@
 #endif
 
 #include "BlockFile.h"
+#include "blockfile/SimpleBlockFile.h"
+#include "ondemand/ODTaskThread.h"
 #include "FileNames.h"
 #include "InconsistencyException.h"
 #include "Prefs.h"
@@ -218,6 +223,71 @@ int DirManager::RecursivelyEnumerateWithProgress(const FilePath &dirPath,
    return count;
 }
 
+int DirManager::EnumerateDataFiles(const FilePath &dirPath,
+                                   FilePaths& filePathArray,
+                                   DiskFileIndex &index,
+                                   int progress_count,
+                                   const TranslatableString &message)
+{
+   Optional<ProgressDialog> progress{};
+   if (!message.empty())
+      progress.emplace( XO("Progress"), message );
+
+   // Files directly in dirPath, and the top level (e##) subdirectories
+   FilePaths topFiles, subdirs;
+   {
+      wxDir dir(dirPath);
+      if (!dir.IsOpened())
+         return 0;
+      wxString name;
+      for (bool cont = dir.GetFirst(&name, wxEmptyString,
+              wxDIR_FILES | wxDIR_HIDDEN | wxDIR_NO_FOLLOW);
+           cont; cont = dir.GetNext(&name))
+         topFiles.push_back(dirPath + wxFILE_SEP_PATH + name);
+      for (bool cont = dir.GetFirst(&name, wxEmptyString,
+              wxDIR_DIRS | wxDIR_NO_FOLLOW);
+           cont; cont = dir.GetNext(&name))
+         subdirs.push_back(dirPath + wxFILE_SEP_PATH + name);
+   }
+
+   struct Result {
+      FilePaths files;
+      std::vector<wxULongLong> sizes;
+   };
+   std::vector<Result> results( subdirs.size() );
+   std::atomic<int> count{ 0 };
+
+   const auto walk = [&]( size_t ii ){
+      auto &result = results[ii];
+      RecursivelyEnumerate( subdirs[ii], result.files,
+         wxEmptyString, wxEmptyString, true, false );
+      result.sizes.reserve( result.files.size() );
+      for (const auto &path : result.files)
+         result.sizes.push_back(
+            path.Lower().EndsWith(wxT(".au"))
+               ? wxFileName::GetSize(path) : wxInvalidSize );
+      count += result.files.size();
+   };
+   ParallelFor( subdirs.size(), walk, [&]{
+      if (progress)
+         progress->Update( count.load(), progress_count );
+   } );
+
+   // Collect in the order that RecursivelyEnumerate would have
+   const auto add = [&]( const FilePath &path, wxULongLong size ){
+      filePathArray.push_back( path );
+      wxFileName fileName{ path };
+      index.emplace( fileName.GetFullName(), DiskFile{ path, size } );
+   };
+   for (const auto &path : topFiles)
+      add( path, wxInvalidSize );
+   for (const auto &result : results)
+      for (size_t jj = 0; jj < result.files.size(); ++jj)
+         add( result.files[jj], result.sizes[jj] );
+
+   return topFiles.size() + count;
+}
+
 int DirManager::RecursivelyCountSubdirs( const FilePath &dirPath )
 {
    bool bContinue;
@@ -418,6 +488,9 @@ DirManager::DirManager()
 
    mMaxSamples = ~size_t(0);
 
+   mDeduplicate = gPrefs->Read(wxT("/Directories/DeduplicateBlocks"), true);
+   mCompressBlocks = gPrefs->Read(wxT("/Directories/CompressBlocks"), false);
+
    // toplevel pool hash is fully populated to begin
    {
       // We can bypass the accessor function while initializing
@@ -1221,6 +1294,92 @@ BlockFilePtr DirManager::NewBlockFile( const BlockFileFactory &factory )
    return newBlockFile;
 }
 
+namespace {
+   // FNV-1a, a word at a time, over the sample bytes
+   size_t HashSamples( constSamplePtr data, size_t bytes )
+   {
+      const uint64_t prime = 1099511628211ULL;
+      uint64_t hash = 14695981039346656037ULL;
+      size_t ii = 0;
+      for (; ii + sizeof(uint64_t) <= bytes; ii += sizeof(uint64_t)) {
+         uint64_t word;
+         memcpy( &word, data + ii, sizeof(word) );
+         hash = (hash ^ word) * prime;
+      }
+      for (; ii < bytes; ++ii)
+         hash = (hash ^ static_cast<unsigned char>(data[ii])) * prime;
+      return static_cast<size_t>( hash ^ bytes );
+   }
+}
+
+BlockFilePtr DirManager::FindDuplicate(
+   ContentIndex::iterator begin, ContentIndex::iterator end,
+   samplePtr sampleData, size_t sampleLen, sampleFormat format )
+{
+   const auto bytes = sampleLen * SAMPLE_SIZE(format);
+   SampleBuffer buffer;
+   for (auto iter = begin; iter != end; ++iter) {
+      auto &entry = iter->second;
+      if (entry.format != format || entry.len != sampleLen)
+         continue;
+      auto block = entry.block.lock();
+      // A locked block belongs to a saved copy of the project, and
+      // CopyBlockFile would not share it either
+      if (!block || block->IsLocked())
+         continue;
+      // The hash only narrows the search; compare the samples themselves
+      if (!buffer.ptr())
+         buffer.Allocate( sampleLen, format );
+      if (block->ReadData( buffer.ptr(), format, 0, sampleLen, false )
+            == sampleLen &&
+          0 == memcmp( buffer.ptr(), sampleData, bytes ))
+         return block;
+   }
+   return {};
+}
+
+BlockFilePtr DirManager::NewSimpleBlockFile(
+   samplePtr sampleData, size_t sampleLen, sampleFormat format,
+   bool allowDeferredWrite)
+{
+   const auto factory = [&]( wxFileNameWrapper filePath ) -> BlockFilePtr {
+      if (mCompressBlocks && !allowDeferredWrite)
+         return make_blockfile<CompressedBlockFile>(
+            std::move(filePath), sampleData, sampleLen, format);
+      return make_blockfile<SimpleBlockFile>(
+         std::move(filePath), sampleData, sampleLen, format,
+         allowDeferredWrite);
+   };
+
+   // Recording makes blocks on the audio thread, which must neither read
+   // other blocks nor touch the unguarded index; and the recovery log
+   // understands only SimpleBlockFiles, which sharing could violate
+   if (!mDeduplicate || allowDeferredWrite)
+      return NewBlockFile( factory );
+
+   const auto hash =
+      HashSamples( sampleData, sampleLen * SAMPLE_SIZE(format) );
+   auto range = mContentIndex.equal_range( hash );
+   if (auto block =
+       FindDuplicate( range.first, range.second, sampleData, sampleLen, format ))
+      return block;
+
+   // Drop entries for destroyed blocks now and then, so that the index does
+   // not outgrow the blocks that are alive
+   if (mContentIndex.size() >= mContentIndexSweepSize) {
+      for (auto iter = mContentIndex.begin(); iter != mContentIndex.end();)
+         if (iter->second.block.expired())
+            iter = mContentIndex.erase( iter );
+         else
+            ++iter;
+      mContentIndexSweepSize = std::max<size_t>( 1024, 2 * mContentIndex.size() );
+   }
+
+   auto block = NewBlockFile( factory );
+   mContentIndex.emplace( hash, ContentEntry{ format, sampleLen, block } );
+   return block;
+}
+
 bool DirManager::ContainsBlockFile(const BlockFile *b) const
 {
    if (!b)
@@ -1284,7 +1443,10 @@ BlockFilePtr DirManager::CopyBlockFile(const BlockFilePtr &b)
       //a summary file, so we should check before we copy.
       if(b->IsSummaryAvailable())
       {
-         if( !FileNames::CopyFile(fn.GetFullPath(),
+         // A reflink where the file system permits, so that duplicating
+         // tracks of a saved project costs no disk space until either
+         // copy is modified
+         if( !FileNames::CloneOrCopyFile(fn.GetFullPath(),
                   newFile.GetFullPath()) )
             // Disk space exhaustion, maybe
             throw FileException{
@@ -1422,9 +1584,12 @@ std::pair<bool, FilePath> DirManager::LinkOrCopyToNewProjectDirectory(
          bool success = false;
          if (link)
             success = FileNames::HardLinkFile( oldPath, newPath );
+         // Block files are not rewritten in place, but a hard link is still
+         // used only when moving; a copy-on-write clone keeps Save As copies
+         // independent of the old project while sharing storage with it
          if (!success)
              link = false,
-             success = FileNames::CopyFile( oldPath, newPath );
+             success = FileNames::CloneOrCopyFile( oldPath, newPath );
          if (!success)
             return { false, {} };
       }
@@ -1455,7 +1620,7 @@ std::pair<bool, FilePath> DirManager::LinkOrCopyToNewProjectDirectory(
          //if it doesn't, we can assume it was written to the NEW name, which is fine.
          if (oldFileName.FileExists())
          {
-            bool ok = FileNames::CopyFile(oldPath, newPath);
+            bool ok = FileNames::CloneOrCopyFile(oldPath, newPath);
             if (!ok)
                return { false, {} };
          }
@@ -1586,10 +1751,30 @@ bool DirManager::EnsureSafeFilename(const wxFileName &fName)
    return true;
 }
 
+// Whether the file exists (and, optionally, is not empty), according to the
+// index if it has the file at the same path, else asking the disk
+static bool IndexedFileExists( const DirManager::DiskFileIndex *pIndex,
+   const wxFileName &fileName, bool nonEmpty )
+{
+   const auto path = fileName.GetFullPath();
+   if (pIndex) {
+      auto iter = pIndex->find( fileName.GetFullName() );
+      if (iter != pIndex->end() && iter->second.path == path &&
+          (!nonEmpty || iter->second.size != wxInvalidSize))
+         return !nonEmpty || iter->second.size != 0;
+   }
+   return fileName.FileExists() &&
+      (!nonEmpty || wxFile{ path }.Length() != 0);
+}
+
 void DirManager::FindMissingAliasFiles(
       BlockHash& missingAliasFilesAUFHash,     // output: (.auf) AliasBlockFiles whose aliased files are missing
       BlockHash& missingAliasFilesPathHash)    // output: full paths of missing aliased files
 {
+   // Many blocks alias few files; test each of those once, in parallel
+   struct Alias { wxString key; BlockFilePtr b; size_t iPath; };
+   std::vector< Alias > aliases;
+   std::unordered_map< wxString, size_t > aliasedPaths; // to index in paths
    BlockHash::iterator iter = mBlockFileHash.begin();
    while (iter != mBlockFileHash.end())
    {
@@ -1602,21 +1787,37 @@ void DirManager::FindMissingAliasFiles(
             static_cast< AliasBlockFile* > ( &*b )->GetAliasedFileName();
             wxString aliasedFileFullPath = aliasedFileName.GetFullPath();
             // wxEmptyString can happen if user already chose to "replace... with silence".
-            if ((!aliasedFileFullPath.empty()) &&
-                !aliasedFileName.FileExists())
+            if (!aliasedFileFullPath.empty())
             {
-               missingAliasFilesAUFHash[key] = b;
-               if (missingAliasFilesPathHash.find(aliasedFileFullPath) ==
-                   missingAliasFilesPathHash.end()) // Add it only once.
-                  // Not actually using the block here, just the path,
-                  // so set the block to NULL to create the entry.
-                  missingAliasFilesPathHash[aliasedFileFullPath] = {};
+               auto iPath = aliasedPaths.emplace(
+                  aliasedFileFullPath, aliasedPaths.size()).first->second;
+               aliases.push_back({ key, b, iPath });
             }
          }
       }
       ++iter;
    }
 
+   std::vector< wxString > paths( aliasedPaths.size() );
+   for (const auto &pair : aliasedPaths)
+      paths[pair.second] = pair.first;
+   std::vector< char > exists( paths.size() );
+   ParallelFor( paths.size(),
+      [&]( size_t ii ){ exists[ii] = wxFileName::FileExists( paths[ii] ); } );
+
+   for (const auto &alias : aliases) {
+      const auto &aliasedFileFullPath = paths[alias.iPath];
+      if (!exists[alias.iPath])
+      {
+         missingAliasFilesAUFHash[alias.key] = alias.b;
+         if (missingAliasFilesPathHash.find(aliasedFileFullPath) ==
+             missingAliasFilesPathHash.end()) // Add it only once.
+            // Not actually using the block here, just the path,
+            // so set the block to NULL to create the entry.
+            missingAliasFilesPathHash[aliasedFileFullPath] = {};
+      }
+   }
+
    iter = missingAliasFilesPathHash.begin();
    while (iter != missingAliasFilesPathHash.end())
    {
@@ -1626,7 +1827,8 @@ void DirManager::FindMissingAliasFiles(
 }
 
 void DirManager::FindMissingAUFs(
-      BlockHash& missingAUFHash)                // output: missing (.auf) AliasBlockFiles
+      BlockHash& missingAUFHash,                // output: missing (.auf) AliasBlockFiles
+      const DiskFileIndex *pIndex)
 {
    BlockHash::iterator iter = mBlockFileHash.begin();
    while (iter != mBlockFileHash.end())
@@ -1641,7 +1843,7 @@ void DirManager::FindMissingAUFs(
             wxFileNameWrapper fileName{ MakeBlockFilePath(key) };
             fileName.SetName(key);
             fileName.SetExt(wxT("auf"));
-            if (!fileName.FileExists())
+            if (!IndexedFileExists(pIndex, fileName, false))
             {
                missingAUFHash[key] = b;
                wxLogWarning(_("Missing alias (.auf) block file: '%s'"),
@@ -1654,7 +1856,8 @@ void DirManager::FindMissingAUFs(
 }
 
 void DirManager::FindMissingAUs(
-      BlockHash& missingAUHash)                 // missing data (.au) blockfiles
+      BlockHash& missingAUHash,                 // missing data (.au) blockfiles
+      const DiskFileIndex *pIndex)
 {
    BlockHash::iterator iter = mBlockFileHash.begin();
    while (iter != mBlockFileHash.end())
@@ -1670,8 +1873,7 @@ void DirManager::FindMissingAUs(
             fileName.SetName(key);
             fileName.SetExt(wxT("au"));
             const auto path = fileName.GetFullPath();
-            if (!fileName.FileExists() ||
-                wxFile{ path }.Length() == 0)
+            if (!IndexedFileExists(pIndex, fileName, true))
             {
                missingAUHash[key] = b;
                wxLogWarning(_("Missing data block file: '%s'"), path);
@@ -1724,13 +1926,12 @@ void DirManager::FindOrphanBlockFiles(
 void DirManager::RemoveOrphanBlockfiles()
 {
    FilePaths filePathArray; // *all* files in the project directory/subdirectories
+   DiskFileIndex index;
    auto dirPath = (!projFull.empty() ? projFull : mytemp);
-   RecursivelyEnumerateWithProgress(
+   EnumerateDataFiles(
       dirPath,
       filePathArray,          // output: all files in project directory tree
-      wxEmptyString,          // All dirs
-      wxEmptyString,          // All files
-      true, false,
+      index,
       mBlockFileHash.size(),  // rough guess of how many BlockFiles will be found/processed, for progress
       XO("Inspecting project file data"));
 
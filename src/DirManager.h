@@ -72,6 +72,22 @@ class PROFILE_DLL_API DirManager final
                                                 int progress_count,
                                                 const TranslatableString &message);
 
+   // Files found on disk by EnumerateDataFiles, by name and extension
+   struct DiskFile {
+      FilePath path;
+      wxULongLong size; // known only for .au files
+   };
+   using DiskFileIndex = std::unordered_map< wxString, DiskFile >;
+
+   // Like RecursivelyEnumerateWithProgress for all files under dirPath, but
+   // the subdirectories are walked by several threads, which also find the
+   // sizes of .au files for the index
+   static int EnumerateDataFiles(const FilePath &dirPath,
+                                 FilePaths& filePathArray, // output: all files in dirPath tree
+                                 DiskFileIndex &index,     // output
+                                 int progress_count,
+                                 const TranslatableString &message);
+
    static int RecursivelyCountSubdirs( const FilePath &dirPath );
 
    static int RecursivelyRemoveEmptyDirs(const FilePath &dirPath,
@@ -142,6 +158,18 @@ class PROFILE_DLL_API DirManager final
    using BlockFileFactory = std::function< BlockFilePtr( wxFileNameWrapper ) >;
    BlockFilePtr NewBlockFile( const BlockFileFactory &factory );
 
+   // Makes a SimpleBlockFile as NewBlockFile would, but if an unlocked block
+   // already made this way holds the same samples, shares that one instead
+   // (unless deduplication is turned off in preferences)
+   BlockFilePtr NewSimpleBlockFile(
+      samplePtr sampleData, size_t sampleLen, sampleFormat format,
+      bool allowDeferredWrite = false);
+
+   // Whether NewSimpleBlockFile makes CompressedBlockFiles, except for
+   // deferred writes; initially as in preferences, then as the project says
+   bool GetCompressBlocks() const { return mCompressBlocks; }
+   void SetCompressBlocks(bool compress) { mCompressBlocks = compress; }
+
    /// Returns true if the blockfile pointed to by b is contained by the DirManager
    bool ContainsBlockFile(const BlockFile *b) const;
    /// Check for existing using filename using complete filename
@@ -199,10 +227,13 @@ class PROFILE_DLL_API DirManager final
    void FindMissingAliasFiles(
          BlockHash& missingAliasFilesAUFHash,     // output: (.auf) AliasBlockFiles whose aliased files are missing
          BlockHash& missingAliasFilesPathHash);   // output: full paths of missing aliased files
+   // These two consult the index, if given, before testing files on disk
    void FindMissingAUFs(
-         BlockHash& missingAUFHash);               // output: missing (.auf) AliasBlockFiles
+         BlockHash& missingAUFHash,                // output: missing (.auf) AliasBlockFiles
+         const DiskFileIndex *pIndex = nullptr);
    void FindMissingAUs(
-         BlockHash& missingAUHash);                // missing data (.au) blockfiles
+         BlockHash& missingAUHash,                 // missing data (.au) blockfiles
+         const DiskFileIndex *pIndex = nullptr);
    // Find .au and .auf files that are not in the project.
    void FindOrphanBlockFiles(
          const FilePaths &filePathArray,       // input: all files in project directory
@@ -241,6 +272,23 @@ class PROFILE_DLL_API DirManager final
 
    BlockHash mBlockFileHash; // repository for blockfiles
 
+   // Blocks made by NewSimpleBlockFile, indexed by a hash of their samples
+   struct ContentEntry
+   {
+      sampleFormat format;
+      size_t len;
+      std::weak_ptr<BlockFile> block;
+   };
+   using ContentIndex = std::unordered_multimap< size_t, ContentEntry >;
+   ContentIndex mContentIndex;
+   size_t mContentIndexSweepSize{ 1024 };
+   bool mDeduplicate{ true };
+   bool mCompressBlocks{ false };
+
+   BlockFilePtr FindDuplicate( ContentIndex::iterator begin,
+      ContentIndex::iterator end,
+      samplePtr sampleData, size_t sampleLen, sampleFormat format );
+
    // Hashes for management of the sub-directory tree of _data
    struct BalanceInfo
    {
@@ -33,6 +33,12 @@ a draggable point type.
 
 #include <math.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+   (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENVELOPE_SSE2
+#include <emmintrin.h>
+#endif
+
 #include <wx/wxcrtvararg.h>
 #include <wx/brush.h>
 #include <wx/pen.h>
@@ -1047,6 +1053,191 @@ void Envelope::GetValuesRelative
    }
 }
 
+void Envelope::GetSegments(EnvelopeSegments &segments,
+                           size_t len, double t0, double tstep) const
+{
+   // Convert t0 from absolute to clip-relative time
+   t0 -= mOffset;
+   GetSegmentsRelative(segments, len, t0, tstep);
+}
+
+// Follows GetValuesRelative() (without the left limit option), but finds
+// each run of samples that share one interpolation once, instead of
+// evaluating every sample
+void Envelope::GetSegmentsRelative(EnvelopeSegments &segments,
+                                   size_t bufferLen, double t0, double tstep)
+   const
+{
+   segments.clear();
+
+   auto addConstant = [&](size_t start, size_t count, double value) {
+      if (!segments.empty()) {
+         auto &last = segments.back();
+         if (!last.exponential && last.step == 0.0 && last.value == value) {
+            last.len += count;
+            return;
+         }
+      }
+      segments.push_back({ start, count, value, 0.0, false });
+   };
+
+   const int len = mEnv.size();
+   if (len <= 0) {
+      if (bufferLen > 0)
+         addConstant(0, bufferLen, mDefaultValue);
+      return;
+   }
+
+   const auto epsilon = tstep / 2;
+   const double tfirst = mEnv[0].GetT();
+   const double tlast = mEnv[len - 1].GetT();
+
+   double t = t0;
+   double increment = 0;
+   if ( len > 1 && t <= tfirst && tfirst == mEnv[1].GetT() )
+      increment = epsilon;
+
+   size_t b = 0;
+   while (b < bufferLen) {
+      const auto start = b;
+      const auto tplus = t + increment;
+
+      // IF before envelope THEN first value
+      if (tplus < tfirst) {
+         do {
+            ++b;
+            t += tstep;
+         } while (b < bufferLen && t + increment < tfirst);
+         addConstant(start, b - start, mEnv[0].GetVal());
+         continue;
+      }
+
+      // IF after envelope THEN last value, for all the rest
+      if (tplus >= tlast) {
+         addConstant(start, bufferLen - start, mEnv[len - 1].GetVal());
+         break;
+      }
+
+      int lo, hi;
+      BinarySearchForTime( lo, hi, tplus );
+      wxASSERT( lo >= 0 && hi <= len - 1 );
+
+      const double tprev = mEnv[lo].GetT();
+      const double tnext = mEnv[hi].GetT();
+
+      // See GetValuesRelative() about discontinuities
+      if ( hi + 1 < len && tnext == mEnv[ hi + 1 ].GetT() )
+         increment = epsilon;
+      else
+         increment = 0;
+
+      const double vprev = GetInterpolationStartValueAtPoint( lo );
+      const double vnext = GetInterpolationStartValueAtPoint( hi );
+
+      const double dt = tnext - tprev;
+      const double to = t - tprev;
+      double v, vstep;
+      if (dt > 0.0) {
+         v = (vprev * (dt - to) + vnext * to) / dt;
+         vstep = (vnext - vprev) * tstep / dt;
+      }
+      else {
+         v = vnext;
+         vstep = 0.0;
+      }
+
+      do {
+         ++b;
+         t += tstep;
+      } while (b < bufferLen && t + increment < tnext);
+
+      if (mDB)
+         v = pow(10.0, v);
+      if (vstep == 0.0)
+         addConstant(start, b - start, v);
+      else if (mDB)
+         segments.push_back({ start, b - start, v, pow(10.0, vstep), true });
+      else
+         segments.push_back({ start, b - start, v, vstep, false });
+   }
+}
+
+bool Envelope::IsConstant(double &value) const
+{
+   if (mEnv.empty()) {
+      value = mDefaultValue;
+      return true;
+   }
+
+   value = mEnv[0].GetVal();
+   for (const auto &point : mEnv)
+      if (point.GetVal() != value)
+         return false;
+   return true;
+}
+
+void Envelope::ApplyGain(float *buffer, size_t len, float gain)
+{
+   size_t i = 0;
+#ifdef ENVELOPE_SSE2
+   const __m128 g = _mm_set1_ps(gain);
+   for (; i + 4 <= len; i += 4)
+      _mm_storeu_ps(buffer + i, _mm_mul_ps(_mm_loadu_ps(buffer + i), g));
+#endif
+   for (; i < len; ++i)
+      buffer[i] *= gain;
+}
+
+void Envelope::ApplySegments(float *buffer, const EnvelopeSegments &segments)
+{
+   for (const auto &segment : segments) {
+      const auto samples = buffer + segment.start;
+      const auto len = segment.len;
+      const auto step = segment.step;
+
+      if (!segment.exponential && step == 0.0) {
+         if (segment.value != 1.0)
+            ApplyGain(samples, len, segment.value);
+         continue;
+      }
+
+      size_t i = 0;
+      if (segment.exponential) {
+         // Carry the gain in double precision, so that long ramps do not
+         // drift from the values GetValues() would give
+         double gain = segment.value;
+#ifdef ENVELOPE_SSE2
+         const double step2 = step * step;
+         const __m128 ratios = _mm_set_ps(step2 * step, step2, step, 1.0f);
+         const double step4 = step2 * step2;
+         for (; i + 4 <= len; i += 4) {
+            const __m128 g = _mm_mul_ps(_mm_set1_ps(gain), ratios);
+            _mm_storeu_ps(samples + i,
+               _mm_mul_ps(_mm_loadu_ps(samples + i), g));
+            gain *= step4;
+         }
+#endif
+         for (; i < len; ++i) {
+            samples[i] *= gain;
+            gain *= step;
+         }
+      }
+      else {
+#ifdef ENVELOPE_SSE2
+         const __m128 offsets = _mm_set_ps(3 * step, 2 * step, step, 0.0f);
+         for (; i + 4 <= len; i += 4) {
+            const __m128 g =
+               _mm_add_ps(_mm_set1_ps(segment.value + step * i), offsets);
+            _mm_storeu_ps(samples + i,
+               _mm_mul_ps(_mm_loadu_ps(samples + i), g));
+         }
+#endif
+         for (; i < len; ++i)
+            samples[i] *= segment.value + step * i;
+      }
+   }
+}
+
 // relative time
 int Envelope::NumberOfPointsAfter(double t) const
 {
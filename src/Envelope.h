@@ -69,6 +69,18 @@ private:
 typedef std::vector<EnvPoint> EnvArray;
 struct TrackPanelDrawingContext;
 
+/// A run of consecutive samples over which an envelope is constant,
+/// linear, or exponential.  Constant runs have step zero and are not
+/// exponential.
+struct EnvelopeSegment {
+   size_t start;     // offset of the first sample in the buffer
+   size_t len;
+   double value;     // value at the first sample
+   double step;      // per-sample increment, or ratio if exponential
+   bool exponential;
+};
+typedef std::vector<EnvelopeSegment> EnvelopeSegments;
+
 class Envelope /* not final */ : public XMLTagHandler {
 public:
    // Envelope can define a piecewise linear function, or piecewise exponential.
@@ -151,6 +163,21 @@ public:
     * more than one value in a row. */
    void GetValues(double *buffer, int len, double t0, double tstep) const;
 
+   /** \brief Describe the same values as GetValues() as a short list of
+    * constant, linear, or exponential runs. */
+   void GetSegments(EnvelopeSegments &segments,
+                    size_t len, double t0, double tstep) const;
+
+   /** \brief Return true, and the value, if the envelope has the same value
+    * everywhere. */
+   bool IsConstant(double &value) const;
+
+   /** \brief Multiply samples by the envelope runs from GetSegments() */
+   static void ApplySegments(float *buffer, const EnvelopeSegments &segments);
+
+   /** \brief Multiply samples by a constant gain */
+   static void ApplyGain(float *buffer, size_t len, float gain);
+
    // Guarantee an envelope point at the end of the domain.
    void Cap( double sampleDur );
 
@@ -165,6 +192,8 @@ private:
    void GetValuesRelative
       (double *buffer, int len, double t0, double tstep, bool leftLimit = false)
       const;
+   void GetSegmentsRelative(EnvelopeSegments &segments,
+                            size_t len, double t0, double tstep) const;
    // relative time
    int NumberOfPointsAfter(double t) const;
    // relative time
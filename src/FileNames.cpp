@@ -47,6 +47,20 @@ used throughout Audacity into this one place.
 #include <windows.h>
 #endif
 
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <linux/fs.h>
+#endif
+
+#if defined(__APPLE__) && defined(__has_include)
+#if __has_include(<sys/clonefile.h>)
+#include <sys/clonefile.h>
+#define HAVE_CLONEFILE
+#endif
+#endif
+
 static wxString gDataDir;
 
 const FileNames::FileType
@@ -186,6 +200,41 @@ bool FileNames::HardLinkFile( const FilePath& file1, const FilePath& file2 )
 #endif
 }
 
+bool FileNames::CloneFile( const FilePath& file1, const FilePath& file2 )
+{
+#if defined(HAVE_CLONEFILE)
+
+   // APFS
+   return 0 == ::clonefile( file1.c_str(), file2.c_str(), 0 );
+
+#elif defined(__linux__) && defined(FICLONE)
+
+   // btrfs, XFS with reflink=1, and others sharing extents
+   int src = ::open( file1.c_str(), O_RDONLY );
+   if ( src < 0 )
+      return false;
+   bool existed = wxFileExists(file2);
+   int dst = ::open( file2.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666 );
+   bool result = dst >= 0 && 0 == ::ioctl( dst, FICLONE, src );
+   if ( dst >= 0 )
+      ::close( dst );
+   ::close( src );
+   if ( !result && dst >= 0 && !existed )
+      ::unlink( file2.c_str() );
+   return result;
+
+#else
+
+   return false;
+
+#endif
+}
+
+bool FileNames::CloneOrCopyFile( const FilePath& file1, const FilePath& file2 )
+{
+   return CloneFile( file1, file2 ) || CopyFile( file1, file2 );
+}
+
 wxString FileNames::MkDir(const wxString &Str)
 {
    // Behaviour of wxFileName::DirExists() and wxFileName::MkDir() has
@@ -63,6 +63,14 @@ namespace FileNames
    // storage devices.
    bool HardLinkFile( const FilePath& file1, const FilePath& file2);
 
+   // Make a copy-on-write clone (reflink) of file1 if the file system
+   // supports it, so that the copy shares storage until either is modified.
+   // Returns false, without copying, if that is not possible.
+   bool CloneFile( const FilePath& file1, const FilePath& file2);
+
+   // CloneFile, falling back to CopyFile
+   bool CloneOrCopyFile( const FilePath& file1, const FilePath& file2);
+
    wxString MkDir(const wxString &Str);
    wxString TempDir();
 
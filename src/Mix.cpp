@@ -327,8 +327,6 @@ Mixer::Mixer(const WaveTrackConstArray &inputTracks,
 
    MakeResamplers();
 
-   const auto envLen = std::max(mQueueMaxLen, mInterleavedBufferSize);
-   mEnvValues.reinit(envLen);
 }
 
 Mixer::~Mixer()
@@ -458,9 +456,9 @@ size_t Mixer::MixVariableRates(int *channelFlags, WaveTrackCache &cache,
                else
                   memset(&queue[*queueLen], 0, sizeof(float) * getLen);
 
-               track->GetEnvelopeValues(mEnvValues.get(),
-                                        getLen,
-                                        (*pos - (getLen- 1)).as_double() / trackRate);
+               track->ApplyEnvelope(&queue[*queueLen],
+                                    getLen,
+                                    (*pos - (getLen- 1)).as_double() / trackRate);
                *pos -= getLen;
             }
             else {
@@ -470,17 +468,13 @@ size_t Mixer::MixVariableRates(int *channelFlags, WaveTrackCache &cache,
                else
                   memset(&queue[*queueLen], 0, sizeof(float) * getLen);
 
-               track->GetEnvelopeValues(mEnvValues.get(),
-                                        getLen,
-                                        (*pos).as_double() / trackRate);
+               track->ApplyEnvelope(&queue[*queueLen],
+                                    getLen,
+                                    (*pos).as_double() / trackRate);
 
                *pos += getLen;
             }
 
-            for (decltype(getLen) i = 0; i < getLen; i++) {
-               queue[(*queueLen) + i] *= mEnvValues[i];
-            }
-
             if (backwards)
                ReverseSamples((samplePtr)&queue[0], floatSample,
                               *queueLen, getLen);
@@ -579,9 +573,7 @@ size_t Mixer::MixSameRate(int *channelFlags, WaveTrackCache &cache,
          memcpy(mFloatBuffer.get(), results, sizeof(float) * slen);
       else
          memset(mFloatBuffer.get(), 0, sizeof(float) * slen);
-      track->GetEnvelopeValues(mEnvValues.get(), slen, t - (slen - 1) / mRate);
-      for(decltype(slen) i = 0; i < slen; i++)
-         mFloatBuffer[i] *= mEnvValues[i]; // Track gain control will go here?
+      track->ApplyEnvelope(mFloatBuffer.get(), slen, t - (slen - 1) / mRate);
       ReverseSamples((samplePtr)mFloatBuffer.get(), floatSample, 0, slen);
 
       *pos -= slen;
@@ -592,9 +584,7 @@ size_t Mixer::MixSameRate(int *channelFlags, WaveTrackCache &cache,
          memcpy(mFloatBuffer.get(), results, sizeof(float) * slen);
       else
          memset(mFloatBuffer.get(), 0, sizeof(float) * slen);
-      track->GetEnvelopeValues(mEnvValues.get(), slen, t);
-      for(decltype(slen) i = 0; i < slen; i++)
-         mFloatBuffer[i] *= mEnvValues[i]; // Track gain control will go here?
+      track->ApplyEnvelope(mFloatBuffer.get(), slen, t);
 
       *pos += slen;
    }
@@ -169,7 +169,6 @@ class AUDACITY_DLL_API Mixer {
    const BoundedEnvelope *mEnvelope;
    ArrayOf<sampleCount> mSamplePos;
    bool             mApplyTrackGains;
-   Doubles          mEnvValues;
    double           mT0; // Start time
    double           mT1; // Stop time (none if mT0==mT1)
    double           mTime;  // Current time (renamed from mT to mTime for consistency with AudioIO - mT represented warped time there)
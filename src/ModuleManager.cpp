@@ -571,20 +571,32 @@ void ModuleManager::FindAllPlugins(PluginIDs & providers, PluginPaths & paths)
    }
 }
 
-PluginPaths ModuleManager::FindPluginsForProvider(const PluginID & providerID,
-                                                    const PluginPath & path)
+ModuleInterface *ModuleManager::GetProvider(const PluginID & providerID,
+                                           const PluginPath & path)
 {
    // Instantiate if it hasn't already been done
    if (mDynModules.find(providerID) == mDynModules.end())
    {
-      // If it couldn't be created, just give up and return an empty list
       if (!CreateProviderInstance(providerID, path))
       {
-         return {};
+         return NULL;
       }
    }
 
-   return mDynModules[providerID]->FindPluginPaths(PluginManager::Get());
+   return mDynModules[providerID].get();
+}
+
+PluginPaths ModuleManager::FindPluginsForProvider(const PluginID & providerID,
+                                                    const PluginPath & path)
+{
+   // If it couldn't be created, just give up and return an empty list
+   auto module = GetProvider(providerID, path);
+   if (!module)
+   {
+      return {};
+   }
+
+   return module->FindPluginPaths(PluginManager::Get());
 }
 
 bool ModuleManager::RegisterEffectPlugin(const PluginID & providerID, const PluginPath & path, TranslatableString &errMsg)
@@ -600,6 +612,16 @@ bool ModuleManager::RegisterEffectPlugin(const PluginID & providerID, const Plug
    return nFound > 0;
 }
 
+void ModuleManager::PrepareToRegisterEffectPlugins(const PluginID & providerID, const PluginPaths & paths)
+{
+   if (mDynModules.find(providerID) == mDynModules.end())
+   {
+      return;
+   }
+
+   mDynModules[providerID]->PrepareToDiscoverPluginsAtPaths(paths);
+}
+
 ModuleInterface *ModuleManager::CreateProviderInstance(const PluginID & providerID,
                                                       const PluginPath & path)
 {
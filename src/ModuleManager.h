@@ -99,9 +99,15 @@ public:
    // Seems we don't currently use FindAllPlugins
    void FindAllPlugins(PluginIDs & providers, PluginPaths & paths);
 
+   // Instantiates the provider if that hasn't already been done
+   ModuleInterface *GetProvider(const PluginID & provider, const PluginPath & path);
    PluginPaths FindPluginsForProvider(const PluginID & provider, const PluginPath & path);
    bool RegisterEffectPlugin(const PluginID & provider, const PluginPath & path,
                        TranslatableString &errMsg);
+   // Give the provider a chance to examine all these paths at once, before
+   // RegisterEffectPlugin() is called for each
+   void PrepareToRegisterEffectPlugins(const PluginID & provider,
+                       const PluginPaths & paths);
 
    ModuleInterface *CreateProviderInstance(const PluginID & provider, const PluginPath & path);
    ComponentInterface *CreateInstance(const PluginID & provider, const PluginPath & path);
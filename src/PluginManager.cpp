@@ -27,12 +27,16 @@ for shared and private configs - which need to move out.
 
 #include <wx/setup.h> // for wxUSE_* macros
 #include <wx/defs.h>
+#include <wx/app.h>
 #include <wx/dialog.h>
 #include <wx/dir.h>
 #include <wx/dynlib.h>
+#include <wx/fileconf.h>
 #include <wx/filename.h>
 #include <wx/listctrl.h>
 #include <wx/log.h>
+#include <wx/process.h>
+#include <wx/progdlg.h>
 #include <wx/radiobut.h>
 #include <wx/string.h>
 #include <wx/tokenzr.h>
@@ -50,6 +54,7 @@ for shared and private configs - which need to move out.
 #include "widgets/AudacityMessageBox.h"
 #include "widgets/ProgressDialog.h"
 
+#include <thread>
 #include <unordered_map>
 
 // ============================================================================
@@ -987,6 +992,23 @@ void PluginRegistrationDialog::OnOK(wxCommandEvent & WXUNUSED(evt))
 
    auto msg = XO("Enabling effects or commands:\n\n%s").Format( last3 );
 
+   // Let each provider look at all its new paths at once, which may be much
+   // faster than one at a time
+   {
+      std::map< PluginID, PluginPaths > pathsByProvider;
+      for (ItemDataMap::iterator iter = mItems.begin(); iter != mItems.end(); ++iter)
+      {
+         ItemData & item = iter->second;
+         if (item.state == STATE_Enabled && item.plugs[0]->GetPluginType() == PluginTypeStub)
+         {
+            for (size_t j = 0, cntj = item.plugs.size(); j < cntj; j++)
+               pathsByProvider[item.plugs[j]->GetProviderID()].push_back(item.path);
+         }
+      }
+      for (const auto &pair : pathsByProvider)
+         mm.PrepareToRegisterEffectPlugins(pair.first, pair.second);
+   }
+
    // Make sure the progress dialog is deleted before we call EndModal() or
    // we will leave the project window in an unusable state on OSX.
    // See bug #1192.
@@ -1771,9 +1793,12 @@ void PluginManager::Initialize()
    // Then look for providers (they may autoregister plugins)
    ModuleManager::Get().DiscoverProviders();
 
-   // And finally check for updates
+   // And finally check for updates.  Searching for NEW plug-ins is left
+   // for later (see AudacityApp::OnInit and ShowManager), as it can take
+   // much longer than loading everything else.
 #ifndef EXPERIMENTAL_EFFECT_MANAGEMENT
-   CheckForUpdates();
+   const bool kFindNew = false;
+   CheckForUpdates( false, kFindNew );
 #else
    const bool kFast = true;
    CheckForUpdates( kFast );
@@ -1782,6 +1807,8 @@ void PluginManager::Initialize()
 
 void PluginManager::Terminate()
 {
+   StopFinder();
+
    // Get rid of all non-module plugins first
    PluginMap::iterator iter = mPlugins.begin();
    while (iter != mPlugins.end())
@@ -2370,24 +2397,12 @@ void PluginManager::SaveGroup(wxFileConfig *pRegistry, PluginType type)
 // If bFast is true, do not do a full check.  Just check the ones
 // that are quick to check.  Currently (Feb 2017) just Nyquist
 // and built-ins.
-void PluginManager::CheckForUpdates(bool bFast)
+void PluginManager::CheckForUpdates(bool bFast, bool bFindNew)
 {
    // Get ModuleManager reference
    ModuleManager & mm = ModuleManager::Get();
 
-   wxArrayString pathIndex;
-   for (PluginMap::iterator iter = mPlugins.begin(); iter != mPlugins.end(); ++iter)
-   {
-      PluginDescriptor & plug = iter->second;
-
-      // Bypass 2.1.0 placeholders...remove this after a few releases past 2.1.0
-      if (plug.GetPluginType() == PluginTypeNone)
-      {
-         continue;
-      }
-
-      pathIndex.push_back(plug.GetPath().BeforeFirst(wxT(';')));
-   }
+   const auto pathIndex = GetKnownPaths();
 
    // Check all known plugins to ensure they are still valid and scan for NEW ones.
    // 
@@ -2424,25 +2439,10 @@ void PluginManager::CheckForUpdates(bool bFast)
             plug.SetEnabled(false);
             plug.SetValid(false);
          }
-         else
+         else if (bFindNew)
          {
             // Collect plugin paths
-            auto paths = mm.FindPluginsForProvider(plugID, plugPath);
-            for (size_t i = 0, cnt = paths.size(); i < cnt; i++)
-            {
-               wxString path = paths[i].BeforeFirst(wxT(';'));;
-               if ( ! make_iterator_range( pathIndex ).contains( path ) )
-               {
-                  PluginID ID = plugID + wxT("_") + path;
-                  PluginDescriptor & plug2 = mPlugins[ID];  // This will create a NEW descriptor
-                  plug2.SetPluginType(PluginTypeStub);
-                  plug2.SetID(ID);
-                  plug2.SetProviderID(plugID);
-                  plug2.SetPath(path);
-                  plug2.SetEnabled(false);
-                  plug2.SetValid(false);
-               }
-            }
+            AddStubs(plugID, mm.FindPluginsForProvider(plugID, plugPath), pathIndex);
          }
       }
       else if (plugType != PluginTypeNone && plugType != PluginTypeStub)
@@ -2460,8 +2460,129 @@ void PluginManager::CheckForUpdates(bool bFast)
    return;
 }
 
+wxArrayString PluginManager::GetKnownPaths()
+{
+   wxArrayString pathIndex;
+   for (PluginMap::iterator iter = mPlugins.begin(); iter != mPlugins.end(); ++iter)
+   {
+      PluginDescriptor & plug = iter->second;
+
+      // Bypass 2.1.0 placeholders...remove this after a few releases past 2.1.0
+      if (plug.GetPluginType() == PluginTypeNone)
+      {
+         continue;
+      }
+
+      pathIndex.push_back(plug.GetPath().BeforeFirst(wxT(';')));
+   }
+
+   return pathIndex;
+}
+
+void PluginManager::AddStubs(const PluginID & providerID,
+   const PluginPaths & paths, const wxArrayString & knownPaths)
+{
+   for (size_t i = 0, cnt = paths.size(); i < cnt; i++)
+   {
+      wxString path = paths[i].BeforeFirst(wxT(';'));;
+      if ( ! make_iterator_range( knownPaths ).contains( path ) )
+      {
+         PluginID ID = providerID + wxT("_") + path;
+         PluginDescriptor & plug2 = mPlugins[ID];  // This will create a NEW descriptor
+         plug2.SetPluginType(PluginTypeStub);
+         plug2.SetID(ID);
+         plug2.SetProviderID(providerID);
+         plug2.SetPath(path);
+         plug2.SetEnabled(false);
+         plug2.SetValid(false);
+      }
+   }
+}
+
+// Whether the provider's search is only a walk of directories, which may be
+// done on another thread while the main thread uses the provider.  Others,
+// such as Vamp and LV2, load plug-ins or walk shared state as they search.
+static bool SearchesDirectoriesOnly(ModuleInterface *module)
+{
+   const auto symbol = module->GetSymbol().Internal();
+   return symbol == wxT("VST Effects") ||
+      symbol == wxT("LADSPA Effects") ||
+      symbol == wxT("Nyquist Effects");
+}
+
+void PluginManager::FindNewPluginsInBackground()
+{
+   StopFinder();
+
+   // Providers are instantiated here, on the main thread.  Those whose
+   // search is a walk of directory trees are searched on the worker, and
+   // the others here, because the main thread may use them meanwhile.
+   ModuleManager & mm = ModuleManager::Get();
+   std::vector< std::pair< PluginID, ModuleInterface * > > providers;
+   std::vector< std::pair< PluginID, PluginPaths > > found;
+   for (PluginMap::iterator iter = mPlugins.begin(); iter != mPlugins.end(); ++iter)
+   {
+      PluginDescriptor & plug = iter->second;
+      if (plug.GetPluginType() == PluginTypeModule && plug.IsValid())
+      {
+         auto module = mm.GetProvider(plug.GetID(), plug.GetPath());
+         if (!module)
+            continue;
+         if (SearchesDirectoriesOnly(module))
+            providers.emplace_back(plug.GetID(), module);
+         else
+            found.emplace_back(plug.GetID(), module->FindPluginPaths(*this));
+      }
+   }
+
+   // Add stubs only once the registered plug-ins have all been visited
+   if (!found.empty())
+   {
+      const auto pathIndex = GetKnownPaths();
+      for (const auto &pair : found)
+         AddStubs(pair.first, pair.second, pathIndex);
+      Save();
+   }
+
+   if (providers.empty())
+      return;
+
+   mFinder = std::thread([this, providers]{
+      auto found =
+         std::make_shared< std::vector< std::pair< PluginID, PluginPaths > > >();
+      for (const auto &provider : providers)
+      {
+         if (mStopFinder)
+            return;
+         found->emplace_back(
+            provider.first, provider.second->FindPluginPaths(*this));
+      }
+
+      // Only the result is passed back to the main thread
+      wxTheApp->CallAfter([found]{
+         auto &pm = PluginManager::Get();
+         const auto pathIndex = pm.GetKnownPaths();
+         for (const auto &pair : *found)
+            pm.AddStubs(pair.first, pair.second, pathIndex);
+         pm.Save();
+      });
+   });
+}
+
+void PluginManager::StopFinder()
+{
+   if (mFinder.joinable())
+   {
+      mStopFinder = true;
+      mFinder.join();
+      mStopFinder = false;
+   }
+}
+
 bool PluginManager::ShowManager(wxWindow *parent, EffectType type)
 {
+   // This searches again, so don't let the worker race it
+   StopFinder();
    CheckForUpdates();
 
    PluginRegistrationDialog dlg(parent, type);
@@ -3218,3 +3339,277 @@ TranslatableString ComponentInterface::GetName()
 {
    return GetSymbol().Msgid();
 }
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// PluginScanner
+//
+///////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Seconds allowed to each checking process before it is killed
+constexpr long kScanTimeout = 30L;
+
+class PluginScanProcess final : public wxProcess
+{
+public:
+   PluginScanProcess()
+   {
+      Redirect();
+   }
+
+   void OnTerminate(int WXUNUSED(pid), int WXUNUSED(status)) override
+   {
+      Drain();
+      mActive = false;
+   }
+
+   // Read both pipes, so that neither can fill up and stall the child;
+   // what the plug-in writes to stderr is of no interest
+   void Drain()
+   {
+      char buffer[4096];
+      wxInputStream *s = GetInputStream();
+      while (s && s->CanRead()) {
+         s->Read(buffer, WXSIZEOF(buffer));
+         mOutput.append(buffer, s->LastRead());
+      }
+      s = GetErrorStream();
+      while (s && s->CanRead())
+         s->Read(buffer, WXSIZEOF(buffer));
+   }
+
+   wxString mArgument;
+   std::string mOutput;   // UTF-8, converted only when complete
+   long mPid{ 0 };
+   wxLongLong mStart;
+   bool mActive{ true };
+   bool mKilled{ false };
+};
+
+wxFileConfig &GetScanCache()
+{
+   static wxFileConfig cache(wxEmptyString, wxEmptyString,
+      wxFileName(FileNames::DataDir(), wxT("pluginscancache.cfg")).GetFullPath());
+   return cache;
+}
+
+wxString GetScanCacheTime(const wxString &argument)
+{
+   wxFileName realPath{
+      argument.Contains(wxT(";")) ? argument.BeforeLast(wxT(';')) : argument };
+   if (!realPath.FileExists() && !realPath.DirExists())
+      return {};
+   return realPath.GetModificationTime().GetValue().ToString();
+}
+
+}
+
+struct PluginScanner::Result
+{
+   wxString argument;
+   wxString output;
+   bool ok;
+};
+
+PluginScanner::PluginScanner(const wxString &option, const wxString &prefix)
+   : mOption{ option }
+   , mPrefix{ prefix }
+{
+}
+
+void PluginScanner::Finish(const wxString &output) const
+{
+   // Write it all in one chunk, to prevent output from the plug-in
+   // intermixing with it
+   const wxCharBuffer buf =
+      (output + wxString::Format(wxT("%sdone\n"), mPrefix)).ToUTF8();
+   fwrite(buf, 1, strlen(buf), stdout);
+   fflush(stdout);
+}
+
+// The cache is keyed by a hash, because config keys can't hold arbitrary
+// paths; the argument is stored too, to detect collisions
+wxString PluginScanner::CacheGroup(const wxString &argument) const
+{
+   return wxString::Format(wxT("/ScanCache/%016llx"),
+      (unsigned long long) std::hash<wxString>{}(mOption + wxT(" ") + argument));
+}
+
+bool PluginScanner::ReadCache(const wxString &argument, wxString &output) const
+{
+   auto &cache = GetScanCache();
+   const auto group = CacheGroup(argument);
+   const auto time = GetScanCacheTime(argument);
+
+   wxString cachedOption, cachedArgument, cachedTime;
+   if (time.empty() ||
+       !cache.Read(group + wxT("/Option"), &cachedOption) ||
+       cachedOption != mOption ||
+       !cache.Read(group + wxT("/Argument"), &cachedArgument) ||
+       cachedArgument != argument ||
+       !cache.Read(group + wxT("/Time"), &cachedTime) ||
+       cachedTime != time)
+      return false;
+
+   return cache.Read(group + wxT("/Output"), &output);
+}
+
+void PluginScanner::WriteCache(const wxString &argument, const wxString &output) const
+{
+   auto &cache = GetScanCache();
+   const auto group = CacheGroup(argument);
+
+   // Keep only our own lines, not what the plug-in might have printed
+   wxString lines;
+   wxStringTokenizer tzr(output, wxT("\n"));
+   while (tzr.HasMoreTokens())
+   {
+      wxString line = tzr.GetNextToken();
+      if (line.StartsWith(mPrefix))
+         lines += line.BeforeFirst(wxT('\r')) + wxT("\n");
+   }
+
+   cache.Write(group + wxT("/Option"), mOption);
+   cache.Write(group + wxT("/Argument"), argument);
+   cache.Write(group + wxT("/Time"), GetScanCacheTime(argument));
+   cache.Write(group + wxT("/Output"), lines);
+}
+
+void PluginScanner::ScanInParallel(
+   const wxArrayString &arguments, const TranslatableString &title) const
+{
+   wxArrayString needed;
+   for (const auto &argument : arguments)
+   {
+      wxString output;
+      if (!ReadCache(argument, output))
+         needed.push_back(argument);
+   }
+   if (needed.empty())
+      return;
+
+   Run(needed, title, [this](const Result &result){
+      if (result.ok)
+         WriteCache(result.argument, result.output);
+   });
+   GetScanCache().Flush();
+}
+
+bool PluginScanner::Scan(const wxString &argument, wxString &output) const
+{
+   if (ReadCache(argument, output))
+      return true;
+
+   wxArrayString arguments;
+   arguments.push_back(argument);
+   bool ok = false;
+   Run(arguments, {}, [&](const Result &result){
+      output = result.output;
+      ok = result.ok;
+   });
+   if (ok)
+   {
+      WriteCache(argument, output);
+      GetScanCache().Flush();
+   }
+   return ok;
+}
+
+void PluginScanner::Run(const wxArrayString &arguments,
+   const TranslatableString &title, const ResultCallback &callback) const
+{
+   const auto &cmdpath = PlatformCompatibility::GetExecutablePath();
+
+   const size_t maxRunning = std::max(1u, std::thread::hardware_concurrency());
+   const long timeout = gPrefs->Read(wxT("/Plugins/ScanTimeout"), kScanTimeout);
+   const wxString doneLine = wxString::Format(wxT("%sdone"), mPrefix);
+
+   Optional<wxProgressDialog> progress{};
+   if (arguments.size() > 3)
+   {
+      progress.emplace( title.Translation(),
+            wxString::Format(_("Scanning %d of %d"), 0, (int)arguments.size()),
+            static_cast<int>(arguments.size()),
+            nullptr,
+            wxPD_APP_MODAL |
+               wxPD_AUTO_HIDE |
+               wxPD_CAN_ABORT |
+               wxPD_ELAPSED_TIME |
+               wxPD_REMAINING_TIME );
+      progress->Show();
+   }
+
+   std::vector< std::unique_ptr<PluginScanProcess> > running;
+   size_t next = 0, done = 0;
+   bool cont = true;
+
+   while ((cont && next < arguments.size()) || !running.empty())
+   {
+      // Start more processes, up to the limit
+      while (cont && next < arguments.size() && running.size() < maxRunning)
+      {
+         auto proc = std::make_unique<PluginScanProcess>();
+         proc->mArgument = arguments[next++];
+
+         wxString cmd;
+         cmd.Printf(wxT("\"%s\" %s \"%s\""), cmdpath, mOption, proc->mArgument);
+
+         int flags = wxEXEC_ASYNC | wxEXEC_NODISABLE;
+#if defined(__WXMSW__)
+         flags += wxEXEC_NOHIDE;
+#endif
+         proc->mPid = wxExecute(cmd, flags, proc.get());
+         if (proc->mPid <= 0)
+         {
+            wxLogMessage(_("Plug-in check failed to start for %s\n"), proc->mArgument);
+            callback({ proc->mArgument, {}, false });
+            ++done;
+            continue;
+         }
+         proc->mStart = wxGetLocalTimeMillis();
+         running.push_back(std::move(proc));
+      }
+
+      wxMilliSleep(10);
+      wxTheApp->Yield();
+
+      const auto now = wxGetLocalTimeMillis();
+      for (auto iter = running.begin(); iter != running.end();)
+      {
+         auto &proc = **iter;
+         if (proc.mActive)
+         {
+            proc.Drain();
+
+            if (!proc.mKilled && now - proc.mStart > timeout * 1000)
+            {
+               wxLogMessage(_("Plug-in check timed out for %s\n"), proc.mArgument);
+               proc.mKilled = true;
+               wxProcess::Kill(proc.mPid, wxSIGKILL, wxKILL_CHILDREN);
+            }
+            ++iter;
+            continue;
+         }
+
+         // It finished only if it reached Finish(); a crash while unloading
+         // the plug-in afterwards does not lose its report
+         const wxString output = wxString::FromUTF8(proc.mOutput.c_str());
+         bool complete = false;
+         wxStringTokenizer tzr(output, wxT("\n"));
+         while (!complete && tzr.HasMoreTokens())
+            complete = tzr.GetNextToken().BeforeFirst(wxT('\r')) == doneLine;
+         if (!complete && !proc.mKilled)
+            wxLogMessage(_("Plug-in check failed for %s\n"), proc.mArgument);
+
+         callback({ proc.mArgument, output, complete && !proc.mKilled });
+
+         iter = running.erase(iter);
+         ++done;
+         if (progress)
+            cont = progress->Update(done,
+               wxString::Format(_("Scanning %d of %d"), (int)done, (int)arguments.size()));
+      }
+   }
+}
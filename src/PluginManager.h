@@ -14,7 +14,9 @@
 #include <wx/defs.h>
 
 #include "MemoryX.h"
+#include <atomic>
 #include <map>
+#include <thread>
 
 #include "audacity/EffectInterface.h"
 #include "audacity/ImporterInterface.h"
@@ -258,7 +260,14 @@ public:
    const ComponentInterfaceSymbol & GetSymbol(const PluginID & ID);
    ComponentInterface *GetInstance(const PluginID & ID);
 
-   void CheckForUpdates(bool bFast = false);
+   // bFindNew false validates only the plug-ins already registered, without
+   // asking the providers to search their paths for NEW ones
+   void CheckForUpdates(bool bFast = false, bool bFindNew = true);
+
+   // Search the providers' paths for NEW plug-ins, on a worker thread for
+   // the providers that only walk directories, and add the stubs of those
+   // when it finishes
+   void FindNewPluginsInBackground();
 
    bool ShowManager(wxWindow *parent, EffectType type = EffectTypeNone);
 
@@ -277,6 +286,11 @@ private:
 
    PluginDescriptor & CreatePlugin(const PluginID & id, ComponentInterface *ident, PluginType type);
 
+   wxArrayString GetKnownPaths();
+   void AddStubs(const PluginID & providerID, const PluginPaths & paths,
+                 const wxArrayString & knownPaths);
+   void StopFinder();
+
    wxFileConfig *GetSettings();
 
    bool HasGroup(const RegistryPath & group);
@@ -321,7 +335,58 @@ private:
    PluginMap mPlugins;
    PluginMap::iterator mPluginsIter;
 
+   std::thread mFinder;
+   std::atomic<bool> mStopFinder{ false };
+
    friend class PluginRegistrationDialog;
 };
 
+///////////////////////////////////////////////////////////////////////////////
+//
+// PluginScanner
+//
+// Checks plug-ins in other instances of Audacity, started with a command
+// line option, so that a crash or hang cannot take down the main program.
+// Several such processes may run at once, each with a time limit.  The
+// outputs of those that finish are cached, keyed by the option, the argument
+// and the modification time of the plug-in file, so that unchanged plug-ins
+// are not checked again.
+//
+// The argument is the path of the plug-in file, optionally followed by ';'
+// and more.  Only the output lines that start with the prefix are kept.  A
+// process that is killed, or that ends without calling Finish(), has failed,
+// and its output is not cached.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class PluginScanner
+{
+public:
+   PluginScanner(const wxString &option, const wxString &prefix);
+
+   // For the checking process:  write the output and mark it complete
+   void Finish(const wxString &output) const;
+
+   bool ReadCache(const wxString &argument, wxString &output) const;
+
+   // Check all the plug-ins not yet in the cache, several at once
+   void ScanInParallel(const wxArrayString &arguments,
+                       const TranslatableString &title) const;
+
+   // Get the output for one plug-in, from the cache or else from a new
+   // process; returns false if that process failed
+   bool Scan(const wxString &argument, wxString &output) const;
+
+private:
+   struct Result;
+   using ResultCallback = std::function< void(const Result &) >;
+   void Run(const wxArrayString &arguments, const TranslatableString &title,
+            const ResultCallback &callback) const;
+   void WriteCache(const wxString &argument, const wxString &output) const;
+   wxString CacheGroup(const wxString &argument) const;
+
+   wxString mOption;
+   wxString mPrefix;
+};
+
 #endif /* __AUDACITY_PLUGINMANAGER_H__ */
@@ -32,6 +32,7 @@ Paul Licameli split from ProjectManager.cpp
 #include "TrackPanelAx.h"
 #include "ViewInfo.h"
 #include "WaveTrack.h"
+#include "blockfile/SimpleBlockFile.h"
 #include "toolbars/ToolManager.h"
 #include "prefs/TracksPrefs.h"
 #include "tracks/ui/Scrubbing.h"
@@ -932,11 +933,17 @@ void ProjectAudioManager::OnAudioIONewBlockFiles(
    const auto &autoSaveFileName = projectFileIO.GetAutoSaveFileName();
    if ( !autoSaveFileName.empty() )
    {
-      wxFFile f{ autoSaveFileName, wxT("ab") };
-      if (!f.IsOpened())
-         return; // Keep recording going, there's not much we can do here
-      blockFileLog.Append(f);
-      f.Close();
+      // The log must not name files that the background writer has yet to
+      // write, so append it only when they are on disk
+      auto bytes = blockFileLog.GetBytes();
+      SimpleBlockFile::AfterDeferredWrites(
+         [autoSaveFileName, bytes]{
+            wxFFile f{ autoSaveFileName, wxT("ab") };
+            if (!f.IsOpened())
+               return; // Keep recording going, there's not much we can do here
+            f.Write(bytes.data(), bytes.size());
+            f.Close();
+         } );
    }
 }
 
@@ -71,13 +71,14 @@ int ProjectFSCK(
    }
 
    FilePaths filePathArray; // *all* files in the project directory/subdirectories
+   // The same files by name, so that the checks below need not each ask the
+   // disk about every block file
+   DirManager::DiskFileIndex diskFileIndex;
    auto dirPath = ( dm.GetDataFilesDir() );
-   DirManager::RecursivelyEnumerateWithProgress(
+   DirManager::EnumerateDataFiles(
       dirPath,
       filePathArray,          // output: all files in project directory tree
-      wxEmptyString,          // All dirs
-      wxEmptyString,          // All files
-      true, false,
+      diskFileIndex,
       dm.NumBlockFiles(),  // rough guess of how many BlockFiles will be found/processed, for progress
       XO("Inspecting project file data"));
 
@@ -178,7 +179,7 @@ XO("Project check of \"%s\" folder \
    // Alias summary regeneration must happen after checking missing aliased files.
    //
    BlockHash missingAUFHash;              // missing (.auf) AliasBlockFiles
-   dm.FindMissingAUFs(missingAUFHash);
+   dm.FindMissingAUFs(missingAUFHash, &diskFileIndex);
    if ((nResult != FSCKstatus_CLOSE_REQ) && !missingAUFHash.empty())
    {
       // In auto-recover mode, we just recreate the alias files, and do not ask user.
@@ -248,7 +249,7 @@ XO("Project check of \"%s\" folder \
    // MISSING (.AU) SimpleBlockFiles
    //
    BlockHash missingAUHash;               // missing data (.au) blockfiles
-   dm.FindMissingAUs(missingAUHash);
+   dm.FindMissingAUs(missingAUHash, &diskFileIndex);
    if ((nResult != FSCKstatus_CLOSE_REQ) && !missingAUHash.empty())
    {
       // In auto-recover mode, we just always create silent blocks.
@@ -187,6 +187,9 @@ bool ProjectFileIO::HandleXMLTag(const wxChar *tag, const wxChar **attrs)
    // The auto-save data dir the project has been recovered from
    FilePath recoveryAutoSaveDataDir;
 
+   // Projects that do not say otherwise store blocks uncompressed
+   dirManager.SetCompressBlocks( false );
+
    // loop through attrs, which is a null-terminated list of
    // attribute-value pairs
    while(*attrs) {
@@ -311,6 +314,10 @@ bool ProjectFileIO::HandleXMLTag(const wxChar *tag, const wxChar **attrs)
          settings.SetSnapTo(wxString(value) == wxT("on") ? true : false);
       }
 
+      else if (!wxStrcmp(attr, wxT("compressblocks"))) {
+         dirManager.SetCompressBlocks(wxString(value) == wxT("on"));
+      }
+
       else if (!wxStrcmp(attr, wxT("selectionformat")))
          settings.SetSelectionFormat(
             NumericConverter::LookupFormat( NumericConverter::TIME, value) );
@@ -433,20 +440,15 @@ void ProjectFileIO::WriteXMLHeader(XMLWriter &xmlFile) const
    xmlFile.Write(wxT(">\n"));
 }
 
-void ProjectFileIO::WriteXML(
-   XMLWriter &xmlFile, FilePaths *strOtherNamesArray)
+void ProjectFileIO::WriteXMLHead(XMLWriter &xmlFile)
 // may throw
 {
    auto &proj = mProject;
-   auto &tracks = TrackList::Get( proj );
    auto &viewInfo = ViewInfo::Get( proj );
    auto &dirManager = DirManager::Get( proj );
    auto &tags = Tags::Get( proj );
    const auto &settings = ProjectSettings::Get( proj );
 
-   bool bWantSaveCopy = (strOtherNamesArray != nullptr);
-
-   //TIMER_START( "AudacityProject::WriteXML", xml_writer_timer );
    // Warning: This block of code is duplicated in Save, for now...
    wxFileName project { proj.GetFileName() };
    if (project.GetExt() == wxT("aup"))
@@ -488,8 +490,24 @@ void ProjectFileIO::WriteXML(
                      settings.GetFrequencySelectionFormatName().Internal());
    xmlFile.WriteAttr(wxT("bandwidthformat"),
                      settings.GetBandwidthSelectionFormatName().Internal());
+   // Written only when on, which older versions cannot open anyway
+   if (dirManager.GetCompressBlocks())
+      xmlFile.WriteAttr(wxT("compressblocks"), wxT("on"));
 
    tags.WriteXML(xmlFile);
+}
+
+void ProjectFileIO::WriteXML(
+   XMLWriter &xmlFile, FilePaths *strOtherNamesArray)
+// may throw
+{
+   auto &proj = mProject;
+   auto &tracks = TrackList::Get( proj );
+
+   bool bWantSaveCopy = (strOtherNamesArray != nullptr);
+
+   //TIMER_START( "AudacityProject::WriteXML", xml_writer_timer );
+   WriteXMLHead(xmlFile);
 
    unsigned int ndx = 0;
    tracks.Any().Visit(
@@ -576,12 +594,47 @@ private:
    T mValExit;
 };
 
+// Give the journal the head of the document, then each track, as separate
+// slots, so that it may write only those that changed
+void ProjectFileIO::WriteAutoSaveSlots()
+// may throw
+{
+   auto &tracks = TrackList::Get( mProject );
+   auto &journal = *mpAutoSaveJournal;
+
+   {
+      AutoSaveFile buffer;
+      WriteXMLHeader( buffer );
+      WriteXMLHead( buffer );
+      journal.AddSlot( buffer );
+   }
+
+   unsigned int ndx = 0;
+   tracks.Any().Visit(
+      [&](WaveTrack *pWaveTrack) {
+         AutoSaveFile buffer;
+         pWaveTrack->SetAutoSaveIdent(++ndx);
+         pWaveTrack->WriteXML(buffer);
+         journal.AddSlot( buffer );
+      },
+      [&](Track *t) {
+         AutoSaveFile buffer;
+         t->WriteXML(buffer);
+         journal.AddSlot( buffer );
+      }
+   );
+}
+
 void ProjectFileIO::AutoSave()
 {
    auto &project = mProject;
    auto &window = GetProjectFrame( project );
    //    SonifyBeginAutoSave(); // part of RBD's r10680 stuff now backed out
 
+   if (!mpAutoSaveJournal)
+      mpAutoSaveJournal = std::make_unique< AutoSaveJournal >();
+   auto &journal = *mpAutoSaveJournal;
+
    // To minimize the possibility of race conditions, we first write to a
    // file with the extension ".tmp", then rename the file to .autosave
    wxString projName;
@@ -595,22 +648,32 @@ void ProjectFileIO::AutoSave()
    wxString fn = wxFileName(FileNames::AutoSaveDir(),
       projName + wxString(wxT(" - ")) + CreateUniqueName()).GetFullPath();
 
+   // If the journal in the current auto-save file can continue, append to it
+   // only what changed; else write a complete, compacted NEW file.
+   bool appended = false;
+
    // PRL:  I found a try-catch and rewrote it,
    // but this guard is unnecessary because AutoSaveFile does not throw
    bool success = GuardedCall< bool >( [&]
    {
       VarSetter<bool> setter(&mAutoSaving, true, false);
 
-      AutoSaveFile buffer;
-      WriteXMLHeader( buffer );
-      WriteXML( buffer, nullptr );
+      WriteAutoSaveSlots();
+
+      if (!mAutoSaveFileName.empty() &&
+          journal.CanAppend(mAutoSaveFileName))
+      {
+         wxFFile saveFile;
+         saveFile.Open(mAutoSaveFileName, wxT("ab"));
+         return (appended = journal.Append(saveFile));
+      }
 
       wxFFile saveFile;
       saveFile.Open(fn + wxT(".tmp"), wxT("wb"));
-      return buffer.Write(saveFile);
-   } );
+      return journal.Write(saveFile);
+   }, [&](AudacityException *) { journal.Reset(); return false; } );
 
-   if (!success)
+   if (!success || appended)
       return;
 
    // Now that we have a NEW auto-save file, DELETE the old one
@@ -621,6 +684,7 @@ void ProjectFileIO::AutoSave()
 
    if (!wxRenameFile(fn + wxT(".tmp"), fn + wxT(".autosave")))
    {
+      journal.Reset();
       AudacityMessageBox(
          XO("Could not create autosave file: %s")
             .Format( fn + wxT(".autosave") ),
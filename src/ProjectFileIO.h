@@ -16,6 +16,7 @@ Paul Licameli split from AudacityProject.h
 #include "xml/XMLTagHandler.h" // to inherit
 
 class AudacityProject;
+class AutoSaveJournal;
 
 ///\brief Object associated with a project that manages reading and writing
 /// of Audacity project file formats, and autosave
@@ -67,6 +68,10 @@ private:
    // XMLTagHandler callback methods
    bool HandleXMLTag(const wxChar *tag, const wxChar **attrs) override;
 
+   // Start tag and attributes of the project, and the tags
+   void WriteXMLHead(XMLWriter &xmlFile);
+   void WriteAutoSaveSlots();
+
    void UpdatePrefs() override;
 
    // non-static data members
@@ -78,6 +83,10 @@ private:
    // Are we currently auto-saving or not?
    bool mAutoSaving{ false };
 
+   // What was written to the auto-save file, so the next auto-save can
+   // append only what changed
+   std::unique_ptr<AutoSaveJournal> mpAutoSaveJournal;
+
    // Has this project been recovered from an auto-saved version
    bool mIsRecovered{ false };
 
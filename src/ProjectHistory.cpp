@@ -10,12 +10,17 @@ Paul Licameli split from ProjectManager.cpp
 
 #include "ProjectHistory.h"
 
+#include <wx/time.h>
+
+#include "AudacityException.h"
 #include "Project.h"
 #include "ProjectFileIO.h"
+#include "Sequence.h"
 #include "Tags.h"
 #include "Track.h"
 #include "UndoManager.h"
 #include "ViewInfo.h"
+#include "WaveClip.h"
 #include "WaveTrack.h"
 #include "ondemand/ODComputeSummaryTask.h"
 #include "ondemand/ODManager.h"
@@ -98,6 +103,7 @@ void ProjectHistory::PushState(const TranslatableString &desc,
       desc, shortDesc, flags);
 
    mDirty = true;
+   NoteChange();
 
    if((flags & UndoPush::AUTOSAVE) != UndoPush::MINIMAL)
       projectFileIO.AutoSave();
@@ -178,6 +184,7 @@ void ProjectHistory::PopState(const UndoState &state)
       ODManager::Instance()->AddNewTask(std::move(computeTask));
 
    projectFileIO.AutoSave();
+   NoteChange();
 }
 
 void ProjectHistory::SetStateTo(unsigned int n)
@@ -188,3 +195,66 @@ void ProjectHistory::SetStateTo(unsigned int n)
    undoManager.SetStateTo(n,
       [this]( const UndoState &state ){ PopState(state); } );
 }
+
+void ProjectHistory::NoteChange()
+{
+   mMayNeedCompaction = true;
+   mLastChangeTime = ::wxGetLocalTimeMillis();
+}
+
+namespace {
+   // Wait this long after the last change before compacting
+   constexpr long CompactionDelayMs = 3000;
+}
+
+void ProjectHistory::CompactBlocks()
+{
+   auto &project = mProject;
+   auto &tracks = TrackList::Get( project );
+
+   if (!mMayNeedCompaction || tracks.HasPendingTracks())
+      return;
+   if (::wxGetLocalTimeMillis() - mLastChangeTime < CompactionDelayMs)
+      return;
+
+   // Compaction only tidies up; on failure, such as a full disk, give up
+   // quietly until the next change.  Only sequences edited since their last
+   // complete pass are visited, and each call rewrites about one block, so
+   // that the timer calling it never stalls the user interface for long.
+   bool changed = false;
+   const bool finished = GuardedCall< bool >( [&] {
+      Optional<size_t> budget;
+      for (auto wt : tracks.Any< WaveTrack >())
+         for (const auto &clip : wt->GetClips()) {
+            auto sequence = clip->GetSequence();
+            if (!sequence->MayConsolidate())
+               continue;
+            if (!budget)
+               budget.emplace(sequence->GetMaxBlockSize());
+            else if (*budget == 0)
+               // Continue on the next call
+               return false;
+            if (sequence->Consolidate(*budget))
+               changed = true;
+         }
+      return true;
+   },
+   // Give up the pass, but keep what it did
+   [&](AudacityException *){ return true; },
+   [](AudacityException *){} );
+
+   if (changed)
+      mCompacted = true;
+
+   if (!finished)
+      return;
+
+   mMayNeedCompaction = false;
+   if (mCompacted) {
+      mCompacted = false;
+      // Keep the current undo state the same as the tracks, sharing the new
+      // blocks, so that the replaced ones can be freed; and the auto-save
+      // file must no longer mention the replaced blocks
+      ModifyState(true);
+   }
+}
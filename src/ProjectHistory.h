@@ -13,6 +13,8 @@ Paul Licameli split from ProjectManager.h
 
 #include "ClientData.h"
 
+#include <wx/longlong.h>
+
 class AudacityProject;
 struct UndoState;
 enum class UndoPush : unsigned char;
@@ -48,13 +50,28 @@ public:
       // projects
    void PopState(const UndoState &state);
 
+   // Merge the short blocks that editing leaves behind, about one block
+   // per call, once editing has paused.  Call periodically while no audio
+   // stream or mouse drag is active.  When a pass that changed anything
+   // ends, the current undo state is modified to match, so the replaced
+   // blocks can be freed, and the project is auto-saved.
+   void CompactBlocks();
+
    bool GetDirty() const { return mDirty; }
    void SetDirty( bool value ) { mDirty = value; }
 
 private:
+   void NoteChange();
+
    AudacityProject &mProject;
 
    bool mDirty{ false };
+
+   // Whether tracks changed since the last complete compaction pass
+   bool mMayNeedCompaction{ false };
+   // Whether the current compaction pass changed tracks
+   bool mCompacted{ false };
+   wxLongLong mLastChangeTime{ 0 };
 };
 
 #endif
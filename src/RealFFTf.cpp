@@ -41,6 +41,7 @@
 
 #include "Experimental.h"
 
+#include <algorithm>
 #include <vector>
 #include <stdlib.h>
 #include <stdio.h>
@@ -373,3 +374,143 @@ void ReorderToTime(const FFTParam *hFFT, const fft_type *buffer, fft_type *TimeO
       TimeOut[i*2+1]=buffer[hFFT->BitReversed[i]+1];
    }
 }
+
+namespace {
+// Store the output of RealFFTf in the order that InverseRealFFTf expects:
+// DC, Fs/2, then the real and imaginary parts of each other bin
+void PackSpectrum(const FFTParam *hFFT, const fft_type *buffer, fft_type *out)
+{
+   out[0] = buffer[0];
+   out[1] = buffer[1];
+   for(size_t i = 1; i < hFFT->Points; i++) {
+      out[2*i  ] = buffer[hFFT->BitReversed[i]  ];
+      out[2*i+1] = buffer[hFFT->BitReversed[i]+1];
+   }
+}
+}
+
+PartitionedFilter::PartitionedFilter(const float *impulse, size_t length,
+                                     size_t partitionSize)
+   : mLength{ std::max<size_t>(1, length) }
+{
+   size_t partitionLength;
+   if (partitionSize > 0) {
+      partitionLength = partitionSize;
+      mFFTSize = 2 * partitionSize;
+      mHopSize = partitionSize;
+   }
+   else {
+      // One partition, choosing the transform size that minimizes the cost
+      // per output sample, roughly N log N / (N - length + 1); but stay
+      // within the sizes for which float precision is known to suffice
+      partitionLength = mLength;
+      size_t bestSize = 0;
+      double bestCost = 0;
+      size_t size = 16;
+      while (size <= mLength)
+         size *= 2;
+      for (; bestSize == 0 || size <= 16384; size *= 2) {
+         double cost = size * (log2((double)size) + 2) / (size - mLength + 1);
+         if (bestSize == 0 || cost < bestCost)
+            bestSize = size, bestCost = cost;
+      }
+      mFFTSize = bestSize;
+      mHopSize = mFFTSize - mLength + 1;
+   }
+   mPartitions = (mLength + partitionLength - 1) / partitionLength;
+
+   hFFT = GetFFT(mFFTSize);
+   mSpectra.reinit(mPartitions * mFFTSize);
+   ArrayOf<float> buffer{ mFFTSize };
+   for (size_t p = 0; p < mPartitions; p++) {
+      auto begin = p * partitionLength;
+      auto count = std::min(partitionLength, mLength - begin);
+      std::fill(buffer.get(), buffer.get() + mFFTSize, 0.0f);
+      if (impulse && length > 0)
+         std::copy(impulse + begin, impulse + begin + count, buffer.get());
+      RealFFTf(buffer.get(), hFFT.get());
+      PackSpectrum(hFFT.get(), buffer.get(), &mSpectra[p * mFFTSize]);
+   }
+}
+
+PartitionedConvolver::PartitionedConvolver(
+   std::shared_ptr<const PartitionedFilter> pFilter)
+   : mpFilter{ std::move(pFilter) }
+   , mInput{ mpFilter->mFFTSize }
+   , mOutput{ mpFilter->mHopSize }
+   , mSpectrum{ mpFilter->mFFTSize }
+   , mTime{ mpFilter->mFFTSize }
+   , mHistory{ mpFilter->mPartitions * mpFilter->mFFTSize }
+{
+   Reset();
+}
+
+void PartitionedConvolver::Reset()
+{
+   const auto &filter = *mpFilter;
+   std::fill(mInput.get(), mInput.get() + filter.mFFTSize, 0.0f);
+   std::fill(mOutput.get(), mOutput.get() + filter.mHopSize, 0.0f);
+   std::fill(mHistory.get(),
+      mHistory.get() + filter.mPartitions * filter.mFFTSize, 0.0f);
+   mFill = 0;
+   mNewest = 0;
+}
+
+void PartitionedConvolver::Process(const float *in, float *out, size_t len)
+{
+   const auto fftSize = mpFilter->mFFTSize;
+   const auto hopSize = mpFilter->mHopSize;
+   while (len > 0) {
+      auto count = std::min(len, hopSize - mFill);
+      // Take the input before writing the output, which may overlap it
+      std::copy(in, in + count, &mInput[fftSize - hopSize + mFill]);
+      std::copy(&mOutput[mFill], &mOutput[mFill] + count, out);
+      mFill += count;
+      in += count;
+      out += count;
+      len -= count;
+      if (mFill == hopSize) {
+         ProcessHop();
+         mFill = 0;
+      }
+   }
+}
+
+void PartitionedConvolver::ProcessHop()
+{
+   const auto &filter = *mpFilter;
+   const auto fftSize = filter.mFFTSize;
+   const auto hopSize = filter.mHopSize;
+   const auto partitions = filter.mPartitions;
+   const auto hFFT = filter.hFFT.get();
+
+   // Transform the input window into the frequency domain delay line
+   mNewest = (mNewest + 1) % partitions;
+   std::copy(mInput.get(), mInput.get() + fftSize, mTime.get());
+   RealFFTf(mTime.get(), hFFT);
+   PackSpectrum(hFFT, mTime.get(), &mHistory[mNewest * fftSize]);
+
+   // Each partition applies to the input that is as many hops older
+   auto acc = mSpectrum.get();
+   std::fill(acc, acc + fftSize, 0.0f);
+   for (size_t p = 0; p < partitions; p++) {
+      const auto x = &mHistory[((mNewest + partitions - p) % partitions) * fftSize];
+      const auto h = &filter.mSpectra[p * fftSize];
+      // DC and Fs/2 components are purely real
+      acc[0] += x[0] * h[0];
+      acc[1] += x[1] * h[1];
+      for (size_t i = 2; i < fftSize; i += 2) {
+         acc[i  ] += x[i] * h[i  ] - x[i+1] * h[i+1];
+         acc[i+1] += x[i] * h[i+1] + x[i+1] * h[i  ];
+      }
+   }
+
+   // Inverse FFT; the last hop of samples is free of circular wrap-around
+   InverseRealFFTf(acc, hFFT);
+   ReorderToTime(hFFT, acc, mTime.get());
+   std::copy(mTime.get() + fftSize - hopSize, mTime.get() + fftSize,
+      mOutput.get());
+
+   // Slide the input window
+   std::copy(mInput.get() + hopSize, mInput.get() + fftSize, mInput.get());
+}
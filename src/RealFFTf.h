@@ -7,6 +7,8 @@
 
 #include "MemoryX.h"
 
+#include <memory>
+
 using fft_type = float;
 struct FFTParam {
    ArrayOf<int> BitReversed;
@@ -32,5 +34,58 @@ void ReorderToTime(const FFTParam *hFFT, const fft_type *buffer, fft_type *TimeO
 void ReorderToFreq(const FFTParam *hFFT, const fft_type *buffer,
 		   fft_type *RealOut, fft_type *ImagOut);
 
+/// A real FIR filter, cut into equal partitions that are transformed once,
+/// for use by PartitionedConvolver.  One filter may be shared by the
+/// convolvers of many channels.
+class PartitionedFilter {
+public:
+   // partitionSize must be a power of two, which bounds the latency; or
+   // zero, to use one partition and the transform size that is cheapest for
+   // offline processing.
+   PartitionedFilter(const float *impulse, size_t length,
+                     size_t partitionSize = 0);
+
+   size_t GetLength() const { return mLength; }
+   size_t GetFFTSize() const { return mFFTSize; }
+   // Number of new input samples consumed by each transform
+   size_t GetHopSize() const { return mHopSize; }
+
+private:
+   friend class PartitionedConvolver;
+
+   HFFT hFFT;
+   size_t mLength, mFFTSize, mHopSize, mPartitions;
+   // Spectra of the partitions, mFFTSize values each, in the order that
+   // InverseRealFFTf expects
+   ArrayOf<float> mSpectra;
+};
+
+/// Streaming overlap-save convolution with a uniformly partitioned filter.
+/// Output lags input by GetLatency() samples.  Process() does not allocate,
+/// so it is usable in realtime.
+class PartitionedConvolver {
+public:
+   explicit PartitionedConvolver(
+      std::shared_ptr<const PartitionedFilter> pFilter);
+
+   size_t GetLatency() const { return mpFilter->GetHopSize(); }
+
+   void Reset();
+
+   // in and out may be the same buffer
+   void Process(const float *in, float *out, size_t len);
+
+private:
+   void ProcessHop();
+
+   std::shared_ptr<const PartitionedFilter> mpFilter;
+   ArrayOf<float> mInput;    // the last FFT size input samples
+   ArrayOf<float> mOutput;   // one hop of output
+   ArrayOf<float> mSpectrum, mTime;
+   ArrayOf<float> mHistory;  // spectra of the last inputs, one for each partition
+   size_t mFill{ 0 };
+   size_t mNewest{ 0 };
+};
+
 #endif
 
@@ -29,6 +29,201 @@
 
 #include <soxr.h>
 
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <vector>
+
+#include <wx/thread.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+   (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RESAMPLE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Coefficients of a windowed sinc low pass filter for resampling by L/M,
+// cut into L phases of the same number of taps
+struct PolyphaseFilter {
+   size_t L, M, taps;
+   Floats coefficients;
+};
+
+// Largest numerator or denominator of a ratio given to PolyphaseResampler;
+// enough for 44100 <-> 48000 (147/160) as well as 2x and 4x
+enum : size_t { MaxPolyphaseFactor = 160 };
+
+bool FindPolyphaseRatio(double factor, size_t &L, size_t &M)
+{
+   for (M = 1; M <= MaxPolyphaseFactor; ++M) {
+      auto l = std::round(factor * M);
+      if (l >= 1 && l <= MaxPolyphaseFactor &&
+          std::abs(l / M - factor) <= 1e-9 * factor) {
+         L = l;
+         return true;
+      }
+   }
+   return false;
+}
+
+double BesselI0(double x)
+{
+   double sum = 1, term = 1;
+   for (int k = 1; k < 50 && term > 1e-12 * sum; ++k) {
+      term *= (x / (2 * k)) * (x / (2 * k));
+      sum += term;
+   }
+   return sum;
+}
+
+std::shared_ptr<const PolyphaseFilter> MakePolyphaseFilter(size_t L, size_t M)
+{
+   // Match the soxr low quality specification:  16 bit rejection, passband
+   // to 1385/2048 and stopband from the Nyquist frequency of the lower rate
+   const double rejection = 16 * 20 * log10(2.0);
+   const double passband = 1385 / 2048.0;
+   const double nyquist = 0.5 * std::min(1.0, double(L) / M);
+   const double cutoff = nyquist * (1 + passband) / 2;
+   const double transition = nyquist * (1 - passband);
+
+   // Kaiser window estimates, with taps rounded up for the SIMD kernel
+   const double beta = 0.1102 * (rejection - 8.7);
+   auto taps = size_t(ceil((rejection - 7.95) / (14.36 * transition))) + 1;
+   taps = (taps + 3) & ~size_t(3);
+   const double half = taps / 2;
+
+   auto result = std::make_shared<PolyphaseFilter>();
+   result->L = L;
+   result->M = M;
+   result->taps = taps;
+   result->coefficients.reinit(L * taps);
+   const double i0Beta = BesselI0(beta);
+   const double pi = 4 * atan(1.0);
+   for (size_t p = 0; p < L; ++p) {
+      auto phase = &result->coefficients[p * taps];
+      double sum = 0;
+      for (size_t k = 0; k < taps; ++k) {
+         // Distance in input samples from the tap to the output time
+         const double u = half - 1 - k + double(p) / L;
+         const double r = u / half;
+         const double window = BesselI0(beta * sqrt(std::max(0.0, 1 - r * r)));
+         const double x = 2 * pi * cutoff * u;
+         const double sinc = (x == 0) ? 1 : sin(x) / x;
+         const double value = 2 * cutoff * sinc * window / i0Beta;
+         phase[k] = value;
+         sum += value;
+      }
+      // Unity gain at DC for every phase
+      for (size_t k = 0; k < taps; ++k)
+         phase[k] /= sum;
+   }
+   return result;
+}
+
+// Filters are designed once for each ratio and shared
+std::shared_ptr<const PolyphaseFilter> GetPolyphaseFilter(size_t L, size_t M)
+{
+   static std::map< std::pair<size_t, size_t>,
+      std::shared_ptr<const PolyphaseFilter> > cache;
+   static wxCriticalSection cacheMutex;
+
+   wxCriticalSectionLocker locker{ cacheMutex };
+   auto &filter = cache[{ L, M }];
+   if (!filter)
+      filter = MakePolyphaseFilter(L, M);
+   return filter;
+}
+
+float DotProduct(const float *x, const float *h, size_t len)
+{
+   size_t i = 0;
+   float sum = 0;
+#ifdef RESAMPLE_SSE2
+   __m128 acc = _mm_setzero_ps();
+   for (; i + 4 <= len; i += 4)
+      acc = _mm_add_ps(acc,
+         _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(h + i)));
+   float lanes[4];
+   _mm_storeu_ps(lanes, acc);
+   sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+   for (; i < len; ++i)
+      sum += x[i] * h[i];
+   return sum;
+}
+
+}
+
+/// Constant-rate resampling by a small rational ratio, with the same
+/// alignment of input and output as soxr
+class PolyphaseResampler
+{
+public:
+   explicit PolyphaseResampler(std::shared_ptr<const PolyphaseFilter> pFilter)
+      : mpFilter{ std::move(pFilter) }
+      , mHalf( mpFilter->taps / 2 )
+      // Silence precedes the input
+      , mBuffer( mpFilter->taps, 0.0f )
+      , mBase{ -(long long)mpFilter->taps }
+   {
+   }
+
+   std::pair<size_t, size_t> Process(const float *inBuffer,
+      size_t inBufferLen, bool lastFlag, float *outBuffer, size_t outBufferLen)
+   {
+      const auto &filter = *mpFilter;
+      if (!mFlushing) {
+         mBuffer.insert(mBuffer.end(), inBuffer, inBuffer + inBufferLen);
+         mInputs += inBufferLen;
+         if (lastFlag) {
+            // Silence follows the input
+            mFlushing = true;
+            mBuffer.insert(mBuffer.end(), mHalf, 0.0f);
+         }
+      }
+
+      const long long end = mBase + mBuffer.size();
+      const long long limit = mFlushing
+         ? (mInputs * filter.L + filter.M - 1) / filter.M
+         : -1;
+      size_t produced = 0;
+      while (produced < outBufferLen &&
+             (limit < 0 || mOutputs < limit) &&
+             mIndex + (long long)mHalf < end) {
+         outBuffer[produced++] = DotProduct(
+            &mBuffer[mIndex + 1 - mHalf - mBase],
+            &filter.coefficients[mPhase * filter.taps], filter.taps);
+         ++mOutputs;
+         mPhase += filter.M;
+         while (mPhase >= filter.L)
+            mPhase -= filter.L, ++mIndex;
+      }
+
+      // Discard input that no later output needs
+      const auto first = mIndex + 1 - (long long)mHalf;
+      if (first > mBase) {
+         const auto discard = std::min<long long>(first - mBase, mBuffer.size());
+         mBuffer.erase(mBuffer.begin(), mBuffer.begin() + discard);
+         mBase += discard;
+      }
+
+      return { inBufferLen, produced };
+   }
+
+private:
+   const std::shared_ptr<const PolyphaseFilter> mpFilter;
+   const size_t mHalf;
+   std::vector<float> mBuffer;
+   long long mBase;         // input index of mBuffer[0]
+   long long mInputs{ 0 };
+   long long mOutputs{ 0 };
+   long long mIndex{ 0 };   // input index at or before the next output time
+   size_t mPhase{ 0 };      // and the fraction past it, in units of 1 / L
+   bool mFlushing{ false };
+};
+
 Resample::Resample(const bool useBestMethod, const double dMinFactor, const double dMaxFactor)
 {
    this->SetMethod(useBestMethod);
@@ -36,7 +231,14 @@ Resample::Resample(const bool useBestMethod, const double dMinFactor, const doub
    if (dMinFactor == dMaxFactor)
    {
       mbWantConstRateResampling = true; // constant rate resampling
-      q_spec = soxr_quality_spec("\0\1\4\6"[mMethod], 0);
+      const auto recipe = "\0\1\4\6"[mMethod];
+      size_t L, M;
+      if (recipe == SOXR_LQ && FindPolyphaseRatio(dMinFactor, L, M)) {
+         mPolyphase =
+            std::make_unique<PolyphaseResampler>(GetPolyphaseFilter(L, M));
+         return;
+      }
+      q_spec = soxr_quality_spec(recipe, 0);
    }
    else
    {
@@ -93,7 +295,10 @@ std::pair<size_t, size_t>
                         size_t  outBufferLen)
 {
    size_t idone, odone;
-   if (mbWantConstRateResampling)
+   if (mPolyphase)
+      return mPolyphase->Process(
+         inBuffer, inBufferLen, lastFlag, outBuffer, outBufferLen);
+   else if (mbWantConstRateResampling)
    {
       soxr_process(mHandle.get(),
             inBuffer , (lastFlag? ~inBufferLen : inBufferLen), &idone,
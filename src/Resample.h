@@ -25,6 +25,8 @@ struct soxr_deleter {
 };
 using soxrHandle = std::unique_ptr<soxr, soxr_deleter>;
 
+class PolyphaseResampler;
+
 class Resample final
 {
  public:
@@ -80,6 +82,9 @@ class Resample final
  protected:
    int   mMethod; // resampler-specific enum for resampling method
    soxrHandle mHandle; // constant-rate or variable-rate resampler (XOR per instance)
+   // Replaces mHandle for constant-rate resampling by common ratios at the
+   // low quality setting, so that it is cheap to construct
+   std::unique_ptr<PolyphaseResampler> mPolyphase;
    bool mbWantConstRateResampling;
 };
 
@@ -51,6 +51,19 @@
 
 size_t Sequence::sMaxDiskBlockSize = 1048576;
 
+namespace {
+   // Blocks may grow to this many times the preferred size, where a long
+   // sequence is appended to or consolidated
+   constexpr size_t LongBlockFactor = 4;
+   // Sequences longer than this many blocks of the preferred size are long
+   constexpr size_t LongSequenceBlocks = 64;
+
+   // How many edit positions each sequence remembers
+   constexpr size_t EditHistoryLength = 16;
+   // How many of those must fall near a place to keep its blocks short
+   constexpr size_t HotEditCount = 3;
+}
+
 // Sequence methods
 Sequence::Sequence(const std::shared_ptr<DirManager> &projDirManager, sampleFormat format)
    : mDirManager(projDirManager)
@@ -68,6 +81,8 @@ Sequence::Sequence(const Sequence &orig, const std::shared_ptr<DirManager> &proj
    , mSampleFormat(orig.mSampleFormat)
    , mMinSamples(orig.mMinSamples)
    , mMaxSamples(orig.mMaxSamples)
+   , mRecentEdits(orig.mRecentEdits)
+   , mMayConsolidate(orig.mMayConsolidate)
 {
    Paste(0, &orig);
 }
@@ -83,7 +98,51 @@ size_t Sequence::GetMaxBlockSize() const
 
 size_t Sequence::GetIdealBlockSize() const
 {
-   return mMaxSamples;
+   // Long sequences, such as recordings, get long blocks, for fewer files;
+   // editing will split them again where needed
+   const auto preferred = GetPreferredBlockSize();
+   if (mNumSamples >= sampleCount(preferred) * LongSequenceBlocks)
+      return mMaxSamples;
+   return preferred;
+}
+
+size_t Sequence::GetPreferredBlockSize() const
+{
+   return std::min(mMinSamples * 2, mMaxSamples);
+}
+
+size_t Sequence::GetEditBlockSize(sampleCount pos) const
+{
+   if (IsNearRecentEdits(pos))
+      return mMinSamples;
+   return GetPreferredBlockSize();
+}
+
+bool Sequence::IsNearRecentEdits(sampleCount pos) const
+{
+   const sampleCount radius = 2 * GetPreferredBlockSize();
+   const auto count = std::count_if(
+      mRecentEdits.begin(), mRecentEdits.end(),
+      [&](sampleCount edit){
+         return edit > pos - radius && edit < pos + radius; } );
+   return size_t(count) >= HotEditCount;
+}
+
+void Sequence::NoteEdit(sampleCount pos)
+{
+   if (mRecentEdits.size() >= EditHistoryLength)
+      mRecentEdits.pop_front();
+   mRecentEdits.push_back(pos);
+   mMayConsolidate = true;
+}
+
+void Sequence::ShiftEdits(sampleCount pos, sampleCount delta)
+{
+   // Edits after pos move with the samples; those in a deleted range go to
+   // its start
+   for (auto &edit : mRecentEdits)
+      if (edit > pos)
+         edit = std::max(pos, edit + delta);
 }
 
 bool Sequence::Lock()
@@ -168,9 +227,12 @@ bool Sequence::ConvertToSampleFormat(sampleFormat format)
    mSampleFormat = format;
 
    const auto oldMinSamples = mMinSamples, oldMaxSamples = mMaxSamples;
-   // These are the same calculations as in the constructor.
+   // These are the same calculations as in the constructor, but a sequence
+   // that was allowed long blocks still is.
    mMinSamples = sMaxDiskBlockSize / SAMPLE_SIZE(mSampleFormat) / 2;
    mMaxSamples = mMinSamples * 2;
+   if (oldMaxSamples > oldMinSamples * 2)
+      mMaxSamples *= LongBlockFactor;
 
    bool bSuccess = false;
    auto cleanup = finally( [&] {
@@ -386,6 +448,8 @@ float Sequence::GetRMS(sampleCount start, sampleCount len, bool mayThrow) const
 std::unique_ptr<Sequence> Sequence::Copy(sampleCount s0, sampleCount s1) const
 {
    auto dest = std::make_unique<Sequence>(mDirManager, mSampleFormat);
+   // Blocks are copied whole, so allow them as long as here
+   dest->mMaxSamples = mMaxSamples;
    if (s0 >= s1 || s0 >= mNumSamples || s1 < 0) {
       return dest;
    }
@@ -463,10 +527,8 @@ namespace {
                                     sampleFormat format,
                                     bool allowDeferredWrite = false)
    {
-      return dm.NewBlockFile( [&]( wxFileNameWrapper filePath ) {
-         return make_blockfile<SimpleBlockFile>(
-            std::move(filePath), sampleData, sampleLen, format, allowDeferredWrite);
-      } );
+      return dm.NewSimpleBlockFile(
+         sampleData, sampleLen, format, allowDeferredWrite );
    }
 }
 
@@ -513,6 +575,17 @@ void Sequence::Paste(sampleCount s, const Sequence *src)
 
    const size_t numBlocks = mBlock.size();
 
+   // Blocks of src may be pasted whole, so allow them as long as there
+   const auto oldMaxSamples = mMaxSamples;
+   mMaxSamples = std::max(mMaxSamples, src->mMaxSamples);
+   bool success = false;
+   auto cleanup = finally( [&] {
+      if (success)
+         ShiftEdits(s, addedLen);
+      else
+         mMaxSamples = oldMaxSamples;
+   } );
+
    if (numBlocks == 0 ||
        (s == mNumSamples && mBlock.back().f->GetLength() >= mMinSamples)) {
       // Special case: this track is currently empty, or it's safe to append
@@ -530,9 +603,13 @@ void Sequence::Paste(sampleCount s, const Sequence *src)
 
       CommitChangesIfConsistent
          (newBlock, samples, wxT("Paste branch one"));
+      success = true;
       return;
    }
 
+   NoteEdit(s);
+   const auto editBlockSize = GetEditBlockSize(s);
+
    const int b = (s == mNumSamples) ? mBlock.size() - 1 : FindBlock(s);
    wxASSERT((b >= 0) && (b < (int)numBlocks));
    SeqBlock *const pBlock = &mBlock[b];
@@ -541,7 +618,7 @@ void Sequence::Paste(sampleCount s, const Sequence *src)
    // PRL: when insertion point is the first sample of a block,
    // and the following test fails, perhaps we could test
    // whether coalescence with the previous block is possible.
-   if (largerBlockLen <= mMaxSamples) {
+   if (largerBlockLen <= editBlockSize) {
       // Special case: we can fit all of the NEW samples inside of
       // one block!
 
@@ -579,6 +656,7 @@ void Sequence::Paste(sampleCount s, const Sequence *src)
       // This consistency check won't throw, it asserts.
       // Proof that we kept consistency is not hard.
       ConsistencyCheck(wxT("Paste branch two"), false);
+      success = true;
       return;
    }
 
@@ -611,7 +689,7 @@ void Sequence::Paste(sampleCount s, const Sequence *src)
            splitBlock, splitPoint,
            splitLen - splitPoint, true);
 
-      Blockify(*mDirManager, mMaxSamples, mSampleFormat,
+      Blockify(*mDirManager, editBlockSize, mSampleFormat,
                newBlock, splitBlock.start, sumBuffer.ptr(), sum);
    } else {
 
@@ -638,7 +716,7 @@ void Sequence::Paste(sampleCount s, const Sequence *src)
       src->Get(0, sampleBuffer.ptr() + splitPoint*sampleSize,
          mSampleFormat, 0, srcFirstTwoLen, true);
 
-      Blockify(*mDirManager, mMaxSamples, mSampleFormat,
+      Blockify(*mDirManager, editBlockSize, mSampleFormat,
                newBlock, splitBlock.start, sampleBuffer.ptr(), leftLen);
 
       for (i = 2; i < srcNumBlocks - 2; i++) {
@@ -654,7 +732,7 @@ void Sequence::Paste(sampleCount s, const Sequence *src)
       Read(sampleBuffer.ptr() + srcLastTwoLen * sampleSize, mSampleFormat,
            splitBlock, splitPoint, rightSplit, true);
 
-      Blockify(*mDirManager, mMaxSamples, mSampleFormat,
+      Blockify(*mDirManager, editBlockSize, mSampleFormat,
                newBlock, s + lastStart, sampleBuffer.ptr(), rightLen);
    }
 
@@ -665,6 +743,7 @@ void Sequence::Paste(sampleCount s, const Sequence *src)
 
    CommitChangesIfConsistent
       (newBlock, mNumSamples + addedLen, wxT("Paste branch three"));
+   success = true;
 }
 
 void Sequence::SetSilence(sampleCount s0, sampleCount len)
@@ -721,6 +800,69 @@ void Sequence::InsertSilence(sampleCount s0, sampleCount len)
    Paste(s0, &sTrack);
 }
 
+bool Sequence::Consolidate(size_t &budget)
+// STRONG-GUARANTEE
+{
+   // Like Delete, this discards blocks that on-demand tasks may be visiting
+   DeleteUpdateMutexLocker locker(*this);
+
+   const auto target = GetIdealBlockSize();
+   const auto mergeable = [&](const SeqBlock &block) {
+      const auto &f = block.f;
+      // Alias, not-yet-decoded and silent blocks are left as they are
+      return f->GetLength() < mMinSamples &&
+         !f->IsAlias() && f->IsDataAvailable() &&
+         f->GetFileName().name.IsOk() &&
+         !IsNearRecentEdits(block.start);
+   };
+
+   BlockArray newBlock;
+   newBlock.reserve(mBlock.size());
+   SampleBuffer buffer;
+   bool changed = false, more = false;
+
+   for (size_t b = 0, nn = mBlock.size(); b < nn;) {
+      // Find a run of short blocks that together fit in one block
+      auto e = b;
+      size_t runLen = 0;
+      while (e < nn && mergeable(mBlock[e]) &&
+             runLen + mBlock[e].f->GetLength() <= target)
+         runLen += mBlock[e++].f->GetLength();
+
+      if (e - b < 2 || runLen > budget) {
+         if (e - b >= 2)
+            // Leave the rest for another call
+            budget = 0, more = true;
+         newBlock.push_back(mBlock[b++]);
+         continue;
+      }
+
+      if (!buffer.ptr())
+         buffer.Allocate(target, mSampleFormat);
+      size_t offset = 0;
+      for (auto i = b; i < e; ++i) {
+         const auto len = mBlock[i].f->GetLength();
+         Read(buffer.ptr() + offset * SAMPLE_SIZE(mSampleFormat),
+              mSampleFormat, mBlock[i], 0, len, true);
+         offset += len;
+      }
+      Blockify(*mDirManager, target, mSampleFormat,
+               newBlock, mBlock[b].start, buffer.ptr(), runLen);
+
+      budget -= runLen;
+      b = e;
+      changed = true;
+   }
+
+   if (changed)
+      CommitChangesIfConsistent
+         (newBlock, mNumSamples, wxT("Consolidate"));
+   if (!more)
+      mMayConsolidate = false;
+
+   return changed;
+}
+
 void Sequence::AppendBlock
    (DirManager &mDirManager,
     BlockArray &mBlock, sampleCount &mNumSamples, const SeqBlock &b)
@@ -1161,6 +1303,11 @@ void Sequence::SetSamples(samplePtr buffer, sampleFormat format,
    if (start < 0 || start + len > mNumSamples)
       THROW_INCONSISTENCY_EXCEPTION;
 
+   // Small changes, as with the drawing tool, are edits that may recur
+   // nearby; whole-track processing is not
+   if (len < mMinSamples)
+      NoteEdit(start);
+
    size_t tempSize = mMaxSamples;
    // to do:  allocate this only on demand
    SampleBuffer scratch(tempSize, mSampleFormat);
@@ -1513,7 +1660,7 @@ bool Sequence::GetWaveDisplay(float *min, float *max, float *rms, int* bl,
 size_t Sequence::GetIdealAppendLen() const
 {
    int numBlocks = mBlock.size();
-   const auto max = GetMaxBlockSize();
+   const auto max = GetIdealBlockSize();
 
    if (numBlocks == 0)
       return max;
@@ -1536,6 +1683,11 @@ void Sequence::Append(samplePtr buffer, sampleFormat format,
    if (Overflows(mNumSamples.as_double() + ((double)len)))
       THROW_INCONSISTENCY_EXCEPTION;
 
+   // A long sequence, as a recording or import, may have longer blocks,
+   // for fewer files
+   if (mNumSamples >= sampleCount(GetPreferredBlockSize()) * LongSequenceBlocks)
+      mMaxSamples = std::max(mMaxSamples, mMinSamples * 2 * LongBlockFactor);
+
    BlockArray newBlock;
    sampleCount newNumSamples = mNumSamples;
 
@@ -1551,7 +1703,7 @@ void Sequence::Append(samplePtr buffer, sampleFormat format,
         (pLastBlock = &mBlock.back())->f->GetLength()) < mMinSamples) {
       // Enlarge a sub-minimum block at the end
       const SeqBlock &lastBlock = *pLastBlock;
-      const auto addLen = std::min(mMaxSamples - length, len);
+      const auto addLen = std::min(GetIdealBlockSize() - length, len);
 
       Read(buffer2.ptr(), mSampleFormat, lastBlock, 0, length, true);
 
@@ -1653,6 +1805,9 @@ void Sequence::Delete(sampleCount start, sampleCount len)
    if (len < 0 || start < 0 || start + len > mNumSamples)
       THROW_INCONSISTENCY_EXCEPTION;
 
+   NoteEdit(start);
+   const auto editBlockSize = GetEditBlockSize(start);
+
    //TODO: add a ref-deref mechanism to SeqBlock/BlockArray so we don't have to make this a critical section.
    //On-demand threads iterate over the mBlocks and the GUI thread deletes them, so for now put a mutex here over
    //both functions,
@@ -1674,10 +1829,11 @@ void Sequence::Delete(sampleCount start, sampleCount len)
    auto scratchSize = mMaxSamples + mMinSamples;
 
    // Special case: if the samples to DELETE are all within a single
-   // block and the resulting length is not too small, perform the
-   // deletion within this block:
+   // block, the resulting length is not too small, and the block is not
+   // too long for the place, perform the deletion within this block:
    if (b0 == b1 &&
-       (length = (pBlock = &mBlock[b0])->f->GetLength()) - len >= mMinSamples) {
+       (length = (pBlock = &mBlock[b0])->f->GetLength()) - len >= mMinSamples &&
+       length - len <= editBlockSize) {
       SeqBlock &b = *pBlock;
       // start is within block
       auto pos = ( start - b.start ).as_size_t();
@@ -1717,6 +1873,7 @@ void Sequence::Delete(sampleCount start, sampleCount len)
       // This consistency check won't throw, it asserts.
       // Proof that we kept consistency is not hard.
       ConsistencyCheck(wxT("Delete - branch one"), false);
+      ShiftEdits(start, -len);
       return;
    }
 
@@ -1743,10 +1900,9 @@ void Sequence::Delete(sampleCount start, sampleCount len)
             scratch.Allocate(scratchSize, mSampleFormat);
          ensureSampleBufferSize(scratch, mSampleFormat, scratchSize, preBufferLen);
          Read(scratch.ptr(), mSampleFormat, preBlock, 0, preBufferLen, true);
-         auto pFile =
-            NewSimpleBlockFile( *mDirManager, scratch.ptr(), preBufferLen, mSampleFormat );
-
-         newBlock.push_back(SeqBlock(pFile, preBlock.start));
+         // What remains of a long block is split at the edit block size
+         Blockify(*mDirManager, editBlockSize, mSampleFormat,
+                  newBlock, preBlock.start, scratch.ptr(), preBufferLen);
       } else {
          const SeqBlock &prepreBlock = mBlock[b0 - 1];
          const auto prepreLen = prepreBlock.f->GetLength();
@@ -1762,7 +1918,7 @@ void Sequence::Delete(sampleCount start, sampleCount len)
               preBlock, 0, preBufferLen, true);
 
          newBlock.pop_back();
-         Blockify(*mDirManager, mMaxSamples, mSampleFormat,
+         Blockify(*mDirManager, editBlockSize, mSampleFormat,
                   newBlock, prepreBlock.start, scratch.ptr(), sum);
       }
    }
@@ -1789,10 +1945,8 @@ void Sequence::Delete(sampleCount start, sampleCount len)
          // start + len - 1 lies within postBlock
          auto pos = (start + len - postBlock.start).as_size_t();
          Read(scratch.ptr(), mSampleFormat, postBlock, pos, postBufferLen, true);
-         auto file =
-            NewSimpleBlockFile( *mDirManager, scratch.ptr(), postBufferLen, mSampleFormat );
-
-         newBlock.push_back(SeqBlock(file, start));
+         Blockify(*mDirManager, editBlockSize, mSampleFormat,
+                  newBlock, start, scratch.ptr(), postBufferLen);
       } else {
          SeqBlock &postpostBlock = mBlock[b1 + 1];
          const auto postpostLen = postpostBlock.f->GetLength();
@@ -1807,7 +1961,7 @@ void Sequence::Delete(sampleCount start, sampleCount len)
          Read(scratch.ptr() + (postBufferLen * sampleSize), mSampleFormat,
               postpostBlock, 0, postpostLen, true);
 
-         Blockify(*mDirManager, mMaxSamples, mSampleFormat,
+         Blockify(*mDirManager, editBlockSize, mSampleFormat,
                   newBlock, start, scratch.ptr(), sum);
          b1++;
       }
@@ -1823,6 +1977,7 @@ void Sequence::Delete(sampleCount start, sampleCount len)
 
    CommitChangesIfConsistent
       (newBlock, mNumSamples - len, wxT("Delete - branch two"));
+   ShiftEdits(start, -len);
 }
 
 void Sequence::ConsistencyCheck(const wxChar *whereStr, bool mayThrow) const
@@ -11,6 +11,7 @@
 #ifndef __AUDACITY_SEQUENCE__
 #define __AUDACITY_SEQUENCE__
 
+#include <deque>
 #include <vector>
 
 #include "SampleFormat.h"
@@ -126,6 +127,13 @@ class PROFILE_DLL_API Sequence final : public XMLTagHandler{
    void SetSilence(sampleCount s0, sampleCount len);
    void InsertSilence(sampleCount s0, sampleCount len);
 
+   // Rewrite runs of adjacent short blocks, left behind by editing, as fewer
+   // longer ones, except near recent edits.  At most budget samples are
+   // rewritten, and budget is reduced by that much, or to zero if work
+   // remains.  Return true iff there is a change
+   bool Consolidate(size_t &budget);
+   bool MayConsolidate() const { return mMayConsolidate; }
+
    const std::shared_ptr<DirManager> &GetDirManager() { return mDirManager; }
 
    //
@@ -231,6 +239,14 @@ class PROFILE_DLL_API Sequence final : public XMLTagHandler{
    size_t   mMinSamples; // min samples per block
    size_t   mMaxSamples; // max samples per block
 
+   // Where the most recent edits were, oldest first; blocks are kept
+   // shorter near places edited often, so that further edits there
+   // rewrite less
+   std::deque<sampleCount> mRecentEdits;
+   // Whether edits since the last complete Consolidate may have left
+   // short blocks
+   bool mMayConsolidate{ false };
+
    bool          mErrorOpening{ false };
 
    ///To block the Delete() method against the ODCalcSummaryTask::Update() method
@@ -242,6 +258,20 @@ class PROFILE_DLL_API Sequence final : public XMLTagHandler{
 
    int FindBlock(sampleCount pos) const;
 
+   //
+   // Block size policy.  No block is longer than mMaxSamples, but new blocks
+   // are sized below that according to how the region is being used.
+   //
+
+   // Samples per block for the disk block size preference
+   size_t GetPreferredBlockSize() const;
+   // Samples per block when rewriting the blocks around an edit at pos
+   size_t GetEditBlockSize(sampleCount pos) const;
+   bool IsNearRecentEdits(sampleCount pos) const;
+   void NoteEdit(sampleCount pos);
+   // Moves the remembered edits after pos by delta samples
+   void ShiftEdits(sampleCount pos, sampleCount delta);
+
    static void AppendBlock
       (DirManager &dirManager,
        BlockArray &blocks, sampleCount &numSamples, const SeqBlock &b);
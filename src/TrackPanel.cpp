@@ -457,6 +457,11 @@ void TrackPanel::OnTimer(wxTimerEvent& )
          }
       }
    }
+   // Tidy up the block files left behind by editing, when nothing else
+   // is going on (the window is disabled while modal progress yields)
+   if (!gAudioIO->IsStreamActive() && !IsMouseCaptured() && IsEnabled())
+      ProjectHistory::Get( *p ).CompactBlocks();
+
    if(mTimeCount > 1000)
       mTimeCount = 0;
 }
@@ -1401,7 +1401,7 @@ void WaveClip::SetDisplayRect(const wxRect& r) const
    mDisplayRect = r;
 }
 
-void WaveClip::GetDisplayRect(wxRect* r)
+void WaveClip::GetDisplayRect(wxRect* r) const
 {
    *r = mDisplayRect;
 }
@@ -254,6 +254,9 @@ public:
     * has changed, like when member functions SetSamples() etc. are called. */
    void MarkChanged() // NOFAIL-GUARANTEE
       { mDirty++; }
+   // Changes whenever MarkChanged is called, so that drawings of the clip
+   // can be reused until then
+   int GetDirty() const { return mDirty; }
 
    /** Getting high-level data for screen display and clipping
     * calculations and Contrast */
@@ -272,7 +275,7 @@ public:
    // called by TrackArtist while actually drawing the tracks and clips.
    void ClearDisplayRect() const;
    void SetDisplayRect(const wxRect& r) const;
-   void GetDisplayRect(wxRect* r);
+   void GetDisplayRect(wxRect* r) const;
 
    /** Whenever you do an operation to the sequence that will change the number
     * of samples (that is, the length of the clip), you will want to call this
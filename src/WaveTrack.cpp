@@ -2049,6 +2049,60 @@ void WaveTrack::GetEnvelopeValues(double *buffer, size_t bufferLen,
    }
 }
 
+void WaveTrack::ApplyEnvelope(float *buffer, size_t bufferLen,
+                              double t0) const
+{
+   // Same clip intersection logic as GetEnvelopeValues(), but samples outside
+   // of all clips keep unity gain and so are left alone
+   double startTime = t0;
+   auto tstep = 1.0 / mRate;
+   double endTime = t0 + tstep * bufferLen;
+   EnvelopeSegments segments;
+   for (const auto &clip: mClips)
+   {
+      auto dClipStartTime = clip->GetStartTime();
+      auto dClipEndTime = clip->GetEndTime();
+      if ((dClipStartTime < endTime) && (dClipEndTime > startTime))
+      {
+         auto rbuf = buffer;
+         auto rlen = bufferLen;
+         auto rt0 = t0;
+
+         if (rt0 < dClipStartTime)
+         {
+            auto nDiff = (sampleCount)floor((dClipStartTime - rt0) * mRate + 0.5);
+            auto snDiff = nDiff.as_size_t();
+            rbuf += snDiff;
+            wxASSERT(snDiff <= rlen);
+            rlen -= snDiff;
+            rt0 = dClipStartTime;
+         }
+
+         if (rt0 + rlen*tstep > dClipEndTime)
+         {
+            auto nClipLen = clip->GetEndSample() - clip->GetStartSample();
+
+            if (nClipLen <= 0)
+               return;
+
+            rlen = limitSampleBufferSize( rlen, nClipLen );
+            rlen = std::min(rlen, size_t(floor(0.5 + (dClipEndTime - rt0) / tstep)));
+         }
+
+         const auto envelope = clip->GetEnvelope();
+         double value;
+         if (envelope->IsConstant(value)) {
+            if (value != 1.0)
+               Envelope::ApplyGain(rbuf, rlen, value);
+         }
+         else {
+            envelope->GetSegments(segments, rlen, rt0, tstep);
+            Envelope::ApplySegments(rbuf, segments);
+         }
+      }
+   }
+}
+
 WaveClip* WaveTrack::GetClipAtX(int xcoord)
 {
    for (const auto &clip: mClips)
@@ -259,6 +259,11 @@ private:
    void GetEnvelopeValues(double *buffer, size_t bufferLen,
                          double t0) const;
 
+   // Multiply samples at uniformly separated sample times, starting at the
+   // given time, by the envelope.  Does nothing where envelopes are flat
+   // at unity gain.
+   void ApplyEnvelope(float *buffer, size_t bufferLen, double t0) const;
+
    // May assume precondition: t0 <= t1
    std::pair<float, float> GetMinMax(
       double t0, double t1, bool mayThrow = true) const;
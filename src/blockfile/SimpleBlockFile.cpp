@@ -48,6 +48,45 @@ default is to disable caching.
   manual auto recovery, because the files are never written physically to
   disk).
 
+* Write-behind: Without the cache, allowDeferredWrite instead hands the
+  file to a background thread (SimpleBlockFileWriter) and the data are
+  read from memory until it has been written, so that recording need not
+  wait for the disk.  Asking for the file name, or WriteCacheToDisk(),
+  waits for the file.  If too much is waiting already, the constructor
+  writes the file itself.  A failed write is reported by throwing from the
+  next block's constructor, and the recovery log is appended only after
+  the files it names are written (see AfterDeferredWrites()).
+
+*//****************************************************************//**
+
+\class SampleBlockCache
+\brief Holds the most recently read samples and summaries of
+SimpleBlockFiles in memory, up to the size set by the preference
+"/Directories/BlockCacheSize" (in MB).  This is separate from the per-block
+cache above: it is bounded, and applies to every project.
+
+*//****************************************************************//**
+
+\class OpenBlockFiles
+\brief Keeps up to 128 recently read SimpleBlockFiles open (except on
+Windows), so that reads that the SampleBlockCache does not serve need only
+a pread(), and not an open and header parse by libsndfile.
+
+*//****************************************************************//**
+
+\class CompressedBlockFile
+\brief A SimpleBlockFile that stores its samples losslessly compressed.
+
+The file is an .au file with a private encoding.  After the header and the
+uncompressed summary come the number of fractional bits of the samples (zero
+for integer formats, 23 for floats) and the number of samples, then frames
+of up to 4096 samples.  Each frame names one of the fixed predictors of
+order 0 to 3 and a Rice parameter k, followed by the prediction residuals,
+zigzag mapped and Rice coded: the quotient in unary, as ones ended by a
+zero, and k more bits.  A quotient of 24 or more is instead written as 24
+ones and the whole 32 bit value.  Predictions carry over between frames,
+assuming zeroes before the start.
+
 *//****************************************************************//**
 
 \class auHeader
@@ -69,10 +108,26 @@ to get its definition, rather than rolling our own.
 #include "../DirManager.h"
 #include "../Prefs.h"
 
+#include "../FileException.h"
 #include "../FileFormats.h"
 
 #include "sndfile.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <thread>
+#include <vector>
+
+#ifndef __WXMSW__
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 
 static wxUint32 SwapUintEndianess(wxUint32 in)
 {
@@ -86,6 +141,847 @@ static wxUint32 SwapUintEndianess(wxUint32 in)
   return out;
 }
 
+/// Finds the sample format of an .au block file from its header
+static bool ReadAuFormat(const wxString &path, sampleFormat &format)
+{
+   wxFFile file(path, wxT("rb"));
+   if (!file.IsOpened())
+      return false;
+
+   auHeader header;
+
+   if (file.Read(&header, sizeof(header)) != sizeof(header))
+   {
+      // Corrupt file
+      return false;
+   }
+
+   wxUint32 encoding;
+
+   if (header.magic == 0x2e736e64)
+      encoding = header.encoding; // correct endianness
+   else
+      encoding = SwapUintEndianess(header.encoding);
+
+   switch (encoding)
+   {
+   case AU_SAMPLE_FORMAT_16:
+   case AU_SAMPLE_FORMAT_LOSSLESS_16:
+      format = int16Sample;
+      break;
+   case AU_SAMPLE_FORMAT_24:
+   case AU_SAMPLE_FORMAT_LOSSLESS_24:
+      format = int24Sample;
+      break;
+   default:
+      // floatSample is a safe default (we will never loose data)
+      format = floatSample;
+      break;
+   }
+
+   return true;
+}
+
+/// Copies samples of a block held in memory, as ReadData does.  Samples
+/// that came from the file are narrowed without dither, as libsndfile does.
+static size_t ReadFromMemory(const char *src, sampleFormat srcFormat,
+   size_t blockLen, samplePtr data, sampleFormat format,
+   size_t start, size_t len, bool mayThrow, const wxFileName &fileName,
+   bool dither)
+{
+   auto framesRead = std::min(len, std::max(start, blockLen) - start);
+   const auto from = (samplePtr)(src + start * SAMPLE_SIZE(srcFormat));
+   if (dither)
+      CopySamples(from, srcFormat, data, format, framesRead);
+   else
+      CopySamplesNoDither(from, srcFormat, data, format, framesRead);
+
+   if ( framesRead < len ) {
+      if (mayThrow)
+         // Not the best exception class?
+         throw FileException{ FileException::Cause::Read, fileName };
+      ClearSamples(data, format, framesRead, len - framesRead);
+   }
+
+   return framesRead;
+}
+
+// Coding of samples for CompressedBlockFile
+
+static const size_t kFrameLen = 4096;
+static const unsigned kMaxOrder = 3;
+static const unsigned kMaxRiceBits = 30;
+static const unsigned kEscapeBits = 24;
+static const unsigned kFloatScaleBits = 23;
+// Bound on the magnitude of floats as scaled integers, so that residuals
+// stay within 32 bits
+static const double kMaxFloatScaled = 67108864.0; // 2^26
+
+namespace {
+
+class BitWriter {
+public:
+   explicit BitWriter(std::vector<unsigned char> &bytes) : mBytes{ bytes } {}
+
+   // count may be 0 to 32
+   void Put(wxUint32 value, unsigned count)
+   {
+      mAcc = (mAcc << count) | (value & ((wxUint64{ 1 } << count) - 1));
+      mnBits += count;
+      while (mnBits >= 8) {
+         mnBits -= 8;
+         mBytes.push_back(static_cast<unsigned char>(mAcc >> mnBits));
+      }
+   }
+
+   void Flush()
+   {
+      if (mnBits > 0)
+         mBytes.push_back(static_cast<unsigned char>(mAcc << (8 - mnBits)));
+      mnBits = 0;
+   }
+
+private:
+   std::vector<unsigned char> &mBytes;
+   wxUint64 mAcc{ 0 };
+   unsigned mnBits{ 0 };
+};
+
+class BitReader {
+public:
+   BitReader(const unsigned char *begin, const unsigned char *end)
+      : mpByte{ begin }, mpEnd{ end } {}
+
+   // count may be 0 to 32
+   wxUint32 Get(unsigned count)
+   {
+      while (mnBits < count) {
+         if (mpByte == mpEnd) {
+            mOk = false;
+            mAcc <<= 8;
+         }
+         else
+            mAcc = (mAcc << 8) | *mpByte++;
+         mnBits += 8;
+      }
+      mnBits -= count;
+      return static_cast<wxUint32>(
+         (mAcc >> mnBits) & ((wxUint64{ 1 } << count) - 1));
+   }
+
+   bool Ok() const { return mOk; }
+
+private:
+   const unsigned char *mpByte, *mpEnd;
+   wxUint64 mAcc{ 0 };
+   unsigned mnBits{ 0 };
+   bool mOk{ true };
+};
+
+// x must be preceded by kMaxOrder zeroes
+inline wxInt64 Predict(const int *x, size_t i, unsigned order)
+{
+   switch (order) {
+      case 0: default:
+         return 0;
+      case 1:
+         return x[i - 1];
+      case 2:
+         return 2 * wxInt64{ x[i - 1] } - x[i - 2];
+      case 3:
+         return 3 * (wxInt64{ x[i - 1] } - x[i - 2]) + x[i - 3];
+   }
+}
+
+inline wxUint32 Zigzag(wxInt64 residual)
+{
+   return static_cast<wxUint32>(
+      (static_cast<wxUint64>(residual) << 1) ^ (residual < 0 ? ~wxUint64{} : 0));
+}
+
+inline wxInt64 Unzigzag(wxUint32 value)
+{
+   return (value & 1) ? -wxInt64{ value >> 1 } - 1 : wxInt64{ value >> 1 };
+}
+
+void PutLittleEndian(std::vector<unsigned char> &bytes, wxUint32 value)
+{
+   for (int ii = 0; ii < 4; ++ii)
+      bytes.push_back(static_cast<unsigned char>(value >> (8 * ii)));
+}
+
+wxUint32 GetLittleEndian(const unsigned char *bytes)
+{
+   return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) |
+      (wxUint32{ bytes[3] } << 24);
+}
+
+/// Converts samples to integers, finding the number of fractional bits;
+/// false if floats are not all exactly scaled integers of modest size
+bool ToIntegers(constSamplePtr src, sampleFormat format, size_t len,
+   int *dest, unsigned &scaleBits)
+{
+   scaleBits = 0;
+   switch (format) {
+      case int16Sample: {
+         auto p = reinterpret_cast<const short *>(src);
+         std::copy(p, p + len, dest);
+         return true;
+      }
+      case int24Sample: {
+         auto p = reinterpret_cast<const int *>(src);
+         std::copy(p, p + len, dest);
+         return true;
+      }
+      case floatSample: default: {
+         auto p = reinterpret_cast<const float *>(src);
+         scaleBits = kFloatScaleBits;
+         const double scale = 1 << kFloatScaleBits;
+         for (size_t ii = 0; ii < len; ++ii) {
+            const double scaled = p[ii] * scale;
+            // The comparisons also exclude NaN; -0 would not come back
+            if (!(scaled == std::floor(scaled) &&
+                  std::fabs(scaled) <= kMaxFloatScaled) ||
+                (p[ii] == 0 && std::signbit(p[ii])))
+               return false;
+            dest[ii] = static_cast<int>(scaled);
+         }
+         return true;
+      }
+   }
+}
+
+void FromIntegers(const int *src, size_t len, unsigned scaleBits,
+   samplePtr dest, sampleFormat format)
+{
+   switch (format) {
+      case int16Sample: {
+         auto p = reinterpret_cast<short *>(dest);
+         for (size_t ii = 0; ii < len; ++ii)
+            p[ii] = static_cast<short>(src[ii]);
+         break;
+      }
+      case int24Sample:
+         std::copy(src, src + len, reinterpret_cast<int *>(dest));
+         break;
+      case floatSample: default: {
+         auto p = reinterpret_cast<float *>(dest);
+         const double scale = 1.0 / (wxUint64{ 1 } << scaleBits);
+         for (size_t ii = 0; ii < len; ++ii)
+            p[ii] = static_cast<float>(src[ii] * scale);
+         break;
+      }
+   }
+}
+
+// x must be preceded by kMaxOrder zeroes
+void EncodeIntegers(const int *x, size_t len, BitWriter &writer)
+{
+   for (size_t start = 0; start < len; start += kFrameLen) {
+      const auto end = std::min(len, start + kFrameLen);
+
+      // Choose the predictor with the least total residual
+      wxUint64 sums[kMaxOrder + 1] = {};
+      for (auto ii = start; ii < end; ++ii)
+         for (unsigned order = 0; order <= kMaxOrder; ++order)
+            sums[order] += Zigzag(x[ii] - Predict(x, ii, order));
+      unsigned order = 0;
+      for (unsigned oo = 1; oo <= kMaxOrder; ++oo)
+         if (sums[oo] < sums[order])
+            order = oo;
+
+      // The Rice parameter is about the log of the mean
+      unsigned k = 0;
+      const wxUint64 count = end - start;
+      while (k < kMaxRiceBits && (count << (k + 1)) < sums[order])
+         ++k;
+
+      writer.Put(order, 2);
+      writer.Put(k, 5);
+      for (auto ii = start; ii < end; ++ii) {
+         const auto value = Zigzag(x[ii] - Predict(x, ii, order));
+         const auto quotient = value >> k;
+         if (quotient < kEscapeBits) {
+            writer.Put(((1u << quotient) - 1) << 1, quotient + 1);
+            writer.Put(value, k);
+         }
+         else {
+            writer.Put((1u << kEscapeBits) - 1, kEscapeBits);
+            writer.Put(value, 32);
+         }
+      }
+   }
+   writer.Flush();
+}
+
+// x must be preceded by kMaxOrder zeroes
+bool DecodeIntegers(BitReader &reader, int *x, size_t len)
+{
+   for (size_t start = 0; start < len; start += kFrameLen) {
+      const auto end = std::min(len, start + kFrameLen);
+      const auto order = reader.Get(2);
+      const auto k = reader.Get(5);
+      if (order > kMaxOrder || k > kMaxRiceBits)
+         return false;
+      for (auto ii = start; ii < end; ++ii) {
+         unsigned quotient = 0;
+         while (quotient < kEscapeBits && reader.Get(1))
+            ++quotient;
+         const wxUint32 value = (quotient < kEscapeBits)
+            ? static_cast<wxUint32>((wxUint64{ quotient } << k) | reader.Get(k))
+            : reader.Get(32);
+         x[ii] = static_cast<int>(Predict(x, ii, order) + Unzigzag(value));
+      }
+      if (!reader.Ok())
+         return false;
+   }
+   return true;
+}
+
+}
+
+/// A block file held open for reading, where it is not a Windows file, which
+/// could then not be removed or renamed until closed.  Reads use pread()
+/// rather than a mapping, so that a file truncated meanwhile, or a failing
+/// disk, gives a short read and not a SIGBUS.
+class AuFileReader {
+public:
+   /// Returns null if the file can't be opened, is not a native-endian,
+   /// uncompressed .au file, or is shorter than its header says
+   static std::shared_ptr<AuFileReader> Open(const wxString &path);
+   ~AuFileReader();
+
+   /// Reads len samples from start, as stored in the file, into dest;
+   /// returns how many were read
+   size_t Read(char *dest, size_t start, size_t len) const;
+
+   sampleFormat format;
+   size_t diskSize; // bytes per sample in the file
+   size_t nSamples;
+
+private:
+   AuFileReader() = default;
+   int mFd{ -1 };
+   size_t mDataOffset{};
+};
+
+std::shared_ptr<AuFileReader> AuFileReader::Open(const wxString &path)
+{
+#ifdef __WXMSW__
+   (void)path;
+   return {};
+#else
+   const int fd = ::open(path.fn_str(), O_RDONLY);
+   if (fd < 0)
+      return {};
+   std::shared_ptr<AuFileReader> result{ safenew AuFileReader };
+   result->mFd = fd;
+
+   struct stat st;
+   auHeader header;
+   if (::fstat(fd, &st) != 0 ||
+       ::pread(fd, &header, sizeof(header), 0) != ssize_t(sizeof(header)))
+      return {};
+
+   const auto fileSize = size_t(st.st_size);
+   if (header.magic != 0x2e736e64 || header.dataOffset > fileSize)
+      return {};
+   // A size is optional in the header, but if there is one, the file must
+   // hold that much; otherwise leave it to libsndfile
+   if (header.dataSize != 0xffffffff &&
+       header.dataSize > fileSize - header.dataOffset)
+      return {};
+
+   switch (header.encoding) {
+      case AU_SAMPLE_FORMAT_16:
+         result->format = int16Sample, result->diskSize = 2;
+         break;
+      case AU_SAMPLE_FORMAT_24:
+         result->format = int24Sample, result->diskSize = 3;
+         break;
+      case AU_SAMPLE_FORMAT_FLOAT:
+         result->format = floatSample, result->diskSize = 4;
+         break;
+      default:
+         return {};
+   }
+   result->mDataOffset = header.dataOffset;
+   result->nSamples = (fileSize - header.dataOffset) / result->diskSize;
+   return result;
+#endif
+}
+
+AuFileReader::~AuFileReader()
+{
+#ifndef __WXMSW__
+   if (mFd >= 0)
+      ::close(mFd);
+#endif
+}
+
+size_t AuFileReader::Read(char *dest, size_t start, size_t len) const
+{
+#ifdef __WXMSW__
+   (void)dest, (void)start, (void)len;
+   return 0;
+#else
+   const size_t nBytes = len * diskSize;
+   size_t done = 0;
+   while (done < nBytes) {
+      const auto result = ::pread(mFd, dest + done, nBytes - done,
+         off_t(mDataOffset + start * diskSize + done));
+      if (result < 0 && errno == EINTR)
+         continue;
+      if (result <= 0)
+         break;
+      done += result;
+   }
+   return done / diskSize;
+#endif
+}
+
+/// Keeps the most recently read SimpleBlockFiles open, for reads that the
+/// SampleBlockCache does not serve
+class OpenBlockFiles {
+public:
+   static OpenBlockFiles &Get()
+   {
+      static OpenBlockFiles files;
+      return files;
+   }
+
+   using ReaderPtr = std::shared_ptr<const AuFileReader>;
+
+   /// Opens the file if it is not open already; null on failure
+   ReaderPtr Find(const SimpleBlockFile *pBlock, const wxFileName &fileName)
+   {
+      {
+         ODLocker locker{ &mLock };
+         auto end = mLRU.end();
+         auto iter = std::find_if(mLRU.begin(), end,
+            [&](const Item &item){ return item.first == pBlock; });
+         if (iter != end) {
+            mLRU.splice(mLRU.begin(), mLRU, iter);
+            return iter->second;
+         }
+      }
+
+      ReaderPtr pReader = AuFileReader::Open(fileName.GetFullPath());
+      if (pReader) {
+         ODLocker locker{ &mLock };
+         Remove(pBlock);
+         mLRU.emplace_front(pBlock, pReader);
+         if (mLRU.size() > MaxOpen)
+            mLRU.pop_back();
+      }
+      return pReader;
+   }
+
+   void Forget(const SimpleBlockFile *pBlock)
+   {
+      ODLocker locker{ &mLock };
+      Remove(pBlock);
+   }
+
+private:
+   static const size_t MaxOpen = 128;
+
+   using Item = std::pair<const SimpleBlockFile *, ReaderPtr>;
+
+   void Remove(const SimpleBlockFile *pBlock) // while mLock is held
+   {
+      mLRU.remove_if([&](const Item &item){ return item.first == pBlock; });
+   }
+
+   ODLock mLock;
+   std::list<Item> mLRU; // most recent at the front
+};
+
+static inline int Unpack24(const char *src)
+{
+   int value = 0;
+#if wxBYTE_ORDER == wxBIG_ENDIAN
+   memcpy((char*)&value + 1, src, 3);
+#else
+   memcpy(&value, src, 3);
+#endif
+   // Sign-extend
+   return static_cast<int>(static_cast<unsigned>(value) << 8) >> 8;
+}
+
+/// Reads samples from an open file, as ReadData does, converting packed
+/// 24 bit samples in the same pass.  Like libsndfile, narrowing truncates
+/// and does not dither.
+static size_t ReadFromAuFile(const AuFileReader &reader,
+   samplePtr data, sampleFormat format,
+   size_t start, size_t len, bool mayThrow, const wxFileName &fileName)
+{
+   auto framesRead = std::min(len, std::max(start, reader.nSamples) - start);
+   if (reader.format == format && format != int24Sample)
+      framesRead = reader.Read(data, start, framesRead);
+   else {
+      ArrayOf<char> raw{ framesRead * reader.diskSize };
+      framesRead = reader.Read(raw.get(), start, framesRead);
+      if (reader.format != int24Sample)
+         CopySamplesNoDither(raw.get(), reader.format, data, format,
+            framesRead);
+      else {
+         const char *src = raw.get();
+         if (format == floatSample) {
+            auto dst = reinterpret_cast<float *>(data);
+            for (size_t ii = 0; ii < framesRead; ++ii, src += 3)
+               dst[ii] = Unpack24(src) / float(1 << 23);
+         }
+         else if (format == int24Sample) {
+            auto dst = reinterpret_cast<int *>(data);
+            for (size_t ii = 0; ii < framesRead; ++ii, src += 3)
+               dst[ii] = Unpack24(src);
+         }
+         else {
+            SampleBuffer buffer(framesRead, int24Sample);
+            auto dst = reinterpret_cast<int *>(buffer.ptr());
+            for (size_t ii = 0; ii < framesRead; ++ii, src += 3)
+               dst[ii] = Unpack24(src);
+            CopySamplesNoDither(buffer.ptr(), int24Sample, data, format,
+               framesRead);
+         }
+      }
+   }
+
+   if ( framesRead < len ) {
+      if (mayThrow)
+         throw FileException{ FileException::Cause::Read, fileName };
+      ClearSamples(data, format, framesRead, len - framesRead);
+   }
+
+   return framesRead;
+}
+
+// Blocks read while this is positive are pinned in the SampleBlockCache
+static thread_local int sPinning = 0;
+
+SampleBlockCache &SampleBlockCache::Get()
+{
+   static SampleBlockCache cache;
+   return cache;
+}
+
+auto SampleBlockCache::GetStatistics() -> Statistics
+{
+   ODLocker locker{ &mLock };
+   return { mHits, mMisses, mEvictions, mBytes, mBudget };
+}
+
+void SampleBlockCache::ReadPrefs()
+{
+   auto megabytes = gPrefs->Read(wxT("/Directories/BlockCacheSize"), 64L);
+   ODLocker locker{ &mLock };
+   mBudget = std::max(0L, megabytes) * size_t(1024 * 1024);
+   if (mPinnedBytes > mBudget / 2) {
+      for (auto &pair : mEntries)
+         pair.second.pinned = false;
+      mPinnedBytes = 0;
+   }
+   Evict();
+}
+
+void SampleBlockCache::Clear()
+{
+   ODLocker locker{ &mLock };
+   mEntries.clear();
+   mLRU.clear();
+   mBytes = mPinnedBytes = 0;
+   mHits = mMisses = mEvictions = 0;
+}
+
+SampleBlockCache::Pinning::Pinning()
+{
+   ++sPinning;
+}
+
+SampleBlockCache::Pinning::~Pinning()
+{
+   --sPinning;
+}
+
+void SampleBlockCache::Unpin()
+{
+   ODLocker locker{ &mLock };
+   for (auto &pair : mEntries)
+      pair.second.pinned = false;
+   mPinnedBytes = 0;
+   Evict();
+}
+
+void SampleBlockCache::SetPinned(Entry &entry, bool pinned)
+{
+   // Pinning is a preference, not a promise:  the pinned bytes may not
+   // exceed half of the budget, so that long playback still evicts
+   if (pinned && !entry.pinned &&
+       mPinnedBytes + entry.pData->size <= mBudget / 2) {
+      entry.pinned = true;
+      mPinnedBytes += entry.pData->size;
+   }
+   else if (!pinned && entry.pinned) {
+      entry.pinned = false;
+      mPinnedBytes -= entry.pData->size;
+   }
+}
+
+auto SampleBlockCache::Find(const Key &key) -> DataPtr
+{
+   ODLocker locker{ &mLock };
+   auto iter = mEntries.find(key);
+   if (iter == mEntries.end()) {
+      ++mMisses;
+      return {};
+   }
+
+   ++mHits;
+   auto &entry = iter->second;
+   mLRU.splice(mLRU.begin(), mLRU, entry.lru);
+   if (sPinning > 0)
+      SetPinned(entry, true);
+   return entry.pData;
+}
+
+void SampleBlockCache::Store(const Key &key, DataPtr pData)
+{
+   ODLocker locker{ &mLock };
+   if (pData->size > mBudget)
+      return;
+
+   auto &entry = mEntries[key];
+   if (entry.pData) {
+      SetPinned(entry, false);
+      mBytes -= entry.pData->size;
+      mLRU.erase(entry.lru);
+   }
+   else
+      entry.pinned = false;
+   entry.pData = std::move(pData);
+   SetPinned(entry, sPinning > 0);
+   mLRU.push_front(key);
+   entry.lru = mLRU.begin();
+   mBytes += entry.pData->size;
+
+   Evict();
+}
+
+void SampleBlockCache::Forget(const SimpleBlockFile *pBlock)
+{
+   ODLocker locker{ &mLock };
+   for (auto summary : { false, true }) {
+      auto iter = mEntries.find({ pBlock, summary });
+      if (iter != mEntries.end()) {
+         SetPinned(iter->second, false);
+         mBytes -= iter->second.pData->size;
+         mLRU.erase(iter->second.lru);
+         mEntries.erase(iter);
+      }
+   }
+}
+
+void SampleBlockCache::Evict()
+{
+   // Go from least recently used, passing over what is pinned
+   auto iter = mLRU.end();
+   while (mBytes > mBudget && iter != mLRU.begin()) {
+      --iter;
+      auto found = mEntries.find(*iter);
+      if (found->second.pinned)
+         continue;
+      mBytes -= found->second.pData->size;
+      mEntries.erase(found);
+      iter = mLRU.erase(iter);
+      ++mEvictions;
+   }
+}
+
+/// Writes the files of SimpleBlockFiles made with allowDeferredWrite, in
+/// order, on a thread of its own
+class SimpleBlockFileWriter
+{
+public:
+   using Action = std::function< void() >;
+
+   static SimpleBlockFileWriter &Get();
+   ~SimpleBlockFileWriter();
+
+   /// Returns false, without queuing the block, if too much is waiting.
+   /// Throws if an earlier write failed.
+   bool Push(SimpleBlockFile *pBlock, size_t bytes);
+
+   /// Runs the action, on the writer's thread, once all the files queued
+   /// so far are on disk; or at once if there are none
+   void After(Action action);
+
+   /// Returns when the block is neither queued nor being written.
+   /// If it was still queued, writes it first on this thread if write is true.
+   void Finish(SimpleBlockFile *pBlock, bool write);
+
+private:
+   SimpleBlockFileWriter() {}
+   void Run();
+   void Write(SimpleBlockFile *pBlock);
+
+   // Beyond this many bytes of samples waiting, appends write synchronously
+   static const size_t MaxQueuedBytes = 32 * 1024 * 1024;
+
+   struct Item {
+      SimpleBlockFile *pBlock;
+      size_t bytes;
+      Action action;
+   };
+   using Queue = std::list<Item>;
+
+   ODLock mLock;
+   ODCondition mChanged{ &mLock };
+   Queue mQueue;
+   // Where each queued block is in mQueue
+   std::unordered_map< const SimpleBlockFile*, Queue::iterator > mIndex;
+   size_t mQueuedBytes{ 0 };
+   // Blocks taken from the queue and not yet written, by any thread
+   size_t mWriting{ 0 };
+   // The first file that failed to be written, not yet reported
+   wxString mFailed;
+   bool mStopping{ false };
+   std::thread mThread;
+};
+
+SimpleBlockFileWriter &SimpleBlockFileWriter::Get()
+{
+   static SimpleBlockFileWriter writer;
+   return writer;
+}
+
+SimpleBlockFileWriter::~SimpleBlockFileWriter()
+{
+   {
+      ODLocker locker{ &mLock };
+      mStopping = true;
+      mChanged.Broadcast();
+   }
+   if (mThread.joinable())
+      mThread.join();
+}
+
+bool SimpleBlockFileWriter::Push(SimpleBlockFile *pBlock, size_t bytes)
+{
+   ODLocker locker{ &mLock };
+   if (!mFailed.empty()) {
+      wxFileName failed{ mFailed };
+      mFailed.clear();
+      throw FileException{ FileException::Cause::Write, failed };
+   }
+
+   if (mStopping || mQueuedBytes + bytes > MaxQueuedBytes)
+      return false;
+
+   if (!mThread.joinable())
+      mThread = std::thread( [this]{ Run(); } );
+
+   pBlock->mWritePending = true;
+   mIndex[pBlock] = mQueue.insert(mQueue.end(), { pBlock, bytes, {} });
+   mQueuedBytes += bytes;
+   mChanged.Broadcast();
+   return true;
+}
+
+void SimpleBlockFileWriter::After(Action action)
+{
+   {
+      ODLocker locker{ &mLock };
+      if (!mIndex.empty() || mWriting > 0) {
+         mQueue.push_back({ nullptr, 0, std::move(action) });
+         mChanged.Broadcast();
+         return;
+      }
+   }
+   action();
+}
+
+void SimpleBlockFileWriter::Finish(SimpleBlockFile *pBlock, bool write)
+{
+   if (!pBlock->mWritePending)
+      return;
+
+   ODLocker locker{ &mLock };
+   auto found = mIndex.find(pBlock);
+   if (found != mIndex.end()) {
+      auto iter = found->second;
+      mIndex.erase(found);
+      mQueuedBytes -= iter->bytes;
+      mQueue.erase(iter);
+      if (!write) {
+         pBlock->mWritePending = false;
+         return;
+      }
+
+      ++mWriting;
+      locker.reset();
+      Write(pBlock);
+      locker.reset( &mLock );
+      --mWriting;
+      mChanged.Broadcast();
+      return;
+   }
+
+   while (pBlock->mWritePending)
+      mChanged.Wait();
+}
+
+/// Call without the lock
+void SimpleBlockFileWriter::Write(SimpleBlockFile *pBlock)
+{
+   const bool ok = pBlock->WriteBehind();
+   if (!ok) {
+      ODLocker locker{ &mLock };
+      if (mFailed.empty())
+         mFailed = pBlock->mFileName.GetFullPath();
+   }
+   pBlock->mWritePending = false;
+}
+
+void SimpleBlockFileWriter::Run()
+{
+   ODLocker locker{ &mLock };
+   while (true) {
+      while (mQueue.empty() && !mStopping)
+         mChanged.Wait();
+      if (mQueue.empty())
+         break;
+
+      auto item = std::move(mQueue.front());
+      mQueue.pop_front();
+
+      if (item.action) {
+         // Blocks queued before the action may have been taken by Finish
+         // and be still in the writing
+         while (mWriting > 0)
+            mChanged.Wait();
+         locker.reset();
+         GuardedCall( [&]{ item.action(); } );
+         locker.reset( &mLock );
+         continue;
+      }
+
+      mIndex.erase(item.pBlock);
+      ++mWriting;
+      locker.reset();
+      Write(item.pBlock);
+      locker.reset( &mLock );
+      --mWriting;
+      mQueuedBytes -= item.bytes;
+      mChanged.Broadcast();
+   }
+}
+
+void SimpleBlockFile::AfterDeferredWrites(std::function< void() > action)
+{
+   SimpleBlockFileWriter::Get().After(std::move(action));
+}
+
 /// Constructs a SimpleBlockFile based on sample data and writes
 /// it to disk.
 ///
@@ -112,6 +1008,28 @@ SimpleBlockFile::SimpleBlockFile(wxFileNameWrapper &&baseFileName,
 
    bool useCache = GetCache() && (!bypassCache);
 
+   if (allowDeferredWrite && !useCache && !bypassCache)
+   {
+      const auto sampleDataSize = sampleLen * SAMPLE_SIZE(format);
+      mCache.format = format;
+      mCache.sampleData.reinit(sampleDataSize);
+      memcpy(mCache.sampleData.get(), sampleData, sampleDataSize);
+      ArrayOf<char> cleanup;
+      void* summaryData = BlockFile::CalcSummary(sampleData, sampleLen,
+                                                format, cleanup);
+      mCache.summaryData.reinit(mSummaryInfo.totalSummaryBytes);
+      memcpy(mCache.summaryData.get(), summaryData,
+             mSummaryInfo.totalSummaryBytes);
+      mCache.active = true;
+      mCache.needWrite = true;
+
+      if (!SimpleBlockFileWriter::Get().Push(this, sampleDataSize) &&
+          !WriteBehind())
+         throw FileException{
+            FileException::Cause::Write, GetFileName().name };
+      return;
+   }
+
    if (!(allowDeferredWrite && useCache) && !bypassCache)
    {
       bool bSuccess = WriteSimpleBlockFile(sampleData, sampleLen, format, NULL);
@@ -157,6 +1075,35 @@ SimpleBlockFile::SimpleBlockFile(wxFileNameWrapper &&existingFile, size_t len,
 
 SimpleBlockFile::~SimpleBlockFile()
 {
+   SampleBlockCache::Get().Forget(this);
+   OpenBlockFiles::Get().Forget(this);
+
+   // A file that is to be kept must still be written; otherwise just make
+   // sure that the writer has let go of this
+   SimpleBlockFileWriter::Get().Finish(this, IsLocked());
+}
+
+/// Writes the cached data, and then frees them, or keeps them (for
+/// WriteCacheToDisk to try again) on failure
+bool SimpleBlockFile::WriteBehind()
+{
+   if (!WriteSimpleBlockFile(mCache.sampleData.get(), mLen, mCache.format,
+                             mCache.summaryData.get()))
+      return false;
+
+   ODLocker locker{ &mCacheMutex };
+   mCache.active = false;
+   mCache.needWrite = false;
+   mCache.sampleData.reset();
+   mCache.summaryData.reset();
+   return true;
+}
+
+auto SimpleBlockFile::GetFileName() const -> GetFileNameResult
+{
+   SimpleBlockFileWriter::Get().Finish(
+      const_cast<SimpleBlockFile*>(this), true);
+   return BlockFile::GetFileName();
 }
 
 bool SimpleBlockFile::WriteSimpleBlockFile(
@@ -214,56 +1161,40 @@ bool SimpleBlockFile::WriteSimpleBlockFile(
       //mchinen:allowing virtual override of calc summary for ODDecodeBlockFile.
       // PRL: cleanup fixes a possible memory leak!
 
-   size_t nBytesToWrite = sizeof(header);
-   size_t nBytesWritten = file.Write(&header, nBytesToWrite);
-   if (nBytesWritten != nBytesToWrite)
-   {
-      wxLogDebug(wxT("Wrote %lld bytes, expected %lld."), (long long) nBytesWritten, (long long) nBytesToWrite);
-      return false;
-   }
-
-   nBytesToWrite = mSummaryInfo.totalSummaryBytes;
-   nBytesWritten = file.Write(summaryData, nBytesToWrite);
-   if (nBytesWritten != nBytesToWrite)
-   {
-      wxLogDebug(wxT("Wrote %lld bytes, expected %lld."), (long long) nBytesWritten, (long long) nBytesToWrite);
-      return false;
-   }
+   // Assemble the whole file in memory, so that it takes one write
+   const auto sampleBytes = sampleLen * SAMPLE_SIZE_DISK(format);
+   const size_t nBytesToWrite =
+      sizeof(header) + mSummaryInfo.totalSummaryBytes + sampleBytes;
+   ArrayOf<char> buffer{ nBytesToWrite };
+   char *dest = buffer.get();
+   memcpy(dest, &header, sizeof(header));
+   dest += sizeof(header);
+   memcpy(dest, summaryData, mSummaryInfo.totalSummaryBytes);
+   dest += mSummaryInfo.totalSummaryBytes;
 
    if( format == int24Sample )
    {
-      // we can't write the buffer directly to disk, because 24-bit samples
-      // on disk need to be packed, not padded to 32 bits like they are in
-      // memory
-      int *int24sampleData = (int*)sampleData;
+      // 24-bit samples on disk need to be packed, not padded to 32 bits
+      // like they are in memory
+      const int *int24sampleData = (const int*)sampleData;
 
-      for( size_t i = 0; i < sampleLen; i++ )
+      for( size_t i = 0; i < sampleLen; i++, dest += 3 )
       {
-         nBytesToWrite = 3;
-         nBytesWritten =
-            #if wxBYTE_ORDER == wxBIG_ENDIAN
-               file.Write((char*)&int24sampleData[i] + 1, nBytesToWrite);
-            #else
-               file.Write((char*)&int24sampleData[i], nBytesToWrite);
-            #endif
-         if (nBytesWritten != nBytesToWrite)
-         {
-            wxLogDebug(wxT("Wrote %lld bytes, expected %lld."), (long long) nBytesWritten, (long long) nBytesToWrite);
-            return false;
-         }
+         #if wxBYTE_ORDER == wxBIG_ENDIAN
+            memcpy(dest, (const char*)&int24sampleData[i] + 1, 3);
+         #else
+            memcpy(dest, (const char*)&int24sampleData[i], 3);
+         #endif
       }
    }
    else
+      memcpy(dest, sampleData, sampleBytes);
+
+   size_t nBytesWritten = file.Write(buffer.get(), nBytesToWrite);
+   if (nBytesWritten != nBytesToWrite)
    {
-      // for all other sample formats we can write straight from the buffer
-      // to disk
-      nBytesToWrite = sampleLen * SAMPLE_SIZE(format);
-      nBytesWritten = file.Write(sampleData, nBytesToWrite);
-      if (nBytesWritten != nBytesToWrite)
-      {
-         wxLogDebug(wxT("Wrote %lld bytes, expected %lld."), (long long) nBytesWritten, (long long) nBytesToWrite);
-         return false;
-      }
+      wxLogDebug(wxT("Wrote %lld bytes, expected %lld."), (long long) nBytesWritten, (long long) nBytesToWrite);
+      return false;
    }
 
    return true;
@@ -277,44 +1208,12 @@ void SimpleBlockFile::FillCache()
       return; // cache is already filled
 
    // Check sample format
-   wxFFile file(mFileName.GetFullPath(), wxT("rb"));
-   if (!file.IsOpened())
+   if (!ReadAuFormat(mFileName.GetFullPath(), mCache.format))
    {
       // Don't read into cache if file not available
       return;
    }
 
-   auHeader header;
-
-   if (file.Read(&header, sizeof(header)) != sizeof(header))
-   {
-      // Corrupt file
-      return;
-   }
-
-   wxUint32 encoding;
-
-   if (header.magic == 0x2e736e64)
-      encoding = header.encoding; // correct endianness
-   else
-      encoding = SwapUintEndianess(header.encoding);
-
-   switch (encoding)
-   {
-   case AU_SAMPLE_FORMAT_16:
-      mCache.format = int16Sample;
-      break;
-   case AU_SAMPLE_FORMAT_24:
-      mCache.format = int24Sample;
-      break;
-   default:
-      // floatSample is a safe default (we will never loose data)
-      mCache.format = floatSample;
-      break;
-   }
-
-   file.Close();
-
    // Read samples into cache
    mCache.sampleData.reinit(mLen * SAMPLE_SIZE(mCache.format));
    if (ReadData(mCache.sampleData.get(), mCache.format, 0, mLen,
@@ -344,6 +1243,7 @@ void SimpleBlockFile::FillCache()
 bool SimpleBlockFile::ReadSummary(ArrayOf<char> &data)
 {
    data.reinit( mSummaryInfo.totalSummaryBytes );
+   ODLocker locker{ &mCacheMutex };
    if (mCache.active) {
       //wxLogDebug("SimpleBlockFile::ReadSummary(): Summary is already in cache.");
       memcpy(data.get(), mCache.summaryData.get(), mSummaryInfo.totalSummaryBytes);
@@ -351,6 +1251,17 @@ bool SimpleBlockFile::ReadSummary(ArrayOf<char> &data)
    }
    else
    {
+      locker.reset();
+
+      auto &cache = SampleBlockCache::Get();
+      const SampleBlockCache::Key key{ this, true };
+      if (cache.Enabled()) {
+         if (auto pData = cache.Find(key)) {
+            memcpy(data.get(), pData->bytes.get(), pData->size);
+            return true;
+         }
+      }
+
       //wxLogDebug("SimpleBlockFile::ReadSummary(): Reading summary from disk.");
 
       wxFFile file(mFileName.GetFullPath(), wxT("rb"));
@@ -379,6 +1290,15 @@ bool SimpleBlockFile::ReadSummary(ArrayOf<char> &data)
 
       FixSummary(data.get());
 
+      if (cache.Enabled()) {
+         auto pData = std::make_shared<SampleBlockCache::Data>();
+         pData->format = mSummaryInfo.format;
+         pData->size = mSummaryInfo.totalSummaryBytes;
+         pData->bytes.reinit(pData->size);
+         memcpy(pData->bytes.get(), data.get(), pData->size);
+         cache.Store(key, std::move(pData));
+      }
+
       return true;
    }
 }
@@ -393,28 +1313,69 @@ bool SimpleBlockFile::ReadSummary(ArrayOf<char> &data)
 size_t SimpleBlockFile::ReadData(samplePtr data, sampleFormat format,
                         size_t start, size_t len, bool mayThrow) const
 {
+   ODLocker locker{ &mCacheMutex };
    if (mCache.active)
    {
       //wxLogDebug("SimpleBlockFile::ReadData(): Data are already in cache.");
 
-      auto framesRead = std::min(len, std::max(start, mLen) - start);
-      CopySamples(
-         (samplePtr)(mCache.sampleData.get() +
-            start * SAMPLE_SIZE(mCache.format)),
-         mCache.format, data, format, framesRead);
-
-      if ( framesRead < len ) {
-         if (mayThrow)
-            // Not the best exception class?
-            throw FileException{ FileException::Cause::Read, mFileName };
-         ClearSamples(data, format, framesRead, len - framesRead);
+      return ReadFromMemory(mCache.sampleData.get(), mCache.format, mLen,
+         data, format, start, len, mayThrow, mFileName, true);
+   }
+   else {
+      locker.reset();
+
+      auto &cache = SampleBlockCache::Get();
+      if (cache.Enabled()) {
+         auto pData = cache.Find({ this, false });
+         if (!pData)
+            pData = ReadIntoBlockCache();
+         if (pData)
+            return ReadFromMemory(pData->bytes.get(), pData->format, mLen,
+               data, format, start, len, mayThrow, mFileName, false);
       }
 
-      return framesRead;
-   }
-   else
+      // Without the cache, read from the file, which stays open for the
+      // next read
+      if (auto pReader = OpenBlockFiles::Get().Find(this, mFileName))
+         return ReadFromAuFile(
+            *pReader, data, format, start, len, mayThrow, mFileName);
+
       return CommonReadData( mayThrow,
          mFileName, mSilentLog, nullptr, 0, 0, data, format, start, len);
+   }
+}
+
+/// Reads all the samples, in the format of the file, into the
+/// SampleBlockCache.  Returns null on failure.
+SampleBlockCache::DataPtr SimpleBlockFile::ReadIntoBlockCache() const
+{
+   auto pData = std::make_shared<SampleBlockCache::Data>();
+
+   // One opening serves for the header and the samples, not kept because
+   // the cache now holds them
+   if (auto pReader = AuFileReader::Open(mFileName.GetFullPath())) {
+      pData->format = pReader->format;
+      pData->size = mLen * SAMPLE_SIZE(pData->format);
+      pData->bytes.reinit(pData->size);
+      if (ReadFromAuFile(*pReader, pData->bytes.get(), pData->format,
+            0, mLen, false, mFileName) != mLen)
+         return {};
+   }
+   else {
+      sampleFormat format;
+      if (!ReadAuFormat(mFileName.GetFullPath(), format))
+         return {};
+
+      pData->format = format;
+      pData->size = mLen * SAMPLE_SIZE(format);
+      pData->bytes.reinit(pData->size);
+      if (CommonReadData( false, mFileName, mSilentLog, nullptr, 0, 0,
+            pData->bytes.get(), format, 0, mLen) != mLen)
+         return {};
+   }
+
+   SampleBlockCache::Get().Store({ this, false }, pData);
+   return pData;
 }
 
 void SimpleBlockFile::SaveXML(XMLWriter &xmlFile)
@@ -434,8 +1395,9 @@ void SimpleBlockFile::SaveXML(XMLWriter &xmlFile)
 // BuildFromXML methods should always return a BlockFile, not NULL,
 // even if the result is flawed (e.g., refers to nonexistent file),
 // as testing will be done in ProjectFSCK().
-/// static
-BlockFilePtr SimpleBlockFile::BuildFromXML(DirManager &dm, const wxChar **attrs)
+template< typename BlockFileType >
+static BlockFilePtr BuildSimpleBlockFileFromXML(
+   DirManager &dm, const wxChar **attrs)
 {
    wxFileNameWrapper fileName;
    float min = 0.0f, max = 0.0f, rms = 0.0f;
@@ -475,10 +1437,16 @@ BlockFilePtr SimpleBlockFile::BuildFromXML(DirManager &dm, const wxChar **attrs)
       }
    }
 
-   return make_blockfile<SimpleBlockFile>
+   return make_blockfile<BlockFileType>
       (std::move(fileName), len, min, max, rms);
 }
 
+/// static
+BlockFilePtr SimpleBlockFile::BuildFromXML(DirManager &dm, const wxChar **attrs)
+{
+   return BuildSimpleBlockFileFromXML<SimpleBlockFile>(dm, attrs);
+}
+
 /// Create a copy of this BlockFile, but using a different disk file.
 ///
 /// @param newFileName The name of the NEW file to use.
@@ -492,53 +1460,20 @@ BlockFilePtr SimpleBlockFile::Copy(wxFileNameWrapper &&newFileName)
 
 auto SimpleBlockFile::GetSpaceUsage() const -> DiskByteCount
 {
-   if (mCache.active && mCache.needWrite)
    {
-      // We don't know space usage yet
-      return 0;
+      ODLocker locker{ &mCacheMutex };
+      if (mCache.active && mCache.needWrite)
+      {
+         // We don't know space usage yet
+         return 0;
+      }
    }
 
    // Don't know the format, so it must be read from the file
    if (mFormat == (sampleFormat) 0)
    {
-      // Check sample format
-      wxFFile file(mFileName.GetFullPath(), wxT("rb"));
-      if (!file.IsOpened())
-      {
-         // Don't read into cache if file not available
-         return 0;
-      }
-   
-      auHeader header;
-   
-      if (file.Read(&header, sizeof(header)) != sizeof(header))
-      {
-         // Corrupt file
+      if (!ReadAuFormat(mFileName.GetFullPath(), mFormat))
          return 0;
-      }
-   
-      wxUint32 encoding;
-   
-      if (header.magic == 0x2e736e64)
-         encoding = header.encoding; // correct endianness
-      else
-         encoding = SwapUintEndianess(header.encoding);
-   
-      switch (encoding)
-      {
-      case AU_SAMPLE_FORMAT_16:
-         mFormat = int16Sample;
-         break;
-      case AU_SAMPLE_FORMAT_24:
-         mFormat = int24Sample;
-         break;
-      default:
-         // floatSample is a safe default (we will never loose data)
-         mFormat = floatSample;
-         break;
-      }
-   
-      file.Close();
    }
 
    return (
@@ -549,6 +1484,9 @@ auto SimpleBlockFile::GetSpaceUsage() const -> DiskByteCount
 }
 
 void SimpleBlockFile::Recover(){
+   SampleBlockCache::Get().Forget(this);
+   OpenBlockFiles::Get().Forget(this);
+
    wxFFile file(mFileName.GetFullPath(), wxT("wb"));
 
    if( !file.IsOpened() ){
@@ -578,16 +1516,24 @@ void SimpleBlockFile::Recover(){
 
 void SimpleBlockFile::WriteCacheToDisk()
 {
+   // Wait for a deferred write, which leaves nothing to do unless it failed
+   SimpleBlockFileWriter::Get().Finish(this, true);
+
    if (!GetNeedWriteCacheToDisk())
       return;
 
-   if (WriteSimpleBlockFile(mCache.sampleData.get(), mLen, mCache.format,
-                            mCache.summaryData.get()))
-      mCache.needWrite = false;
+   if (!WriteSimpleBlockFile(mCache.sampleData.get(), mLen, mCache.format,
+                             mCache.summaryData.get()))
+      throw FileException{
+         FileException::Cause::Write, mFileName };
+
+   ODLocker locker{ &mCacheMutex };
+   mCache.needWrite = false;
 }
 
 bool SimpleBlockFile::GetNeedWriteCacheToDisk()
 {
+   ODLocker locker{ &mCacheMutex };
    return mCache.active && mCache.needWrite;
 }
 
@@ -617,3 +1563,236 @@ static DirManager::RegisteredBlockFileDeserializer sRegistration {
       return SimpleBlockFile::BuildFromXML( dm, attrs );
    }
 };
+
+CompressedBlockFile::CompressedBlockFile(wxFileNameWrapper &&baseFileName,
+                                         samplePtr sampleData, size_t sampleLen,
+                                         sampleFormat format)
+   // Let the base class only set up, not write
+   : SimpleBlockFile{ std::move(baseFileName), sampleData, sampleLen, format,
+      false, true }
+{
+   if (!WriteCompressedBlockFile(sampleData, sampleLen, format))
+      throw FileException{
+         FileException::Cause::Write, GetFileName().name };
+}
+
+CompressedBlockFile::CompressedBlockFile(wxFileNameWrapper &&existingFile,
+                                         size_t len,
+                                         float min, float max, float rms)
+   : SimpleBlockFile{ std::move(existingFile), len, min, max, rms }
+{
+}
+
+bool CompressedBlockFile::WriteCompressedBlockFile(
+   samplePtr sampleData, size_t sampleLen, sampleFormat format)
+{
+   std::vector<int> integers(kMaxOrder + sampleLen);
+   unsigned scaleBits;
+   std::vector<unsigned char> payload;
+   bool compress = ToIntegers(sampleData, format, sampleLen,
+      integers.data() + kMaxOrder, scaleBits);
+   if (compress) {
+      PutLittleEndian(payload, scaleBits);
+      PutLittleEndian(payload, sampleLen);
+      BitWriter writer{ payload };
+      EncodeIntegers(integers.data() + kMaxOrder, sampleLen, writer);
+      compress = payload.size() < sampleLen * SAMPLE_SIZE_DISK(format);
+   }
+
+   if (!compress) {
+      // Not worth it; store the samples as SimpleBlockFile does
+      if (!WriteSimpleBlockFile(sampleData, sampleLen, format, nullptr))
+         return false;
+      mSpaceUsage = SimpleBlockFile::GetSpaceUsage();
+      return true;
+   }
+
+   wxFFile file(mFileName.GetFullPath(), wxT("wb"));
+   if( !file.IsOpened() )
+      return false;
+
+   auHeader header;
+   header.magic = 0x2e736e64;
+   header.dataOffset = sizeof(auHeader) + mSummaryInfo.totalSummaryBytes;
+   header.dataSize = payload.size();
+   switch(format) {
+      case int16Sample:
+         header.encoding = AU_SAMPLE_FORMAT_LOSSLESS_16;
+         break;
+      case int24Sample:
+         header.encoding = AU_SAMPLE_FORMAT_LOSSLESS_24;
+         break;
+      case floatSample:
+         header.encoding = AU_SAMPLE_FORMAT_LOSSLESS_FLOAT;
+         break;
+   }
+   header.sampleRate = 44100;
+   header.channels = 1;
+
+   ArrayOf<char> cleanup;
+   void *summaryData = CalcSummary(sampleData, sampleLen, format, cleanup);
+
+   const size_t nBytesToWrite =
+      sizeof(header) + mSummaryInfo.totalSummaryBytes + payload.size();
+   ArrayOf<char> buffer{ nBytesToWrite };
+   char *dest = buffer.get();
+   memcpy(dest, &header, sizeof(header));
+   dest += sizeof(header);
+   memcpy(dest, summaryData, mSummaryInfo.totalSummaryBytes);
+   dest += mSummaryInfo.totalSummaryBytes;
+   memcpy(dest, payload.data(), payload.size());
+
+   if (file.Write(buffer.get(), nBytesToWrite) != nBytesToWrite)
+      return false;
+
+   mSpaceUsage = nBytesToWrite;
+   return true;
+}
+
+SampleBlockCache::DataPtr CompressedBlockFile::ReadCompressed(
+   bool &plain, size_t count) const
+{
+   plain = false;
+   count = std::min(count, mLen);
+
+   Optional<wxLogNull> silence{};
+   if (mSilentLog)
+      silence.emplace();
+   wxFFile file(mFileName.GetFullPath(), wxT("rb"));
+   if (!file.IsOpened()) {
+      mSilentLog = TRUE;
+      return {};
+   }
+   mSilentLog = FALSE;
+
+   auHeader header;
+   if (file.Read(&header, sizeof(header)) != sizeof(header))
+      return {};
+
+   const bool swap = (header.magic != 0x2e736e64);
+   const auto encoding =
+      swap ? SwapUintEndianess(header.encoding) : header.encoding;
+   const auto dataOffset =
+      swap ? SwapUintEndianess(header.dataOffset) : header.dataOffset;
+
+   sampleFormat format;
+   switch (encoding) {
+      case AU_SAMPLE_FORMAT_LOSSLESS_16:
+         format = int16Sample;
+         break;
+      case AU_SAMPLE_FORMAT_LOSSLESS_24:
+         format = int24Sample;
+         break;
+      case AU_SAMPLE_FORMAT_LOSSLESS_FLOAT:
+         format = floatSample;
+         break;
+      default:
+         plain = true;
+         return {};
+   }
+
+   const auto fileLength = file.Length();
+   if (fileLength < 0 || wxFileOffset(dataOffset) + 8 > fileLength ||
+       !file.Seek(dataOffset))
+      return {};
+   const auto nBytes = size_t(fileLength - dataOffset);
+   ArrayOf<unsigned char> bytes{ nBytes };
+   if (file.Read(bytes.get(), nBytes) != nBytes)
+      return {};
+
+   const auto scaleBits = GetLittleEndian(bytes.get());
+   if (scaleBits > kFloatScaleBits || GetLittleEndian(bytes.get() + 4) != mLen)
+      return {};
+
+   // Decoding is sequential, so what follows the samples wanted is skipped
+   std::vector<int> integers(kMaxOrder + count);
+   BitReader reader{ bytes.get() + 8, bytes.get() + nBytes };
+   if (!DecodeIntegers(reader, integers.data() + kMaxOrder, count))
+      return {};
+
+   auto pData = std::make_shared<SampleBlockCache::Data>();
+   pData->format = format;
+   pData->size = count * SAMPLE_SIZE(format);
+   pData->bytes.reinit(pData->size);
+   FromIntegers(integers.data() + kMaxOrder, count, scaleBits,
+      pData->bytes.get(), format);
+
+   auto &cache = SampleBlockCache::Get();
+   if (count == mLen && cache.Enabled())
+      cache.Store({ this, false }, pData);
+   return pData;
+}
+
+size_t CompressedBlockFile::ReadData(samplePtr data, sampleFormat format,
+                        size_t start, size_t len, bool mayThrow) const
+{
+   auto &cache = SampleBlockCache::Get();
+   SampleBlockCache::DataPtr pData;
+   if (cache.Enabled())
+      pData = cache.Find({ this, false });
+   if (!pData) {
+      // Without the cache, decode no further than the samples wanted
+      const auto count =
+         cache.Enabled() ? mLen : std::min(mLen, start + len);
+      bool plain;
+      pData = ReadCompressed(plain, count);
+      if (plain)
+         return SimpleBlockFile::ReadData(data, format, start, len, mayThrow);
+   }
+
+   if (!pData) {
+      if (mayThrow)
+         throw FileException{ FileException::Cause::Read, mFileName };
+      ClearSamples(data, format, 0, len);
+      return 0;
+   }
+
+   const auto decoded = pData->size / SAMPLE_SIZE(pData->format);
+   return ReadFromMemory(pData->bytes.get(), pData->format, decoded,
+      data, format, start, len, mayThrow, mFileName, false);
+}
+
+void CompressedBlockFile::SaveXML(XMLWriter &xmlFile)
+// may throw
+{
+   xmlFile.StartTag(wxT("compressedblockfile"));
+
+   xmlFile.WriteAttr(wxT("filename"), mFileName.GetFullName());
+   xmlFile.WriteAttr(wxT("len"), mLen);
+   xmlFile.WriteAttr(wxT("min"), mMin);
+   xmlFile.WriteAttr(wxT("max"), mMax);
+   xmlFile.WriteAttr(wxT("rms"), mRMS);
+
+   xmlFile.EndTag(wxT("compressedblockfile"));
+}
+
+/// static
+BlockFilePtr CompressedBlockFile::BuildFromXML(
+   DirManager &dm, const wxChar **attrs)
+{
+   return BuildSimpleBlockFileFromXML<CompressedBlockFile>(dm, attrs);
+}
+
+BlockFilePtr CompressedBlockFile::Copy(wxFileNameWrapper &&newFileName)
+{
+   return make_blockfile<CompressedBlockFile>
+      (std::move(newFileName), mLen, mMin, mMax, mRMS);
+}
+
+auto CompressedBlockFile::GetSpaceUsage() const -> DiskByteCount
+{
+   if (mSpaceUsage == 0) {
+      const auto size = mFileName.GetSize();
+      if (size == wxInvalidSize)
+         return 0;
+      mSpaceUsage = size.GetValue();
+   }
+   return mSpaceUsage;
+}
+
+static DirManager::RegisteredBlockFileDeserializer sCompressedRegistration {
+   "compressedblockfile",
+   []( DirManager &dm, const wxChar **attrs ){
+      return CompressedBlockFile::BuildFromXML( dm, attrs );
+   }
+};
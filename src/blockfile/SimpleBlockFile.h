@@ -13,7 +13,14 @@
 
 #include "../BlockFile.h"
 
+#include <atomic>
+#include <functional>
+#include <list>
+#include <map>
+
 class DirManager;
+class CompressedBlockFile;
+class SimpleBlockFileWriter;
 
 struct SimpleBlockFileCache {
    bool active;
@@ -29,6 +36,14 @@ enum {
    AU_SAMPLE_FORMAT_16 = 3,
    AU_SAMPLE_FORMAT_24 = 4,
    AU_SAMPLE_FORMAT_FLOAT = 6,
+
+   // Private encodings, written by CompressedBlockFile: what follows the
+   // summary is compressed, and decodes to samples of the format named
+   AU_SAMPLE_FORMAT_LOSSLESS = 0x100,
+   AU_SAMPLE_FORMAT_LOSSLESS_16 = AU_SAMPLE_FORMAT_LOSSLESS | AU_SAMPLE_FORMAT_16,
+   AU_SAMPLE_FORMAT_LOSSLESS_24 = AU_SAMPLE_FORMAT_LOSSLESS | AU_SAMPLE_FORMAT_24,
+   AU_SAMPLE_FORMAT_LOSSLESS_FLOAT =
+      AU_SAMPLE_FORMAT_LOSSLESS | AU_SAMPLE_FORMAT_FLOAT,
 };
 
 typedef struct {
@@ -40,12 +55,78 @@ typedef struct {
    wxUint32 channels;   // number of interleaved channels
 } auHeader;
 
+/// A process-wide cache of the samples and summaries of SimpleBlockFiles, as
+/// read from disk, limited to a memory budget by evicting what was least
+/// recently used.  Blocks read by playback are pinned until it stops, but
+/// only up to half of the budget; beyond that they are evicted as usual.
+class PROFILE_DLL_API SampleBlockCache {
+ public:
+   static SampleBlockCache &Get();
+
+   struct Statistics {
+      unsigned long long hits, misses, evictions;
+      size_t bytes, budget;
+   };
+   Statistics GetStatistics();
+
+   /// Reads the budget from preferences; a budget of zero disables the cache
+   void ReadPrefs();
+   /// Frees everything and zeroes the statistics
+   void Clear();
+
+   /// While one of these exists, whatever this thread reads stays cached
+   /// until Unpin() is called
+   class Pinning {
+    public:
+      Pinning();
+      ~Pinning();
+   };
+   void Unpin();
+
+ private:
+   friend class SimpleBlockFile;
+   friend class CompressedBlockFile;
+
+   struct Data {
+      sampleFormat format;
+      ArrayOf<char> bytes;
+      size_t size;
+   };
+   using DataPtr = std::shared_ptr<const Data>;
+   using Key = std::pair<const SimpleBlockFile*, bool /* summary */>;
+
+   DataPtr Find(const Key &key);
+   void Store(const Key &key, DataPtr pData);
+   void Forget(const SimpleBlockFile *pBlock);
+   bool Enabled() const { return mBudget > 0; }
+
+   void Evict(); // while mLock is held
+   struct Entry;
+   void SetPinned(Entry &entry, bool pinned); // while mLock is held
+
+   struct Entry {
+      DataPtr pData;
+      bool pinned;
+      std::list<Key>::iterator lru;
+   };
+
+   ODLock mLock;
+   std::map<Key, Entry> mEntries;
+   std::list<Key> mLRU; // most recent at the front
+   size_t mBytes{ 0 };
+   size_t mPinnedBytes{ 0 };
+   std::atomic<size_t> mBudget{ 0 };
+   unsigned long long mHits{ 0 }, mMisses{ 0 }, mEvictions{ 0 };
+};
+
 class PROFILE_DLL_API SimpleBlockFile /* not final */ : public BlockFile {
  public:
 
    // Constructor / Destructor
 
-   /// Create a disk file and write summary and sample data to it
+   /// Create a disk file and write summary and sample data to it.
+   /// With allowDeferredWrite, the file is written by a background thread,
+   /// and the data are read from memory until it has been.
    SimpleBlockFile(wxFileNameWrapper &&baseFileName,
                    samplePtr sampleData, size_t sampleLen,
                    sampleFormat format,
@@ -82,6 +163,13 @@ class PROFILE_DLL_API SimpleBlockFile /* not final */ : public BlockFile {
 
    void FillCache() /* noexcept */ override;
 
+   /// Makes sure the file is on disk before giving out its name
+   GetFileNameResult GetFileName() const override;
+
+   /// Runs the action, on another thread, once the files of all the
+   /// SimpleBlockFiles made so far with allowDeferredWrite are on disk
+   static void AfterDeferredWrites(std::function< void() > action);
+
  protected:
 
    bool WriteSimpleBlockFile(samplePtr sampleData, size_t sampleLen,
@@ -92,7 +180,56 @@ class PROFILE_DLL_API SimpleBlockFile /* not final */ : public BlockFile {
    SimpleBlockFileCache mCache;
 
  private:
+   friend SimpleBlockFileWriter;
+   bool WriteBehind();
+
+   SampleBlockCache::DataPtr ReadIntoBlockCache() const;
+
    mutable sampleFormat mFormat; // may be found lazily
+
+   // Guards mCache against the background writer, which empties it once
+   // a deferred write is done
+   mutable ODLock mCacheMutex;
+   // Whether the file is queued for the background writer, or being written
+   std::atomic<bool> mWritePending{ false };
+};
+
+/// A SimpleBlockFile whose samples are stored losslessly compressed, with
+/// fixed polynomial prediction and Rice coding of the residuals.  The summary
+/// is stored uncompressed as before.  Samples that do not compress, such as
+/// floats that are not exactly scaled integers, are stored as in
+/// SimpleBlockFile.  Deferred writing (for recording) is not supported.
+class PROFILE_DLL_API CompressedBlockFile final : public SimpleBlockFile {
+ public:
+
+   /// Create a disk file and write summary and compressed sample data to it
+   CompressedBlockFile(wxFileNameWrapper &&baseFileName,
+                       samplePtr sampleData, size_t sampleLen,
+                       sampleFormat format);
+   /// Create the memory structure to refer to the given block file
+   CompressedBlockFile(wxFileNameWrapper &&existingFile, size_t len,
+                       float min, float max, float rms);
+
+   size_t ReadData(samplePtr data, sampleFormat format,
+                        size_t start, size_t len, bool mayThrow) const override;
+
+   BlockFilePtr Copy(wxFileNameWrapper &&newFileName) override;
+   void SaveXML(XMLWriter &xmlFile) override;
+
+   DiskByteCount GetSpaceUsage() const override;
+
+   static BlockFilePtr BuildFromXML(DirManager &dm, const wxChar **attrs);
+
+ private:
+   bool WriteCompressedBlockFile(samplePtr sampleData, size_t sampleLen,
+                                 sampleFormat format);
+
+   /// Decodes the first count samples, storing them in the cache if they
+   /// are all of them.  Returns null, setting plain, if the file holds
+   /// uncompressed samples instead; or null on failure
+   SampleBlockCache::DataPtr ReadCompressed(bool &plain, size_t count) const;
+
+   mutable DiskByteCount mSpaceUsage{ 0 }; // may be found lazily
 };
 
 #endif
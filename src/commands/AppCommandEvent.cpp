@@ -35,6 +35,7 @@ AppCommandEvent::AppCommandEvent(wxEventType commandType, int id)
 AppCommandEvent::AppCommandEvent(const AppCommandEvent &event)
    : wxCommandEvent(event)
    , mCommand(event.mCommand)
+   , mDeferRedraw(event.mDeferRedraw)
 {
 }
 
@@ -59,3 +60,13 @@ OldStyleCommandPointer AppCommandEvent::GetCommand()
 {
    return mCommand;
 }
+
+void AppCommandEvent::SetDeferRedraw(bool defer)
+{
+   mDeferRedraw = defer;
+}
+
+bool AppCommandEvent::GetDeferRedraw() const
+{
+   return mDeferRedraw;
+}
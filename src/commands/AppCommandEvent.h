@@ -30,6 +30,7 @@ class AppCommandEvent final : public wxCommandEvent
 {
 private:
    OldStyleCommandPointer mCommand;
+   bool mDeferRedraw{ false };
 
 public:
    AppCommandEvent(wxEventType commandType = wxEVT_APP_COMMAND_RECEIVED, int id = 0);
@@ -41,6 +42,10 @@ public:
    void SetCommand(const OldStyleCommandPointer &cmd);
    OldStyleCommandPointer GetCommand();
 
+   // Commands posted together, as a script's are, may share one redraw
+   void SetDeferRedraw(bool defer);
+   bool GetDeferRedraw() const;
+
 private:
    DECLARE_DYNAMIC_CLASS(AppCommandEvent)
 };
@@ -19,6 +19,7 @@
 #include "../Audacity.h"
 #include "CommandHandler.h"
 
+#include <wx/app.h>
 #include <wx/event.h>
 #include "../Project.h"
 #include "../ProjectWindow.h"
@@ -50,7 +51,20 @@ void CommandHandler::OnReceiveCommand(AppCommandEvent &event)
       });
       wxUnusedVar(result);
 
-      // Redraw the project
-      ProjectWindow::Get( context.project ).RedrawProject();
+      // Redraw the project now, unless other commands are queued behind
+      // this one, in which case do it once after them all
+      if (!event.GetDeferRedraw()) {
+         ProjectWindow::Get( context.project ).RedrawProject();
+         return;
+      }
+      mRedrawProject = &context.project;
+      if (!mRedrawPending) {
+         mRedrawPending = true;
+         wxTheApp->CallAfter( [this]{
+            mRedrawPending = false;
+            if (mRedrawProject)
+               ProjectWindow::Get( *mRedrawProject ).RedrawProject();
+         } );
+      }
    }
 }
@@ -17,6 +17,7 @@
 #define __COMMANDHANDLER__
 
 #include "../MemoryX.h"
+#include <wx/weakref.h> // member variable
 class AudacityApp;
 class AudacityProject;
 class AppCommandEvent;
@@ -30,6 +31,12 @@ class CommandHandler
 
       // Whenever a command is received, process it.
       void OnReceiveCommand(AppCommandEvent &event);
+
+   private:
+      // Commands that arrive together (as a script batch does) share one
+      // redraw, of the last project they touched
+      bool mRedrawPending{ false };
+      wxWeakRef<AudacityProject> mRedrawProject;
 };
 
 #endif /* End of include guard: __COMMANDHANDLER__ */
@@ -36,6 +36,8 @@ This class now lists
 #include "../WaveTrack.h"
 #include "../LabelTrack.h"
 #include "../Envelope.h"
+#include "../ProjectAudioIO.h"
+#include "../widgets/MeterPanelBase.h"
 
 #include "SelectCommand.h"
 #include "../ShuttleGui.h"
@@ -64,6 +66,7 @@ enum {
    kEnvelopes,
    kLabels,
    kBoxes,
+   kMeters,
    nTypes
 };
 
@@ -78,6 +81,7 @@ static const EnumValueSymbol kTypes[nTypes] =
    { XO("Envelopes") },
    { XO("Labels") },
    { XO("Boxes") },
+   { XO("Meters") },
 };
 
 enum {
@@ -158,6 +162,7 @@ bool GetInfoCommand::ApplyInner(const CommandContext &context)
       case kEnvelopes    : return SendEnvelopes( context );
       case kLabels       : return SendLabels( context );
       case kBoxes        : return SendBoxes( context );
+      case kMeters       : return SendMeters( context );
       default:
          context.Status( "Command options not recognised" );
    }
@@ -527,6 +532,38 @@ bool GetInfoCommand::SendClips(const CommandContext &context)
    return true;
 }
 
+bool GetInfoCommand::SendMeters(const CommandContext &context)
+{
+   auto &projectAudioIO = ProjectAudioIO::Get( context.project );
+   const std::pair< const char *, MeterPanelBase * > meters[] = {
+      { "playback", projectAudioIO.GetPlaybackMeter() },
+      { "recording", projectAudioIO.GetCaptureMeter() },
+   };
+
+   context.StartArray();
+   for (const auto &meter : meters) {
+      if (!meter.second)
+         continue;
+      context.StartStruct();
+      context.AddItem( meter.first, "meter" );
+      context.StartField( "channels" );
+      context.StartArray();
+      for (const auto &levels : meter.second->GetChannelLevels()) {
+         context.StartStruct();
+         context.AddItem( levels.peak, "peak" );
+         context.AddItem( levels.rms, "rms" );
+         context.AddBool( levels.clipping, "clipping" );
+         context.EndStruct();
+      }
+      context.EndArray();
+      context.EndField();
+      context.EndStruct();
+   }
+   context.EndArray();
+
+   return true;
+}
+
 bool GetInfoCommand::SendEnvelopes(const CommandContext &context)
 {
    auto &tracks = TrackList::Get( context.project );
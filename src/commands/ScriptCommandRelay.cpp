@@ -26,17 +26,27 @@ code out of ModuleManager.
 #include "AppCommandEvent.h"
 #include "../Project.h"
 #include <wx/app.h>
+#include <wx/arrstr.h>
 #include <wx/string.h>
+#include <future>
 #include <thread>
+#include <vector>
 
-/// This is the function which actually obeys one command.
-static int ExecCommand(wxString *pIn, wxString *pOut, bool fromMain)
+using CommandBuilders = std::vector< std::unique_ptr<CommandBuilder> >;
+
+/// Builds the commands and sends them to be obeyed, returning the builders
+/// from which their responses can be collected.  Call this on the main
+/// thread.
+static CommandBuilders PostCommands(const wxArrayString &lines, bool fromMain)
 {
+   CommandBuilders builders;
+   for (const auto &line : lines)
    {
-      CommandBuilder builder(::GetActiveProject(), *pIn);
-      if (builder.WasValid())
+      auto builder =
+         std::make_unique<CommandBuilder>(::GetActiveProject(), line);
+      if (builder->WasValid())
       {
-         OldStyleCommandPointer cmd = builder.GetCommand();
+         OldStyleCommandPointer cmd = builder->GetCommand();
 
          AppCommandEvent ev;
          ev.SetCommand(cmd);
@@ -49,13 +59,66 @@ static int ExecCommand(wxString *pIn, wxString *pOut, bool fromMain)
          }
          else
          {
-            // Send the event to the main thread
+            // Queue the event, so that all the commands of a batch are built
+            // for the project that is active now, and then run back to back
+            ev.SetDeferRedraw(lines.size() > 1);
             wxTheApp->AddPendingEvent(ev);
          }
       }
+      builders.push_back(std::move(builder));
+   }
+   return builders;
+}
 
-      // Wait for and retrieve the response
-      *pOut = builder.GetResponse();
+/// This is the function which actually obeys one command, or a batch of
+/// commands given one per line.
+static int ExecCommand(wxString *pIn, wxString *pOut, bool fromMain)
+{
+   wxArrayString lines;
+   if (!pIn->Contains(wxT("\n")))
+      lines.push_back(*pIn);
+   else
+   {
+      for (const auto &line : wxSplit(*pIn, wxT('\n'), wxT('\0')))
+      {
+         if (!line.empty())
+            lines.push_back(line);
+      }
+   }
+
+   CommandBuilders builders;
+   if (fromMain)
+      builders = PostCommands(lines, true);
+   else
+   {
+      // Commands are built on the main thread too; wait for that
+      std::promise< CommandBuilders > promise;
+      auto future = promise.get_future();
+      wxTheApp->CallAfter( [&] {
+         try {
+            promise.set_value(PostCommands(lines, false));
+         }
+         catch (...) {
+            promise.set_exception(std::current_exception());
+         }
+      } );
+      try {
+         builders = future.get();
+      }
+      catch (...) {
+         *pOut = wxT("Failed!\n");
+         return 0;
+      }
+   }
+
+   // Wait for and retrieve the responses, separated just as if the commands
+   // had been sent one at a time
+   *pOut = wxEmptyString;
+   for (auto &builder : builders)
+   {
+      if (!pOut->empty())
+         *pOut += wxT("\n");
+      *pOut += builder->GetResponse();
    }
 
    return 0;
@@ -230,9 +230,8 @@ bool EffectChangePitch::Process()
       // ensure that m_dSemitonesChange is set.
       Calc_SemitonesChange_fromPercentChange();
 
-      mSoundTouch = std::make_unique<soundtouch::SoundTouch>();
+      mSoundTouch = MakeSoundTouch();
       IdentityTimeWarper warper;
-      mSoundTouch->setPitchSemiTones((float)(m_dSemitonesChange));
 #ifdef USE_MIDI
       // Pitch shifting note tracks is currently only supported by SoundTouchEffect
       // and non-real-time-preview effects require an audio track selection.
@@ -431,6 +430,15 @@ bool EffectChangePitch::TransferDataFromWindow()
    return true;
 }
 
+// EffectSoundTouch implementation
+
+std::unique_ptr<soundtouch::SoundTouch> EffectChangePitch::MakeSoundTouch() const
+{
+   auto soundTouch = std::make_unique<soundtouch::SoundTouch>();
+   soundTouch->setPitchSemiTones((float)(m_dSemitonesChange));
+   return soundTouch;
+}
+
 // EffectChangePitch implementation
 
 // Deduce m_FromFrequency from the samples at the beginning of
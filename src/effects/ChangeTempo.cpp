@@ -212,8 +212,7 @@ bool EffectChangeTempo::Process()
    else
 #endif
    {
-      mSoundTouch = std::make_unique<soundtouch::SoundTouch>();
-      mSoundTouch->setTempoChange(m_PercentChange);
+      mSoundTouch = MakeSoundTouch();
       double mT1Dashed = mT0 + (mT1 - mT0)/(m_PercentChange/100.0 + 1.0);
       RegionTimeWarper warper{ mT0, mT1,
          std::make_unique<LinearTimeWarper>(mT0, mT0, mT1, mT1Dashed )  };
@@ -368,6 +367,15 @@ bool EffectChangeTempo::TransferDataFromWindow()
    return true;
 }
 
+// EffectSoundTouch implementation
+
+std::unique_ptr<soundtouch::SoundTouch> EffectChangeTempo::MakeSoundTouch() const
+{
+   auto soundTouch = std::make_unique<soundtouch::SoundTouch>();
+   soundTouch->setTempoChange(m_PercentChange);
+   return soundTouch;
+}
+
 // handler implementations for EffectChangeTempo
 
 void EffectChangeTempo::OnText_PercentChange(wxCommandEvent & WXUNUSED(evt))
@@ -63,6 +63,10 @@ public:
    bool TransferDataToWindow() override;
    bool TransferDataFromWindow() override;
 
+   // EffectSoundTouch implementation
+
+   std::unique_ptr<soundtouch::SoundTouch> MakeSoundTouch() const override;
+
 private:
    // EffectChangeTempo implementation
 
@@ -28,7 +28,10 @@
 #include "ClickRemoval.h"
 #include "LoadEffects.h"
 
+#include <algorithm>
 #include <math.h>
+#include <thread>
+#include <vector>
 
 #include <wx/intl.h>
 #include <wx/slider.h>
@@ -225,47 +228,85 @@ bool EffectClickRemoval::ProcessOne(int count, WaveTrack * track, sampleCount st
    if (idealBlockLen % windowSize != 0)
       idealBlockLen += (windowSize - (idealBlockLen % windowSize));
 
+   // Each block is cleaned independently of the others, so read a batch of
+   // blocks here, clean them on worker threads, and write back in order
+   // those that changed.  A batch holds 32 MB of samples, two blocks for
+   // each thread when they fit, and blocks too long to give every thread
+   // one are cut at a window boundary.
+   const size_t batchSamples = (1 << 23);
+   const size_t nThreads = std::max(1u, std::thread::hardware_concurrency());
+   if (idealBlockLen * nThreads > batchSamples)
+      idealBlockLen = std::max(windowSize,
+         batchSamples / nThreads / windowSize * windowSize);
+   const size_t batchSize = std::max<size_t>(1,
+      std::min(2 * nThreads, batchSamples / idealBlockLen));
    bool bResult = true;
    decltype(len) s = 0;
-   Floats buffer{ idealBlockLen };
-   Floats datawindow{ windowSize };
+   Floats buffer{ batchSize * idealBlockLen };
+   Floats datawindows{ batchSize * windowSize };
+   std::vector<size_t> blockLens(batchSize);
+   ArrayOf<bool> changed{ batchSize };
    while ((len - s) > windowSize / 2)
    {
-      auto block = limitSampleBufferSize( idealBlockLen, len - s );
+      size_t nBlocks = 0;
+      for (auto next = s;
+           (len - next) > windowSize / 2 && nBlocks < batchSize;
+           next += blockLens[nBlocks++])
+      {
+         auto block = limitSampleBufferSize( idealBlockLen, len - next );
+         track->Get((samplePtr) &buffer[nBlocks * idealBlockLen],
+            floatSample, start + next, block);
+         blockLens[nBlocks] = block;
+      }
 
-      track->Get((samplePtr) buffer.get(), floatSample, start + s, block);
+      ParallelFor(nBlocks, [&](size_t b){
+         float *blockBuffer = &buffer[b * idealBlockLen];
+         const auto block = blockLens[b];
+         float *datawindow = &datawindows[b * windowSize];
+         changed[b] = false;
 
-      for (decltype(block) i = 0; i + windowSize / 2 < block; i += windowSize / 2)
-      {
-         auto wcopy = std::min( windowSize, block - i );
+         for (decltype(block) i = 0; i + windowSize / 2 < block; i += windowSize / 2)
+         {
+            auto wcopy = std::min( windowSize, block - i );
 
-         for(decltype(wcopy) j = 0; j < wcopy; j++)
-            datawindow[j] = buffer[i+j];
-         for(auto j = wcopy; j < windowSize; j++)
-            datawindow[j] = 0;
+            for(decltype(wcopy) j = 0; j < wcopy; j++)
+               datawindow[j] = blockBuffer[i+j];
+            for(auto j = wcopy; j < windowSize; j++)
+               datawindow[j] = 0;
 
-         mbDidSomething |= RemoveClicks(windowSize, datawindow.get());
+            if (RemoveClicks(windowSize, datawindow))
+               changed[b] = true;
 
-         for(decltype(wcopy) j = 0; j < wcopy; j++)
-           buffer[i+j] = datawindow[j];
-      }
+            for(decltype(wcopy) j = 0; j < wcopy; j++)
+              blockBuffer[i+j] = datawindow[j];
+         }
+      });
 
-      if (mbDidSomething) // RemoveClicks() actually did something.
-         track->Set((samplePtr) buffer.get(), floatSample, start + s, block);
+      for (size_t b = 0; b < nBlocks; b++)
+      {
+         if (changed[b]) { // RemoveClicks() actually did something.
+            mbDidSomething = true;
+            track->Set((samplePtr) &buffer[b * idealBlockLen],
+               floatSample, start + s, blockLens[b]);
+         }
 
-      s += block;
+         s += blockLens[b];
 
-      if (TrackProgress(count, s.as_double() /
-                               len.as_double())) {
-         bResult = false;
-         break;
+         if (TrackProgress(count, s.as_double() /
+                                  len.as_double())) {
+            bResult = false;
+            break;
+         }
       }
+
+      if (!bResult)
+         break;
    }
 
    return bResult;
 }
 
-bool EffectClickRemoval::RemoveClicks(size_t len, float *buffer)
+bool EffectClickRemoval::RemoveClicks(size_t len, float *buffer) const
 {
    bool bResult = false; // This effect usually does nothing.
    size_t i;
@@ -274,7 +315,6 @@ bool EffectClickRemoval::RemoveClicks(size_t len, float *buffer)
 
    float msw;
    int ww;
-   int s2 = sep/2;
    Floats ms_seq{ len };
    Floats b2{ len };
 
@@ -293,10 +333,11 @@ bool EffectClickRemoval::RemoveClicks(size_t len, float *buffer)
    }
 
    /* Cheat by truncating sep to next-lower power of two... */
-   sep = i;
+   const size_t truncSep = i;
+   const int s2 = truncSep/2;
 
-   for( i=0; i<len-sep; i++ ) {
-      ms_seq[i] /= sep;
+   for( i=0; i<len-truncSep; i++ ) {
+      ms_seq[i] /= truncSep;
    }
    /* ww runs from about 4 to mClickWidth.  wrc is the reciprocal;
     * chosen so that integer roundoff doesn't clobber us.
@@ -305,7 +346,7 @@ bool EffectClickRemoval::RemoveClicks(size_t len, float *buffer)
    for(wrc=mClickWidth/4; wrc>=1; wrc /= 2) {
       ww = mClickWidth/wrc;
 
-      for( i=0; i<len-sep; i++ ){
+      for( i=0; i<len-truncSep; i++ ){
          msw = 0;
          for( j=0; (int)j<ww; j++) {
             msw += b2[i+s2+j];
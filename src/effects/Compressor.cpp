@@ -30,6 +30,14 @@
 
 #include <math.h>
 
+#include "../CPUFeatures.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+   (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COMPRESSOR_SSE2
+#include <emmintrin.h>
+#endif
+
 #include <wx/brush.h>
 #include <wx/checkbox.h>
 #include <wx/dcclient.h>
@@ -77,6 +85,245 @@ const ComponentInterfaceSymbol EffectCompressor::Symbol
 
 namespace{ BuiltinEffectsModule::Registration< EffectCompressor > reg; }
 
+namespace {
+
+float GainScalar(float *buffer, const float *env, size_t len,
+   double level, double compression, float max)
+{
+   for (size_t i = 0; i < len; i++) {
+      float out = buffer[i] * pow(level/env[i], compression);
+
+      if(max < fabs(out))
+         max = fabs(out);
+
+      buffer[i] = out;
+   }
+   return max;
+}
+
+void DecayScalar(float *values, size_t len,
+   double factor, double floor, double &last, bool backward)
+{
+   for (size_t j = 0; j < len; j++) {
+      float &value = values[backward ? len - 1 - j : j];
+      last *= factor;
+      if(last < floor)
+         last = floor;
+      if(value > last)
+         last = value;
+      else
+         value = last;
+   }
+}
+
+#ifdef COMPRESSOR_SSE2
+
+// x^c for four positive, finite x, as 2^(c * log2(x)).  Agrees with pow()
+// to within a few float ulps, which is all the gain computation needs.
+inline __m128 PowPositive(__m128 x, __m128 c)
+{
+   const __m128 one = _mm_set1_ps(1.0f);
+
+   // Split x into exponent and a mantissa folded into [sqrt(1/2), sqrt(2))
+   const __m128i bits = _mm_castps_si128(x);
+   __m128i e = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127));
+   __m128 m = _mm_or_ps(
+      _mm_and_ps(x, _mm_castsi128_ps(_mm_set1_epi32(0x007fffff))), one);
+   const __m128 big = _mm_cmpgt_ps(m, _mm_set1_ps(1.41421356f));
+   m = _mm_or_ps(_mm_andnot_ps(big, m),
+      _mm_and_ps(big, _mm_mul_ps(m, _mm_set1_ps(0.5f))));
+   e = _mm_sub_epi32(e, _mm_castps_si128(big));
+
+   // log(m) = 2 atanh((m - 1) / (m + 1))
+   const __m128 f = _mm_div_ps(_mm_sub_ps(m, one), _mm_add_ps(m, one));
+   const __m128 f2 = _mm_mul_ps(f, f);
+   __m128 p = _mm_set1_ps(1.0f / 9);
+   p = _mm_add_ps(_mm_mul_ps(p, f2), _mm_set1_ps(1.0f / 7));
+   p = _mm_add_ps(_mm_mul_ps(p, f2), _mm_set1_ps(1.0f / 5));
+   p = _mm_add_ps(_mm_mul_ps(p, f2), _mm_set1_ps(1.0f / 3));
+   p = _mm_add_ps(_mm_mul_ps(p, f2), one);
+   p = _mm_mul_ps(p, _mm_mul_ps(f, _mm_set1_ps(2.0f / 0.69314718f)));
+
+   __m128 y = _mm_mul_ps(c, _mm_add_ps(_mm_cvtepi32_ps(e), p));
+   y = _mm_max_ps(_mm_min_ps(y, _mm_set1_ps(127.0f)), _mm_set1_ps(-126.0f));
+
+   // 2^y = 2^n * exp(r ln 2), |r| <= 1/2
+   const __m128i n = _mm_cvtps_epi32(y);
+   const __m128 r = _mm_mul_ps(_mm_sub_ps(y, _mm_cvtepi32_ps(n)),
+      _mm_set1_ps(0.69314718f));
+   __m128 q = _mm_set1_ps(1.0f / 5040);
+   q = _mm_add_ps(_mm_mul_ps(q, r), _mm_set1_ps(1.0f / 720));
+   q = _mm_add_ps(_mm_mul_ps(q, r), _mm_set1_ps(1.0f / 120));
+   q = _mm_add_ps(_mm_mul_ps(q, r), _mm_set1_ps(1.0f / 24));
+   q = _mm_add_ps(_mm_mul_ps(q, r), _mm_set1_ps(1.0f / 6));
+   q = _mm_add_ps(_mm_mul_ps(q, r), _mm_set1_ps(0.5f));
+   q = _mm_add_ps(_mm_mul_ps(q, r), one);
+   q = _mm_add_ps(_mm_mul_ps(q, r), one);
+
+   return _mm_mul_ps(q, _mm_castsi128_ps(
+      _mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23)));
+}
+
+float GainSSE2(float *buffer, const float *env, size_t len,
+   double level, double compression, float max)
+{
+   const __m128 vlevel = _mm_set1_ps((float)level);
+   const __m128 vcompression = _mm_set1_ps((float)compression);
+   const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+   __m128 vmax = _mm_set1_ps(max);
+   size_t i = 0;
+   for (; i + 4 <= len; i += 4) {
+      const __m128 gain = PowPositive(
+         _mm_div_ps(vlevel, _mm_loadu_ps(env + i)), vcompression);
+      const __m128 out = _mm_mul_ps(_mm_loadu_ps(buffer + i), gain);
+      _mm_storeu_ps(buffer + i, out);
+      vmax = _mm_max_ps(vmax, _mm_and_ps(out, absMask));
+   }
+   vmax = _mm_max_ps(vmax, _mm_movehl_ps(vmax, vmax));
+   vmax = _mm_max_ss(vmax, _mm_shuffle_ps(vmax, vmax, 1));
+   return GainScalar(buffer + i, env + i, len - i,
+      level, compression, _mm_cvtss_f32(vmax));
+}
+
+// Two values at a time, in double precision like the scalar loop: each is
+// raised to the floor, then to factor times the other value of the pair,
+// then to factor or factor squared times the last value of the pair before.
+// A factor not more than 1 makes that the same as one value at a time.
+void DecaySSE2(float *values, size_t len,
+   double factor, double floor, double &last, bool backward)
+{
+   const __m128d vfloor = _mm_set1_pd(floor);
+   const __m128d vfactor = _mm_set1_pd(factor);
+   const __m128d powers = _mm_set_pd(factor * factor, factor);
+   __m128d carry = _mm_set1_pd(last);
+   size_t i = 0;
+   for (; i + 2 <= len; i += 2) {
+      const auto pair = (__m64 *)(backward ? values + len - i - 2 : values + i);
+      __m128d x = _mm_cvtps_pd(_mm_loadl_pi(_mm_setzero_ps(), pair));
+      if (backward)
+         x = _mm_shuffle_pd(x, x, 1);
+      x = _mm_max_pd(x, vfloor);
+      x = _mm_max_pd(x,
+         _mm_mul_pd(_mm_unpacklo_pd(_mm_setzero_pd(), x), vfactor));
+      x = _mm_max_pd(x, _mm_mul_pd(carry, powers));
+      carry = _mm_unpackhi_pd(x, x);
+      if (backward)
+         x = _mm_shuffle_pd(x, x, 1);
+      _mm_storel_pi(pair, _mm_cvtpd_ps(x));
+   }
+   last = _mm_cvtsd_f64(carry);
+   DecayScalar(backward ? values : values + i, len - i,
+      factor, floor, last, backward);
+}
+
+#endif
+
+#ifdef CPU_AVX_KERNELS
+
+// PowPositive, for eight values
+CPU_TARGET("avx2")
+inline __m256 PowPositiveAVX2(__m256 x, __m256 c)
+{
+   const __m256 one = _mm256_set1_ps(1.0f);
+
+   const __m256i bits = _mm256_castps_si256(x);
+   __m256i e = _mm256_sub_epi32(
+      _mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127));
+   __m256 m = _mm256_or_ps(
+      _mm256_and_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(0x007fffff))),
+      one);
+   const __m256 big =
+      _mm256_cmp_ps(m, _mm256_set1_ps(1.41421356f), _CMP_GT_OQ);
+   m = _mm256_blendv_ps(m, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), big);
+   e = _mm256_sub_epi32(e, _mm256_castps_si256(big));
+
+   const __m256 f =
+      _mm256_div_ps(_mm256_sub_ps(m, one), _mm256_add_ps(m, one));
+   const __m256 f2 = _mm256_mul_ps(f, f);
+   __m256 p = _mm256_set1_ps(1.0f / 9);
+   p = _mm256_add_ps(_mm256_mul_ps(p, f2), _mm256_set1_ps(1.0f / 7));
+   p = _mm256_add_ps(_mm256_mul_ps(p, f2), _mm256_set1_ps(1.0f / 5));
+   p = _mm256_add_ps(_mm256_mul_ps(p, f2), _mm256_set1_ps(1.0f / 3));
+   p = _mm256_add_ps(_mm256_mul_ps(p, f2), one);
+   p = _mm256_mul_ps(p,
+      _mm256_mul_ps(f, _mm256_set1_ps(2.0f / 0.69314718f)));
+
+   __m256 y = _mm256_mul_ps(c, _mm256_add_ps(_mm256_cvtepi32_ps(e), p));
+   y = _mm256_max_ps(
+      _mm256_min_ps(y, _mm256_set1_ps(127.0f)), _mm256_set1_ps(-126.0f));
+
+   const __m256i n = _mm256_cvtps_epi32(y);
+   const __m256 r = _mm256_mul_ps(_mm256_sub_ps(y, _mm256_cvtepi32_ps(n)),
+      _mm256_set1_ps(0.69314718f));
+   __m256 q = _mm256_set1_ps(1.0f / 5040);
+   q = _mm256_add_ps(_mm256_mul_ps(q, r), _mm256_set1_ps(1.0f / 720));
+   q = _mm256_add_ps(_mm256_mul_ps(q, r), _mm256_set1_ps(1.0f / 120));
+   q = _mm256_add_ps(_mm256_mul_ps(q, r), _mm256_set1_ps(1.0f / 24));
+   q = _mm256_add_ps(_mm256_mul_ps(q, r), _mm256_set1_ps(1.0f / 6));
+   q = _mm256_add_ps(_mm256_mul_ps(q, r), _mm256_set1_ps(0.5f));
+   q = _mm256_add_ps(_mm256_mul_ps(q, r), one);
+   q = _mm256_add_ps(_mm256_mul_ps(q, r), one);
+
+   return _mm256_mul_ps(q, _mm256_castsi256_ps(
+      _mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23)));
+}
+
+CPU_TARGET("avx2")
+float GainAVX2(float *buffer, const float *env, size_t len,
+   double level, double compression, float max)
+{
+   const __m256 vlevel = _mm256_set1_ps((float)level);
+   const __m256 vcompression = _mm256_set1_ps((float)compression);
+   const __m256 absMask =
+      _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+   __m256 vmax = _mm256_set1_ps(max);
+   size_t i = 0;
+   for (; i + 8 <= len; i += 8) {
+      const __m256 gain = PowPositiveAVX2(
+         _mm256_div_ps(vlevel, _mm256_loadu_ps(env + i)), vcompression);
+      const __m256 out = _mm256_mul_ps(_mm256_loadu_ps(buffer + i), gain);
+      _mm256_storeu_ps(buffer + i, out);
+      vmax = _mm256_max_ps(vmax, _mm256_and_ps(out, absMask));
+   }
+   __m128 vmax4 = _mm_max_ps(
+      _mm256_castps256_ps128(vmax), _mm256_extractf128_ps(vmax, 1));
+   vmax4 = _mm_max_ps(vmax4, _mm_movehl_ps(vmax4, vmax4));
+   vmax4 = _mm_max_ss(vmax4, _mm_shuffle_ps(vmax4, vmax4, 1));
+   return GainScalar(buffer + i, env + i, len - i,
+      level, compression, _mm_cvtss_f32(vmax4));
+}
+
+#endif
+
+// The fastest kernels, chosen once
+const CompressorKernels &Kernels()
+{
+   static const auto &kernels = CompressorKernels::All().back().second;
+   return kernels;
+}
+
+}
+
+const std::vector< std::pair< const char *, CompressorKernels > > &
+CompressorKernels::All()
+{
+   static const auto kernels = []{
+      std::vector< std::pair< const char *, CompressorKernels > > result{
+         { "scalar", { GainScalar, DecayScalar } } };
+#ifdef COMPRESSOR_SSE2
+      result.push_back({ "SSE2", { GainSSE2, DecaySSE2 } });
+#endif
+#ifdef CPU_AVX_KERNELS
+      // The envelope follower gains nothing from wider registers
+      if (CPUHasAVX2())
+         result.push_back(
+            { "AVX2", { GainAVX2, result.back().second.decay } });
+#endif
+      return result;
+   }();
+   return kernels;
+}
+
 BEGIN_EVENT_TABLE(EffectCompressor, wxEvtHandler)
    EVT_SLIDER(wxID_ANY, EffectCompressor::OnSlider)
 END_EVENT_TABLE()
@@ -477,9 +724,7 @@ bool EffectCompressor::TwoBufferProcessPass1
    }
 
    if(buffer1 != NULL) {
-      for (size_t i = 0; i < len1; i++) {
-         buffer1[i] = DoCompression(buffer1[i], mFollow1[i]);
-      }
+      DoCompression(buffer1, mFollow1.get(), len1);
    }
 
 
@@ -572,8 +817,12 @@ void EffectCompressor::Follow(float *buffer, float *env, size_t len, float *prev
       // to avoid accumulation of rounding errors
       FreshenCircle();
    }
+   const auto &kernels = Kernels();
+
    // First apply a peak detect with the requested decay rate
    last = mLastLevel;
+   // The levels from start on are not yet decayed
+   size_t start = 0;
    for(size_t i=0; i<len; i++) {
       if(mUsePeak)
          level = fabs(buffer[i]);
@@ -585,28 +834,22 @@ void EffectCompressor::Follow(float *buffer, float *env, size_t len, float *prev
       } else {
          mNoiseCounter = 0;
       }
-      if(mNoiseCounter < 100) {
-         last *= mDecayFactor;
-         if(last < mThreshold)
-            last = mThreshold;
-         if(level > last)
-            last = level;
+      if(mNoiseCounter < 100)
+         env[i] = level;
+      else {
+         kernels.decay(env + start, i - start,
+            mDecayFactor, mThreshold, last, false);
+         env[i] = last;
+         start = i + 1;
       }
-      env[i] = last;
    }
+   kernels.decay(env + start, len - start,
+      mDecayFactor, mThreshold, last, false);
    mLastLevel = last;
 
    // Next do the same process in reverse direction to get the requested attack rate
    last = mLastLevel;
-   for(size_t i = len; i--;) {
-      last *= mAttackInverseFactor;
-      if(last < mThreshold)
-         last = mThreshold;
-      if(env[i] < last)
-         env[i] = last;
-      else
-         last = env[i];
-   }
+   kernels.decay(env, len, mAttackInverseFactor, mThreshold, last, true);
 
    if((previous != NULL) && (previous_len > 0)) {
       // If the previous envelope was passed, propagate the rise back until we intersect
@@ -642,22 +885,14 @@ void EffectCompressor::Follow(float *buffer, float *env, size_t len, float *prev
    }
 }
 
-float EffectCompressor::DoCompression(float value, double env)
+void EffectCompressor::DoCompression(float *buffer, const float *env, size_t len)
 {
-   float out;
-   if(mUsePeak) {
-      // Peak values map 1.0 to 1.0 - 'upward' compression
-      out = value * pow(1.0/env, mCompression);
-   } else {
-      // With RMS-based compression don't change values below mThreshold - 'downward' compression
-      out = value * pow(mThreshold/env, mCompression);
-   }
+   // Peak values map 1.0 to 1.0 - 'upward' compression
+   // With RMS-based compression don't change values below mThreshold - 'downward' compression
+   const double level = mUsePeak ? 1.0 : mThreshold;
 
    // Retain the maximum value for use in the normalization pass
-   if(mMax < fabs(out))
-      mMax = fabs(out);
-
-   return out;
+   mMax = Kernels().gain(buffer, env, len, level, mCompression, (float)mMax);
 }
 
 void EffectCompressor::OnSlider(wxCommandEvent & WXUNUSED(evt))
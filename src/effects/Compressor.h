@@ -13,12 +13,35 @@
 
 #include "TwoPassSimpleMono.h"
 
+#include <utility>
+#include <vector>
+
 class wxCheckBox;
 class wxSlider;
 class wxStaticText;
 class EffectCompressorPanel;
 class ShuttleGui;
 
+//! The sample loops of EffectCompressor, for one instruction set
+struct AUDACITY_DLL_API CompressorKernels
+{
+   //! Multiplies each sample by (level / env)^compression, for positive env;
+   //! returns the greatest of max and the magnitudes of the results
+   float (*gain)(float *buffer, const float *env, size_t len,
+      double level, double compression, float max);
+
+   //! Raises each value, going forward or backward, to at least floor and
+   //! to at least factor (not more than 1) times the value before it; last
+   //! holds the value before the first, and then the final one
+   void (*decay)(float *values, size_t len,
+      double factor, double floor, double &last, bool backward);
+
+   //! The named kernels this build can run on this CPU, from the scalar
+   //! ones to the fastest
+   static const std::vector< std::pair< const char *, CompressorKernels > > &
+   All();
+};
+
 class EffectCompressor final : public EffectTwoPassSimpleMono
 {
 public:
@@ -66,7 +89,7 @@ private:
    void FreshenCircle();
    float AvgCircle(float x);
    void Follow(float *buffer, float *env, size_t len, float *previous, size_t previous_len);
-   float DoCompression(float x, double env);
+   void DoCompression(float *buffer, const float *env, size_t len);
 
    void OnSlider(wxCommandEvent & evt);
    void UpdateUI();
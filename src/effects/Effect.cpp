@@ -39,6 +39,7 @@
 #include "../wxFileNameWrapper.h"
 #include "../widgets/ProgressDialog.h"
 #include "../ondemand/ODManager.h"
+#include "../ondemand/ODTaskThread.h"
 #include "../tracks/playabletrack/wavetrack/ui/WaveTrackView.h"
 #include "../tracks/playabletrack/wavetrack/ui/WaveTrackViewConstants.h"
 #include "../widgets/NumericTextCtrl.h"
@@ -2058,6 +2059,12 @@ void Effect::GetBounds(
    }
 }
 
+void Effect::ParallelFor(
+   size_t count, const std::function< void(size_t) > &task)
+{
+   ::ParallelFor(count, task);
+}
+
 //
 // private methods
 //
@@ -349,6 +349,12 @@ protected:
       const WaveTrack &track, const WaveTrack *pRight,
       sampleCount *start, sampleCount *len);
 
+   // Calls task(i) for each i from 0 to count - 1, spread over the shared
+   // pool of threads, and returns when all are done, rethrowing the first
+   // exception.  Tasks must not touch the user interface or the project.
+   static void ParallelFor(
+      size_t count, const std::function< void(size_t) > &task);
+
    // Previewing linear effect can be optimised by pre-mixing. However this
    // should not be used for non-linear effects such as dynamic processors
    // To allow pre-mixing before Preview, set linearEffectFlag to true.
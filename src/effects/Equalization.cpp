@@ -242,8 +242,7 @@ BEGIN_EVENT_TABLE(EffectEqualization, wxEvtHandler)
 END_EVENT_TABLE()
 
 EffectEqualization::EffectEqualization(int Options)
-   : mFFTBuffer{ windowSize }
-   , mFilterFuncR{ windowSize }
+   : mFilterFuncR{ windowSize }
    , mFilterFuncI{ windowSize }
 {
    mOptions = Options;
@@ -1291,28 +1290,28 @@ bool EffectEqualization::ProcessOne(int count, WaveTrack * t,
    auto output = t->EmptyCopy();
    t->ConvertToSampleFormat( floatSample );
 
-   wxASSERT(mM - 1 < windowSize);
-   size_t L = windowSize - (mM - 1);   //Process L samples at a go
+   // The convolver delays its output; discard that many samples, so that
+   // output starts with the full convolution, as for the tails
+   PartitionedConvolver convolver{ mConvolutionFilter };
+   auto skip = convolver.GetLatency();
    auto s = start;
    auto idealBlockLen = t->GetMaxBlockSize() * 4;
-   if (idealBlockLen % L != 0)
-      idealBlockLen += (L - (idealBlockLen % L));
 
    Floats buffer{ idealBlockLen };
 
-   Floats window1{ windowSize };
-   Floats window2{ windowSize };
-   float *thisWindow = window1.get();
-   float *lastWindow = window2.get();
-
    auto originalLen = len;
 
-   for(size_t i = 0; i < windowSize; i++)
-      lastWindow[i] = 0;
+   auto filterBlock = [&](size_t block) {
+      convolver.Process(buffer.get(), buffer.get(), block);
+      auto discard = std::min(skip, block);
+      skip -= discard;
+      if (block > discard)
+         output->Append((samplePtr)(buffer.get() + discard), floatSample,
+                        block - discard);
+   };
 
    TrackProgress(count, 0.);
    bool bLoopSuccess = true;
-   size_t wcopy = 0;
    int offset = (mM - 1) / 2;
 
    while (len != 0)
@@ -1320,27 +1319,7 @@ bool EffectEqualization::ProcessOne(int count, WaveTrack * t,
       auto block = limitSampleBufferSize( idealBlockLen, len );
 
       t->Get((samplePtr)buffer.get(), floatSample, s, block);
-
-      for(size_t i = 0; i < block; i += L)   //go through block in lumps of length L
-      {
-         wcopy = std::min <size_t> (L, block - i);
-         for(size_t j = 0; j < wcopy; j++)
-            thisWindow[j] = buffer[i+j];   //copy the L (or remaining) samples
-         for(auto j = wcopy; j < windowSize; j++)
-            thisWindow[j] = 0;   //this includes the padding
-
-         Filter(windowSize, thisWindow);
-
-         // Overlap - Add
-         for(size_t j = 0; (j < mM - 1) && (j < wcopy); j++)
-            buffer[i+j] = thisWindow[j] + lastWindow[L + j];
-         for(size_t j = mM - 1; j < wcopy; j++)
-            buffer[i+j] = thisWindow[j];
-
-         std::swap( thisWindow, lastWindow );
-      }  //next i, lump of this block
-
-      output->Append((samplePtr)buffer.get(), floatSample, block);
+      filterBlock(block);
       len -= block;
       s += block;
 
@@ -1354,22 +1333,15 @@ bool EffectEqualization::ProcessOne(int count, WaveTrack * t,
 
    if(bLoopSuccess)
    {
-      // mM-1 samples of 'tail' left in lastWindow, get them now
-      if(wcopy < (mM - 1)) {
-         // Still have some overlap left to process
-         // (note that lastWindow and thisWindow have been exchanged at this point
-         //  so that 'thisWindow' is really the window prior to 'lastWindow')
-         size_t j = 0;
-         for(; j < mM - 1 - wcopy; j++)
-            buffer[j] = lastWindow[wcopy + j] + thisWindow[L + wcopy + j];
-         // And fill in the remainder after the overlap
-         for( ; j < mM - 1; j++)
-            buffer[j] = lastWindow[wcopy + j];
-      } else {
-         for(size_t j = 0; j < mM - 1; j++)
-            buffer[j] = lastWindow[wcopy + j];
-      }
-      output->Append((samplePtr)buffer.get(), floatSample, mM - 1);
+      // mM-1 samples of 'tail', and whatever is still delayed in the
+      // convolver, come from filtering silence
+      size_t tail = mM - 1 + convolver.GetLatency();
+      while (tail > 0) {
+         auto block = std::min(idealBlockLen, tail);
+         std::fill(buffer.get(), buffer.get() + block, 0.0f);
+         filterBlock(block);
+         tail -= block;
+      }
       output->Flush();
 
       // now move the appropriate bit of the output back to the track
@@ -1540,37 +1512,15 @@ bool EffectEqualization::CalcFilter()
       outr[i]=0.;
    }
 
+   mConvolutionFilter =
+      std::make_shared<const PartitionedFilter>(outr.get(), mM);
+
    //Back to the frequency domain so we can use it
    RealFFT(mWindowSize, outr.get(), mFilterFuncR.get(), mFilterFuncI.get());
 
    return TRUE;
 }
 
-void EffectEqualization::Filter(size_t len, float *buffer)
-{
-   float re,im;
-   // Apply FFT
-   RealFFTf(buffer, hFFT.get());
-   //FFT(len, false, inr, NULL, outr, outi);
-
-   // Apply filter
-   // DC component is purely real
-   mFFTBuffer[0] = buffer[0] * mFilterFuncR[0];
-   for(size_t i = 1; i < (len / 2); i++)
-   {
-      re=buffer[hFFT->BitReversed[i]  ];
-      im=buffer[hFFT->BitReversed[i]+1];
-      mFFTBuffer[2*i  ] = re*mFilterFuncR[i] - im*mFilterFuncI[i];
-      mFFTBuffer[2*i+1] = re*mFilterFuncI[i] + im*mFilterFuncR[i];
-   }
-   // Fs/2 component is purely real
-   mFFTBuffer[1] = buffer[1] * mFilterFuncR[len/2];
-
-   // Inverse FFT and normalization
-   InverseRealFFTf(mFFTBuffer.get(), hFFT.get());
-   ReorderToTime(hFFT.get(), mFFTBuffer.get(), buffer);
-}
-
 //
 // Load external curves with fallback to default, then message
 //
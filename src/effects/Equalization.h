@@ -150,7 +150,6 @@ private:
    bool ProcessOne(int count, WaveTrack * t,
                    sampleCount start, sampleCount len);
    bool CalcFilter();
-   void Filter(size_t len, float *buffer);
    
    void Flatten();
    void ForceRecalc();
@@ -208,8 +207,10 @@ private:
 private:
    int mOptions;
    HFFT hFFT;
-   Floats mFFTBuffer, mFilterFuncR, mFilterFuncI;
+   Floats mFilterFuncR, mFilterFuncI;
    size_t mM;
+   // The same filter in the time domain, as used by ProcessOne()
+   std::shared_ptr<const PartitionedFilter> mConvolutionFilter;
    wxString mCurveName;
    bool mLin;
    float mdBMax;
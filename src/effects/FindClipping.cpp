@@ -23,7 +23,9 @@
 #include "FindClipping.h"
 #include "LoadEffects.h"
 
+#include <algorithm>
 #include <math.h>
+#include <vector>
 
 #include <wx/intl.h>
 
@@ -46,6 +48,17 @@ const ComponentInterfaceSymbol EffectFindClipping::Symbol
 
 namespace{ BuiltinEffectsModule::Registration< EffectFindClipping > reg; }
 
+namespace {
+
+// A run of consecutive clipped samples, relative to the start of a batch
+struct ClippedRun
+{
+   size_t start;
+   size_t len;
+};
+
+}
+
 EffectFindClipping::EffectFindClipping()
 {
    mStart = DEF_Start;
@@ -161,80 +174,104 @@ bool EffectFindClipping::ProcessOne(LabelTrack * lt,
                                     sampleCount len)
 {
    bool bGoodResult = true;
-   size_t blockSize = (mStart * 1000);
 
    if (len < mStart) {
       return true;
    }
 
-   Floats buffer;
-   try {
-      // mStart should be positive.
-      // if we are throwing bad_alloc and mStart is negative, find out why.
-      if (mStart < 0 || (int)blockSize < mStart)
-         // overflow
-         throw std::bad_alloc{};
-      buffer.reinit(blockSize);
-   }
-   catch( const std::bad_alloc & ) {
-      Effect::MessageBox( XO("Requested value exceeds memory capacity.") );
-      return false;
-   }
-
-   float *ptr = buffer.get();
-
-   decltype(len) s = 0, startrun = 0, stoprun = 0, samps = 0;
-   decltype(blockSize) block = 0;
+   // The track is read here in batches, and worker threads find the runs of
+   // clipped samples in each chunk of a batch.  The duty cycle rules are then
+   // applied to the runs in order, so the labels are exactly those of a
+   // sample by sample scan, whatever the number of threads.  A chunk is
+   // one megabyte of samples, however long the blocks of the track are.
+   const size_t chunkSize = (1 << 20) / sizeof(float);
+   const size_t chunksPerBatch = 16;
+   Floats buffer{ chunkSize * chunksPerBatch };
+   std::vector< std::vector< ClippedRun > > runs(chunksPerBatch);
+
+   decltype(len) startrun = 0, stoprun = 0, samps = 0;
    double startTime = -1.0;
 
-   while (s < len) {
-      if (block == 0) {
-         if (TrackProgress(count,
-                           s.as_double() /
-                           len.as_double() )) {
-            bGoodResult = false;
-            break;
-         }
-
-         block = limitSampleBufferSize( blockSize, len - s );
-
-         wt->Get((samplePtr)buffer.get(), floatSample, start + s, block);
-         ptr = buffer.get();
+   // Apply the rules to n clipped samples starting at offset s
+   auto clipped = [&](sampleCount s, sampleCount n) {
+      if (startrun == 0) {
+         startTime = wt->LongSamplesToTime(start + s);
+         samps = 0;
       }
-
-      float v = fabs(*ptr++);
-      if (v >= MAX_AUDIO) {
-         if (startrun == 0) {
-            startTime = wt->LongSamplesToTime(start + s);
+      startrun += n;
+      samps += n;
+      stoprun = 0;
+   };
+
+   // Apply the rules to n unclipped samples starting at offset s
+   auto unclipped = [&](sampleCount s, sampleCount n) {
+      if (n <= 0)
+         return;
+      if (startrun >= mStart) {
+         // stoprun is always less than mStop here
+         auto needed = mStop - stoprun;
+         if (n >= needed) {
+            samps += needed;
+            lt->AddLabel(SelectedRegion(startTime,
+                                       wt->LongSamplesToTime(start + s + needed - 1 - mStop)),
+                        wxString::Format(wxT("%lld of %lld"), startrun.as_long_long(), (samps - mStop).as_long_long()));
+            startrun = 0;
+            stoprun = 0;
             samps = 0;
          }
          else {
-            stoprun = 0;
+            stoprun += n;
+            samps += n;
          }
-         startrun++;
-         samps++;
       }
       else {
-         if (startrun >= mStart) {
-            stoprun++;
-            samps++;
-
-            if (stoprun >= mStop) {
-               lt->AddLabel(SelectedRegion(startTime,
-                                          wt->LongSamplesToTime(start + s - mStop)),
-                           wxString::Format(wxT("%lld of %lld"), startrun.as_long_long(), (samps - mStop).as_long_long()));
-               startrun = 0;
-               stoprun = 0;
-               samps = 0;
+         startrun = 0;
+      }
+   };
+
+   decltype(len) s = 0, pos = 0;
+   while (s < len) {
+      if (TrackProgress(count,
+                        s.as_double() /
+                        len.as_double() )) {
+         bGoodResult = false;
+         break;
+      }
+
+      const auto block =
+         limitSampleBufferSize( chunkSize * chunksPerBatch, len - s );
+      wt->Get((samplePtr)buffer.get(), floatSample, start + s, block);
+
+      const auto nChunks = (block + chunkSize - 1) / chunkSize;
+      ParallelFor(nChunks, [&](size_t c){
+         const auto first = c * chunkSize;
+         const auto last = std::min(first + chunkSize, block);
+         auto &found = runs[c];
+         found.clear();
+         for (auto i = first; i < last;) {
+            if (!(fabs(buffer[i]) >= MAX_AUDIO)) {
+               i++;
+               continue;
             }
+            auto j = i + 1;
+            while (j < last && fabs(buffer[j]) >= MAX_AUDIO)
+               j++;
+            found.push_back({ i, j - i });
+            i = j;
          }
-         else {
-            startrun = 0;
+      });
+
+      for (size_t c = 0; c < nChunks; c++) {
+         for (const auto &run : runs[c]) {
+            unclipped(pos, s + run.start - pos);
+            clipped(s + run.start, run.len);
+            pos = s + run.start + run.len;
          }
       }
 
-      s++;
-      block--;
+      s += block;
+      unclipped(pos, s - pos);
+      pos = s;
    }
 
    return bGoodResult;
@@ -19,6 +19,9 @@
 #include "LoadEffects.h"
 
 #include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
 
 #include <math.h>
 #include <float.h>
@@ -29,6 +32,7 @@
 #include "../Shuttle.h"
 #include "../ShuttleGui.h"
 #include "../FFT.h"
+#include "../RealFFTf.h"
 #include "../widgets/valnum.h"
 #include "../widgets/AudacityMessageBox.h"
 #include "../Prefs.h"
@@ -50,14 +54,24 @@ public:
    //in_bufsize is also a half of a FFT buffer (in samples)
    virtual ~PaulStretch();
 
-   void process(float *smps, size_t nsmps);
+   //add NEW samples to the pool
+   void add_samples(const float *smps, size_t nsmps);
+   //copy the pool, which is the input of one frame (poolsize samples)
+   void get_window(float *window) const;
+
+   //replace an input window (poolsize samples) with the frame computed from
+   //it, with phases from a generator seeded with seed, using poolsize more
+   //samples of scratch; frames are independent of each other, so this may be
+   //called from several threads at once
+   void process_window(float *window, float *scratch, unsigned seed) const;
+
+   //make out_buf from a frame and the previous one
+   void make_output(const float *frame);
 
    size_t get_nsamples();//how many samples are required to be added in the pool next time
    size_t get_nsamples_for_fill();//how many samples are required to be added for a complete buffer refill (at start of the song or after seek)
 
 private:
-   void process_spectrum(float *WXUNUSED(freq)) {};
-
    const float samplerate;
    const float rap;
    const size_t in_bufsize;
@@ -77,7 +91,8 @@ private:
 
    double remained_samples;//how many fraction of samples has remained (0..1)
 
-   const Floats fft_smps, fft_c, fft_s, fft_freq, fft_tmp;
+   const HFFT hFFT;
+   const Floats fft_window;
 };
 
 //
@@ -354,48 +369,79 @@ bool EffectPaulstretch::ProcessOne(WaveTrack *track,double t0,double t1,int coun
       const auto fade_len = std::min<size_t>(100, bufsize / 2 - 1);
       bool cancelled = false;
 
+      // Frames are computed in parallel, in batches limited by memory
+      const size_t batch_size = std::max<size_t>(2, std::min<size_t>(
+         2 * std::max(1u, std::thread::hardware_concurrency()),
+         (1 << 22) / bufsize));
+      // Each window becomes its frame
+      Floats windows{ batch_size * bufsize };
+      Floats scratch{ batch_size * bufsize };
+      std::vector<decltype(len)> frame_ends(batch_size);
+      unsigned frame_number = 0;
+
       {
          Floats fade_track_smps{ fade_len };
          decltype(len) s=0;
 
-         while (s < len) {
-            track->Get((samplePtr)bufferptr0, floatSample, start + s, nget);
-            stretch.process(buffer0.get(), nget);
-
-            if (first_time) {
-               stretch.process(buffer0.get(), 0);
-            };
-
-            s += nget;
-
-            if (first_time){//blend the start of the selection
-               track->Get((samplePtr)fade_track_smps.get(), floatSample, start, fade_len);
-               first_time = false;
-               for (size_t i = 0; i < fade_len; i++){
-                  float fi = (float)i / (float)fade_len;
-                  stretch.out_buf[i] =
-                     stretch.out_buf[i] * fi + (1.0 - fi) * fade_track_smps[i];
+         while (s < len && !cancelled) {
+            // Gather the inputs for a batch of frames
+            size_t nframes = 0;
+            // At the start, the first frame only primes the cross-fade, and
+            // the next frame is made from the same input
+            const size_t first_frame = first_time ? 1 : 0;
+            while (s < len && nframes < batch_size) {
+               track->Get((samplePtr)bufferptr0, floatSample, start + s, nget);
+               stretch.add_samples(buffer0.get(), nget);
+               s += nget;
+               stretch.get_window(&windows[nframes * bufsize]);
+               frame_ends[nframes++] = s;
+               if (nframes == first_frame) {
+                  stretch.get_window(&windows[nframes * bufsize]);
+                  frame_ends[nframes++] = s;
                }
+               nget = stretch.get_nsamples();
             }
-            if (s >= len){//blend the end of the selection
-               track->Get((samplePtr)fade_track_smps.get(), floatSample, end - fade_len, fade_len);
-               for (size_t i = 0; i < fade_len; i++){
-                  float fi = (float)i / (float)fade_len;
-                  auto i2 = bufsize / 2 - 1 - i;
-                  stretch.out_buf[i2] =
-                     stretch.out_buf[i2] * fi + (1.0 - fi) *
-                     fade_track_smps[fade_len - 1 - i];
+
+            const auto seed = (unsigned(count) + 1) * 0x9E3779B1u + frame_number;
+            ParallelFor(nframes, [&](size_t i){
+               stretch.process_window(&windows[i * bufsize],
+                  &scratch[i * bufsize], seed + i);
+            });
+            frame_number += nframes;
+
+            for (size_t f = 0; f < nframes; f++) {
+               stretch.make_output(&windows[f * bufsize]);
+               if (f < first_frame)
+                  continue;
+
+               if (first_time){//blend the start of the selection
+                  track->Get((samplePtr)fade_track_smps.get(), floatSample, start, fade_len);
+                  first_time = false;
+                  for (size_t i = 0; i < fade_len; i++){
+                     float fi = (float)i / (float)fade_len;
+                     stretch.out_buf[i] =
+                        stretch.out_buf[i] * fi + (1.0 - fi) * fade_track_smps[i];
+                  }
+               }
+               if (frame_ends[f] >= len){//blend the end of the selection
+                  track->Get((samplePtr)fade_track_smps.get(), floatSample, end - fade_len, fade_len);
+                  for (size_t i = 0; i < fade_len; i++){
+                     float fi = (float)i / (float)fade_len;
+                     auto i2 = bufsize / 2 - 1 - i;
+                     stretch.out_buf[i2] =
+                        stretch.out_buf[i2] * fi + (1.0 - fi) *
+                        fade_track_smps[fade_len - 1 - i];
+                  }
                }
-            }
 
-            outputTrack->Append((samplePtr)stretch.out_buf.get(), floatSample, stretch.out_bufsize);
+               outputTrack->Append((samplePtr)stretch.out_buf.get(), floatSample, stretch.out_bufsize);
 
-            nget = stretch.get_nsamples();
-            if (TrackProgress(count,
-               s.as_double() / len.as_double()
-            )) {
-               cancelled = true;
-               break;
+               if (TrackProgress(count,
+                  frame_ends[f].as_double() / len.as_double()
+               )) {
+                  cancelled = true;
+                  break;
+               }
             }
          }
       }
@@ -429,21 +475,19 @@ PaulStretch::PaulStretch(float rap_, size_t in_bufsize_, float samplerate_ )
    , poolsize { in_bufsize_ * 2 }
    , in_pool { poolsize, true }
    , remained_samples { 0.0 }
-   , fft_smps { poolsize, true }
-   , fft_c { poolsize, true }
-   , fft_s { poolsize, true }
-   , fft_freq { poolsize, true }
-   , fft_tmp { poolsize }
+   , hFFT { GetFFT(poolsize) }
+   , fft_window { poolsize }
 {
+   std::fill(fft_window.get(), fft_window.get() + poolsize, 1.0f);
+   WindowFunc(eWinFuncHanning, poolsize, fft_window.get());
 }
 
 PaulStretch::~PaulStretch()
 {
 }
 
-void PaulStretch::process(float *smps, size_t nsmps)
+void PaulStretch::add_samples(const float *smps, size_t nsmps)
 {
-   //add NEW samples to the pool
    if ((smps != NULL) && (nsmps != 0)) {
       if (nsmps > poolsize) {
          nsmps = poolsize;
@@ -458,43 +502,46 @@ void PaulStretch::process(float *smps, size_t nsmps)
       for (size_t i = 0; i < nsmps; i++)
          in_pool[i + nleft] = smps[i];
    }
+}
 
-   //get the samples from the pool
-   for (size_t i = 0; i < poolsize; i++)
-      fft_smps[i] = in_pool[i];
-   WindowFunc(eWinFuncHanning, poolsize, fft_smps.get());
-
-   RealFFT(poolsize, fft_smps.get(), fft_c.get(), fft_s.get());
+void PaulStretch::get_window(float *window) const
+{
+   std::copy(in_pool.get(), in_pool.get() + poolsize, window);
+}
 
-   for (size_t i = 0; i < poolsize / 2; i++)
-      fft_freq[i] = sqrt(fft_c[i] * fft_c[i] + fft_s[i] * fft_s[i]);
-   process_spectrum(fft_freq.get());
+void PaulStretch::process_window(
+   float *window, float *scratch, unsigned seed) const
+{
+   // The caller's buffers serve for the transforms, so that frames computed
+   // in parallel allocate nothing
+   const auto fft_smps = window, fft_tmp = scratch;
+   for (size_t i = 0; i < poolsize; i++)
+      fft_smps[i] *= fft_window[i];
 
+   RealFFTf(fft_smps, hFFT.get());
 
    //put randomize phases to frequencies and do a IFFT
+   std::minstd_rand random_generator{ seed };
    float inv_2p15_2pi = 1.0 / 16384.0 * (float)M_PI;
    for (size_t i = 1; i < poolsize / 2; i++) {
-      unsigned int random = (rand()) & 0x7fff;
-      float phase = random * inv_2p15_2pi;
-      float s = fft_freq[i] * sin(phase);
-      float c = fft_freq[i] * cos(phase);
+      const float re = fft_smps[hFFT->BitReversed[i]  ];
+      const float im = fft_smps[hFFT->BitReversed[i]+1];
+      const float freq = sqrt(re * re + im * im);
 
-      fft_c[i] = fft_c[poolsize - i] = c;
-
-      fft_s[i] = s; fft_s[poolsize - i] = -s;
-   }
-   fft_c[0] = fft_s[0] = 0.0;
-   fft_c[poolsize / 2] = fft_s[poolsize / 2] = 0.0;
-
-   FFT(poolsize, true, fft_c.get(), fft_s.get(), fft_smps.get(), fft_tmp.get());
-
-   float max = 0.0, max2 = 0.0;
-   for (size_t i = 0; i < poolsize; i++) {
-      max = std::max(max, fabsf(fft_tmp[i]));
-      max2 = std::max(max2, fabsf(fft_smps[i]));
+      unsigned int random = random_generator() & 0x7fff;
+      float phase = random * inv_2p15_2pi;
+      fft_tmp[2*i  ] = freq * cos(phase);
+      fft_tmp[2*i+1] = freq * sin(phase);
    }
+   // DC and Fs/2 components
+   fft_tmp[0] = fft_tmp[1] = 0.0;
 
+   InverseRealFFTf(fft_tmp, hFFT.get());
+   ReorderToTime(hFFT.get(), fft_tmp, window);
+}
 
+void PaulStretch::make_output(const float *frame)
+{
    //make the output buffer
    float tmp = 1.0 / (float) out_bufsize * M_PI;
    float hinv_sqrt2 = 0.853553390593f;//(1.0+1.0/sqrt(2))*0.5;
@@ -507,7 +554,7 @@ void PaulStretch::process(float *smps, size_t nsmps)
 
    for (size_t i = 0; i < out_bufsize; i++) {
       float a = (0.5 + 0.5 * cos(i * tmp));
-      float out = fft_smps[i + out_bufsize] * (1.0 - a) + old_out_smp_buf[i] * a;
+      float out = frame[i + out_bufsize] * (1.0 - a) + old_out_smp_buf[i] * a;
       out_buf[i] =
          out * (hinv_sqrt2 - (1.0 - hinv_sqrt2) * cos(i * 2.0 * tmp)) *
          ampfactor;
@@ -515,7 +562,7 @@ void PaulStretch::process(float *smps, size_t nsmps)
 
    //copy the current output buffer to old buffer
    for (size_t i = 0; i < out_bufsize * 2; i++)
-      old_out_smp_buf[i] = fft_smps[i];
+      old_out_smp_buf[i] = frame[i];
 }
 
 size_t PaulStretch::get_nsamples()
@@ -25,6 +25,7 @@
 
 #include "../Experimental.h"
 
+#include <algorithm>
 #include <math.h>
 
 #include <wx/intl.h>
@@ -414,18 +415,23 @@ size_t EffectPhaser::InstanceProcess(EffectPhaserState & data, float **inBlock,
    data.phase = mPhase * M_PI / 180;
    data.outgain = DB_TO_LINEAR(mOutGain);
 
-   for (decltype(blockLen) i = 0; i < blockLen; i++)
-   {
-      double in = ibuf[i];
-
-      double m = in + data.fbout * mFeedback / 101;  // Feedback must be less than 100% to avoid infinite gain.
+   // Hoist the per-sample constants out of the loop
+   const double feedback = mFeedback / 101.0;  // Feedback must be less than 100% to avoid infinite gain.
+   const double wet = data.outgain * mDryWet / 255;
+   const double dry = data.outgain * (255 - mDryWet) / 255;
+   const int stages = mStages;
+   double *old = data.old;
 
-      if (((data.skipcount++) % lfoskipsamples) == 0)
+   for (decltype(blockLen) i = 0; i < blockLen;)
+   {
+      // The lfo only moves once every lfoskipsamples, so process up to the next update in one run
+      const auto offset = (data.skipcount % lfoskipsamples).as_long_long();
+      if (offset == 0)
       {
          //compute sine between 0 and 1
          data.gain =
             (1.0 +
-             cos(data.skipcount.as_double() * data.lfoskip
+             cos((data.skipcount + 1).as_double() * data.lfoskip
                  + data.phase)) / 2.0;
 
          // change lfo shape
@@ -435,16 +441,30 @@ size_t EffectPhaser::InstanceProcess(EffectPhaserState & data, float **inBlock,
          data.gain = 1.0 - data.gain / 255.0 * mDepth;
       }
 
-      // phasing routine
-      for (int j = 0; j < mStages; j++)
+      const auto run = std::min<size_t>(blockLen - i, lfoskipsamples - offset);
+      const double gain = data.gain;
+      double fbout = data.fbout;
+
+      for (const auto end = i + run; i < end; i++)
       {
-         double tmp = data.old[j];
-         data.old[j] = data.gain * tmp + m;
-         m = tmp - data.gain * data.old[j];
+         double in = ibuf[i];
+
+         double m = in + fbout * feedback;
+
+         // phasing routine
+         for (int j = 0; j < stages; j++)
+         {
+            double tmp = old[j];
+            old[j] = gain * tmp + m;
+            m = tmp - gain * old[j];
+         }
+         fbout = m;
+
+         obuf[i] = (float) (m * wet + in * dry);
       }
-      data.fbout = m;
 
-      obuf[i] = (float) (data.outgain * (m * mDryWet + in * (255 - mDryWet)) / 255);
+      data.fbout = fbout;
+      data.skipcount += run;
    }
 
    return blockLen;
@@ -20,6 +20,11 @@
    #include <cmath>
 #endif
 #include <algorithm>
+#if defined(__SSE2__) || defined(_M_X64) || \
+   (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+   #define REVERB_SSE2
+   #include <emmintrin.h>
+#endif
 using std::min;
 using std::max;
 
@@ -178,7 +183,7 @@ static void filter_array_create(filter_array_t * p, double rate,
    }
 }
 
-static void filter_array_process(filter_array_t * p,
+static inline void filter_array_process_scalar(filter_array_t * p,
       size_t length, float const * input, float * output,
       float const * feedback, float const * hf_damping, float const * gain)
 {
@@ -199,6 +204,124 @@ static void filter_array_process(filter_array_t * p,
    }
 }
 
+#ifdef REVERB_SSE2
+static_assert(array_length(comb_lengths) == 8 && array_length(allpass_lengths) == 4,
+      "the vector kernels expect eight combs and four allpasses");
+
+/* The vector kernels run the eight parallel combs side by side, writing
+ * their sums to the output, and then the allpasses and EQ over those.  Each
+ * run stops where the first delay line wraps, so the inner loops need no
+ * per-sample pointer checks. */
+static size_t filter_array_run(filter_array_t const * p, size_t length)
+{
+   size_t i;
+   for (i = 0; i < array_length(comb_lengths); ++i)
+      length = min(length, (size_t)(p->comb[i].ptr - p->comb[i].buffer) + 1);
+   for (i = 0; i < array_length(allpass_lengths); ++i)
+      length = min(length, (size_t)(p->allpass[i].ptr - p->allpass[i].buffer) + 1);
+   return length;
+}
+
+static void filter_rewind(filter_t * p, size_t run)
+{
+   size_t pos = p->ptr - p->buffer;
+   p->ptr = p->buffer + (pos >= run ? pos - run : pos + p->size - run);
+}
+
+static void filter_array_rewind(filter_array_t * p, size_t run)
+{
+   size_t i;
+   for (i = 0; i < array_length(comb_lengths); ++i)
+      filter_rewind(&p->comb[i], run);
+   for (i = 0; i < array_length(allpass_lengths); ++i)
+      filter_rewind(&p->allpass[i], run);
+}
+
+static void filter_array_finish(filter_array_t * p,
+      size_t run, float * output, float const * gain)
+{
+   float * ap[4];
+   size_t i, n;
+
+   for (i = 0; i < 4; ++i)
+      ap[i] = p->allpass[i].ptr;
+
+   for (n = 0; n < run; ++n) {
+      float out = output[n];
+
+      i = array_length(allpass_lengths) - 1;
+      do {
+         float o = *ap[i];
+         *ap[i]-- = out + o * .5f;
+         out = o - out;
+      } while (i--);
+
+      out = one_pole_process(&p->one_pole[0], out);
+      out = one_pole_process(&p->one_pole[1], out);
+      output[n] = out * *gain;
+   }
+
+   filter_array_rewind(p, run);
+}
+
+/* Four combs to a register */
+static void filter_array_process_sse2(filter_array_t * p,
+      size_t length, float const * input, float * output,
+      float const * feedback, float const * hf_damping, float const * gain)
+{
+   filter_t * comb = p->comb;
+   __m128 store0 = _mm_set_ps(comb[3].store, comb[2].store, comb[1].store, comb[0].store);
+   __m128 store1 = _mm_set_ps(comb[7].store, comb[6].store, comb[5].store, comb[4].store);
+   const __m128 fb = _mm_set1_ps(*feedback), damping = _mm_set1_ps(*hf_damping);
+   float * ptr[8], w[8];
+   size_t i, n;
+
+   while (length) {
+      size_t run = filter_array_run(p, length);
+      for (i = 0; i < 8; ++i)
+         ptr[i] = comb[i].ptr;
+
+      for (n = 0; n < run; ++n) {
+         const __m128 in = _mm_set1_ps(input[n]);
+         const __m128 out0 = _mm_set_ps(*ptr[3], *ptr[2], *ptr[1], *ptr[0]);
+         const __m128 out1 = _mm_set_ps(*ptr[7], *ptr[6], *ptr[5], *ptr[4]);
+         __m128 sum;
+
+         store0 = _mm_add_ps(out0, _mm_mul_ps(_mm_sub_ps(store0, out0), damping));
+         store1 = _mm_add_ps(out1, _mm_mul_ps(_mm_sub_ps(store1, out1), damping));
+         _mm_storeu_ps(w, _mm_add_ps(in, _mm_mul_ps(store0, fb)));
+         _mm_storeu_ps(w + 4, _mm_add_ps(in, _mm_mul_ps(store1, fb)));
+         for (i = 0; i < 8; ++i)
+            *ptr[i]-- = w[i];
+
+         sum = _mm_add_ps(out0, out1);
+         sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+         sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+         output[n] = _mm_cvtss_f32(sum);
+      }
+
+      filter_array_finish(p, run, output, gain);
+      input += run, output += run, length -= run;
+   }
+
+   _mm_storeu_ps(w, store0);
+   _mm_storeu_ps(w + 4, store1);
+   for (i = 0; i < 8; ++i)
+      comb[i].store = w[i];
+}
+#endif
+
+static void filter_array_process(filter_array_t * p,
+      size_t length, float const * input, float * output,
+      float const * feedback, float const * hf_damping, float const * gain)
+{
+#ifdef REVERB_SSE2
+   filter_array_process_sse2(p, length, input, output, feedback, hf_damping, gain);
+#else
+   filter_array_process_scalar(p, length, input, output, feedback, hf_damping, gain);
+#endif
+}
+
 static void filter_array_delete(filter_array_t * p)
 {
    size_t i;
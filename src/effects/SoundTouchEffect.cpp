@@ -19,6 +19,10 @@ effect that uses SoundTouch to do its processing (ChangeTempo
 
 #include <math.h>
 
+#include <algorithm>
+#include <thread>
+#include <vector>
+
 #include "../LabelTrack.h"
 #include "../WaveTrack.h"
 #include "../NoteTrack.h"
@@ -37,6 +41,39 @@ effect that uses SoundTouch to do its processing (ChangeTempo
 #undef VERSION
 #include "SoundTouch.h"
 
+namespace {
+// Selections of at least two segments of input are cut at quiet points
+// near each multiple of SegmentSeconds, and the segments are processed in
+// parallel
+const double SegmentSeconds = 10.0;
+// How far from each multiple to look for the quietest frame
+const double CutSearchSeconds = 1.0;
+const double CutFrameSeconds = 0.01;
+// Extra input processed on each side of a segment, then discarded, so the
+// segment's edges are free of start-up and flushing effects
+const double SegmentOverlapSeconds = 0.5;
+// Length of output cross-faded at each join
+const double CrossfadeSeconds = 0.02;
+
+// Middle of the quietest frame of interleaved samples in [from, to)
+size_t FindQuietCut(const float *buffer, size_t nChannels,
+                    size_t from, size_t to, size_t frameLen)
+{
+   size_t best = (from + to) / 2;
+   double bestEnergy = -1;
+   for (size_t frame = from; frame + frameLen <= to; frame += frameLen) {
+      double energy = 0;
+      for (auto i = frame * nChannels; i < (frame + frameLen) * nChannels; ++i)
+         energy += buffer[i] * buffer[i];
+      if (bestEnergy < 0 || energy < bestEnergy) {
+         bestEnergy = energy;
+         best = frame + frameLen / 2;
+      }
+   }
+   return best;
+}
+}
+
 #ifdef USE_MIDI
 EffectSoundTouch::EffectSoundTouch()
 {
@@ -187,6 +224,9 @@ bool EffectSoundTouch::ProcessOne(WaveTrack *track,
                                   sampleCount start, sampleCount end,
                                   const TimeWarper &warper)
 {
+   if (ShouldProcessSegments(*track, start, end))
+      return ProcessSegments(track, nullptr, start, end, warper);
+
    mSoundTouch->setSampleRate((unsigned int)(track->GetRate()+0.5));
 
    auto outputTrack = track->EmptyCopy();
@@ -260,6 +300,9 @@ bool EffectSoundTouch::ProcessStereo(
    WaveTrack* leftTrack, WaveTrack* rightTrack,
    sampleCount start, sampleCount end, const TimeWarper &warper)
 {
+   if (ShouldProcessSegments(*leftTrack, start, end))
+      return ProcessSegments(leftTrack, rightTrack, start, end, warper);
+
    mSoundTouch->setSampleRate((unsigned int)(leftTrack->GetRate() + 0.5));
 
    auto outputLeftTrack = leftTrack->EmptyCopy();
@@ -379,4 +422,160 @@ bool EffectSoundTouch::ProcessStereoResults(const size_t outputCount,
    return true;
 }
 
+bool EffectSoundTouch::ShouldProcessSegments(const WaveTrack &track,
+   sampleCount start, sampleCount end) const
+{
+   return std::thread::hardware_concurrency() > 1 &&
+      (end - start).as_double() >= 2 * SegmentSeconds * track.GetRate();
+}
+
+//ProcessSegments() cuts the selection at quiet points, processes the pieces
+//with some overlap on separate threads, and cross-fades them at the cuts.
+//Pieces are placed by the time warper, so labels warped by it stay in sync.
+bool EffectSoundTouch::ProcessSegments(
+   WaveTrack* leftTrack, WaveTrack* rightTrack,
+   sampleCount start, sampleCount end, const TimeWarper &warper)
+{
+   const double rate = leftTrack->GetRate();
+   const size_t nChannels = rightTrack ? 2 : 1;
+   const auto toSamples = [&](double seconds){
+      return (long long)(seconds * rate + 0.5); };
+   const auto segmentLen = toSamples(SegmentSeconds);
+   const auto searchLen = toSamples(CutSearchSeconds);
+   const auto frameLen = std::max<long long>(1, toSamples(CutFrameSeconds));
+   const auto overlapLen = toSamples(SegmentOverlapSeconds);
+   const auto crossfadeLen = toSamples(CrossfadeSeconds);
+   const size_t nThreads = std::max(1u, std::thread::hardware_concurrency());
+
+   const auto s0 = start.as_long_long(), s1 = end.as_long_long();
+   const double w0 = warper.Warp(leftTrack->LongSamplesToTime(start));
+   // Where the output for a given input sample belongs
+   const auto outputPosition = [&](long long s){
+      return (long long)floor(
+         (warper.Warp(leftTrack->LongSamplesToTime(s)) - w0) * rate + 0.5);
+   };
+
+   auto outputLeftTrack = leftTrack->EmptyCopy();
+   decltype(outputLeftTrack) outputRightTrack;
+   if (rightTrack)
+      outputRightTrack = rightTrack->EmptyCopy();
+
+   struct Segment {
+      long long cut0, cut1; // the part of the input this segment produces
+      long long in0, in1;   // the input given to SoundTouch
+      std::vector<float> output;
+   };
+
+   // Interleaved output of the previous segment, past its cut
+   std::vector<float> tail;
+   std::vector<float> input, channel, deinterleaved;
+
+   auto cut = s0;
+   while (cut < s1) {
+      // Read the input for a batch of segments, one per thread, allowing for
+      // the cuts to drift and for the overlap
+      const auto in0 = std::max(s0, cut - overlapLen);
+      const auto in1 = std::min(s1,
+         cut + (segmentLen + searchLen) * (long long)nThreads +
+            searchLen + overlapLen);
+      const auto inLen = size_t(in1 - in0);
+      input.resize(inLen * nChannels);
+      channel.resize(inLen);
+      for (size_t c = 0; c < nChannels; ++c) {
+         auto track = c == 0 ? leftTrack : rightTrack;
+         track->Get((samplePtr)channel.data(), floatSample, in0, inLen);
+         for (size_t i = 0; i < inLen; ++i)
+            input[i * nChannels + c] = channel[i];
+      }
+
+      std::vector<Segment> segments;
+      while (segments.size() < nThreads && cut < s1) {
+         Segment segment;
+         segment.cut0 = cut;
+         const auto nominal = cut + segmentLen;
+         if (nominal + segmentLen / 2 >= s1)
+            // Don't leave a short piece at the end
+            segment.cut1 = s1;
+         else
+            segment.cut1 = in0 + FindQuietCut(input.data(), nChannels,
+               nominal - searchLen - in0, nominal + searchLen - in0, frameLen);
+         segment.in0 = std::max(s0, segment.cut0 - overlapLen);
+         segment.in1 = std::min(s1, segment.cut1 + overlapLen);
+         cut = segment.cut1;
+         segments.push_back(std::move(segment));
+      }
+
+      ParallelFor(segments.size(), [&](size_t i){
+         auto &segment = segments[i];
+         auto soundTouch = MakeSoundTouch();
+         soundTouch->setChannels(nChannels);
+         soundTouch->setSampleRate((unsigned int)(rate + 0.5));
+         soundTouch->putSamples(&input[(segment.in0 - in0) * nChannels],
+            segment.in1 - segment.in0);
+         soundTouch->flush();
+         while (auto count = soundTouch->numSamples()) {
+            auto size = segment.output.size();
+            segment.output.resize(size + count * nChannels);
+            soundTouch->receiveSamples(&segment.output[size], count);
+         }
+      });
+
+      for (auto &segment : segments) {
+         auto &output = segment.output;
+         const auto outLen = (long long)(output.size() / nChannels);
+         const auto base = outputPosition(segment.in0);
+         const auto begin = std::max(0LL,
+            std::min(outLen, outputPosition(segment.cut0) - base));
+         const auto stop = (segment.cut1 == s1)
+            ? outLen
+            : std::max(begin,
+               std::min(outLen, outputPosition(segment.cut1) - base));
+
+         // Fade in from the previous segment's output past the cut
+         const auto fade = std::min<long long>(tail.size() / nChannels, stop - begin);
+         for (long long i = 0; i < fade; ++i) {
+            const float w = (i + 0.5f) / fade;
+            for (size_t c = 0; c < nChannels; ++c) {
+               auto &sample = output[(begin + i) * nChannels + c];
+               sample = sample * w + tail[i * nChannels + c] * (1 - w);
+            }
+         }
+
+         const auto len = size_t(stop - begin);
+         deinterleaved.resize(len);
+         for (size_t c = 0; c < nChannels; ++c) {
+            for (size_t i = 0; i < len; ++i)
+               deinterleaved[i] = output[(begin + i) * nChannels + c];
+            auto track = c == 0 ? outputLeftTrack.get() : outputRightTrack.get();
+            track->Append((samplePtr)deinterleaved.data(), floatSample, len);
+         }
+
+         tail.assign(output.begin() + stop * nChannels,
+            output.begin() + std::min(outLen, stop + crossfadeLen) * nChannels);
+      }
+
+      if (TrackProgress(mCurTrackNum, double(cut - s0) / double(s1 - s0)))
+         return false;
+   }
+
+   outputLeftTrack->Flush();
+   if (rightTrack)
+      outputRightTrack->Flush();
+
+   // Take the output tracks and insert in place of the original
+   // sample data.
+   leftTrack->ClearAndPaste(
+      mCurT0, mCurT1, outputLeftTrack.get(), false, true, &warper);
+   double newLength = outputLeftTrack->GetEndTime();
+   m_maxNewLength = wxMax(m_maxNewLength, newLength);
+   if (rightTrack) {
+      rightTrack->ClearAndPaste(
+         mCurT0, mCurT1, outputRightTrack.get(), false, true, &warper);
+      newLength = outputRightTrack->GetEndTime();
+      m_maxNewLength = wxMax(m_maxNewLength, newLength);
+   }
+
+   return true;
+}
+
 #endif // USE_SOUNDTOUCH
@@ -50,6 +50,11 @@ protected:
 
    bool ProcessWithTimeWarper(const TimeWarper &warper);
 
+   // Make a SoundTouch object set up with the subclass-specific parameters.
+   // Long selections are cut into segments, each processed by its own
+   // object on its own thread.
+   virtual std::unique_ptr<soundtouch::SoundTouch> MakeSoundTouch() const = 0;
+
    std::unique_ptr<soundtouch::SoundTouch> mSoundTouch;
    double mCurT0;
    double mCurT1;
@@ -68,6 +73,13 @@ private:
    bool ProcessStereoResults(const size_t outputCount,
                               WaveTrack* outputLeftTrack,
                               WaveTrack* outputRightTrack);
+   // Whether ProcessSegments() is worthwhile for this many samples
+   bool ShouldProcessSegments(const WaveTrack &track,
+                              sampleCount start, sampleCount end) const;
+   // rightTrack may be null
+   bool ProcessSegments(WaveTrack* leftTrack, WaveTrack* rightTrack,
+                        sampleCount start, sampleCount end,
+                        const TimeWarper &warper);
 
    int    mCurTrackNum;
 
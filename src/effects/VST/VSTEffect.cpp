@@ -57,7 +57,6 @@
 #include <wx/listctrl.h>
 #include <wx/log.h>
 #include <wx/module.h>
-#include <wx/process.h>
 #include <wx/progdlg.h>
 #include <wx/recguard.h>
 #include <wx/sizer.h>
@@ -82,6 +81,7 @@
 
 #include "../../FileNames.h"
 #include "../../PlatformCompatibility.h"
+#include "../../PluginManager.h"
 #include "../../ShuttleGui.h"
 #include "../../effects/Effect.h"
 #include "../../widgets/valnum.h"
@@ -194,7 +194,7 @@ public:
 IMPLEMENT_DYNAMIC_CLASS(VSTSubEntry, wxModule);
 
 //----------------------------------------------------------------------------
-// VSTSubProcess
+// VSTScannedEffect
 //----------------------------------------------------------------------------
 #define OUTPUTKEY wxT("<VSTLOADCHK>-")
 enum InfoKeys
@@ -215,18 +215,12 @@ enum InfoKeys
 
 ///////////////////////////////////////////////////////////////////////////////
 ///
-/// Information about one VST effect.
+/// Information about one VST effect, as reported by the scanner.
 ///
 ///////////////////////////////////////////////////////////////////////////////
-class VSTSubProcess final : public wxProcess,
-                      public EffectDefinitionInterface
+class VSTScannedEffect final : public EffectDefinitionInterface
 {
 public:
-   VSTSubProcess()
-   {
-      Redirect();
-   }
-
    // EffectClientInterface implementation
 
    PluginPath GetPath() override
@@ -300,6 +294,18 @@ public:
    bool mAutomatable;
 };
 
+//----------------------------------------------------------------------------
+// VSTScanner
+//----------------------------------------------------------------------------
+
+// Each plug-in is checked by another instance of Audacity, running
+// VSTEffectsModule::Check(); the argument is "path;effectID"
+static const PluginScanner &GetScanner()
+{
+   static const PluginScanner scanner{ VSTCMDKEY, OUTPUTKEY };
+   return scanner;
+}
+
 // ============================================================================
 //
 // VSTEffectsModule
@@ -511,9 +517,6 @@ unsigned VSTEffectsModule::DiscoverPluginsAtPath(
    bool error = false;
    unsigned nFound = 0;
    errMsg = {};
-   // TODO:  Fix this for external usage
-   const auto &cmdpath = PlatformCompatibility::GetExecutablePath();
-
    wxString effectIDs = wxT("0;");
    wxStringTokenizer effectTzr(effectIDs, wxT(";"));
 
@@ -527,28 +530,16 @@ unsigned VSTEffectsModule::DiscoverPluginsAtPath(
    {
       wxString effectID = effectTzr.GetNextToken();
 
-      wxString cmd;
-      cmd.Printf(wxT("\"%s\" %s \"%s;%s\""), cmdpath, VSTCMDKEY, path, effectID);
+      const wxString command = path + wxT(";") + effectID;
 
-      VSTSubProcess proc;
-      try
-      {
-         int flags = wxEXEC_SYNC | wxEXEC_NODISABLE;
-#if defined(__WXMSW__)
-         flags += wxEXEC_NOHIDE;
-#endif
-         wxExecute(cmd, flags, &proc);
-      }
-      catch (...)
+      VSTScannedEffect effect;
+      wxString output;
+      if (!GetScanner().Scan(command, output))
       {
          wxLogMessage(_("VST plugin registration failed for %s\n"), path);
          error = true;
       }
 
-      wxString output;
-      wxStringOutputStream ss(&output);
-      proc.GetInputStream()->Read(ss);
-
       int keycount = 0;
       bool haveBegin = false;
       wxStringTokenizer tzr(output, wxT("\n"));
@@ -579,7 +570,7 @@ unsigned VSTEffectsModule::DiscoverPluginsAtPath(
                {
                   progress.emplace( _("Scanning Shell VST"),
                         wxString::Format(_("Registering %d of %d: %-64.64s"), 0, idCnt,
-                                         proc.GetSymbol().Translation()),
+                                         effect.GetSymbol().Translation()),
                         static_cast<int>(idCnt),
                         nullptr,
                         wxPD_APP_MODAL |
@@ -598,44 +589,44 @@ unsigned VSTEffectsModule::DiscoverPluginsAtPath(
             break;
 
             case kKeyName:
-               proc.mName = val;
+               effect.mName = val;
                keycount++;
             break;
 
             case kKeyPath:
-               proc.mPath = val;
+               effect.mPath = val;
                keycount++;
             break;
 
             case kKeyVendor:
-               proc.mVendor = val;
+               effect.mVendor = val;
                keycount++;
             break;
 
             case kKeyVersion:
-               proc.mVersion = val;
+               effect.mVersion = val;
                keycount++;
             break;
 
             case kKeyDescription:
-               proc.mDescription = Verbatim( val );
+               effect.mDescription = Verbatim( val );
                keycount++;
             break;
 
             case kKeyEffectType:
                long type;
                val.ToLong(&type);
-               proc.mType = (EffectType) type;
+               effect.mType = (EffectType) type;
                keycount++;
             break;
 
             case kKeyInteractive:
-               proc.mInteractive = val == wxT("1");
+               effect.mInteractive = val == wxT("1");
                keycount++;
             break;
 
             case kKeyAutomatable:
-               proc.mAutomatable = val == wxT("1");
+               effect.mAutomatable = val == wxT("1");
                keycount++;
             break;
 
@@ -654,13 +645,13 @@ unsigned VSTEffectsModule::DiscoverPluginsAtPath(
                   idNdx++;
                   cont = progress->Update(idNdx,
                      wxString::Format(_("Registering %d of %d: %-64.64s"), idNdx, idCnt,
-                        proc.GetSymbol().Translation() ));
+                        effect.GetSymbol().Translation() ));
                }
 
                if (!skip && cont)
                {
                   if (callback)
-                     callback( this, &proc );
+                     callback( this, &effect );
                   ++nFound;
                }
             }
@@ -680,6 +671,18 @@ unsigned VSTEffectsModule::DiscoverPluginsAtPath(
    return nFound;
 }
 
+void VSTEffectsModule::PrepareToDiscoverPluginsAtPaths(const PluginPaths & paths)
+{
+   // Check in advance, and in parallel, all the plug-ins not already in the
+   // cache; DiscoverPluginsAtPath will then find them there.  Shell plug-ins
+   // will still check their sub-plug-ins one at a time.
+   wxArrayString commands;
+   for (const auto &path : paths)
+      commands.push_back(path + wxT(";0"));
+
+   GetScanner().ScanInParallel(commands, XO("Scanning VST"));
+}
+
 bool VSTEffectsModule::IsPluginValid(const PluginPath & path, bool bFast)
 {
    if( bFast )
@@ -717,10 +720,10 @@ void VSTEffectsModule::DeleteInstance(ComponentInterface *instance)
 void VSTEffectsModule::Check(const wxChar *path)
 {
    VSTEffect effect(path);
+   wxString out;
    if (effect.SetHost(NULL))
    {
       auto effectIDs = effect.GetEffectIDs();
-      wxString out;
 
       if (effectIDs.size() > 0)
       {
@@ -747,13 +750,10 @@ void VSTEffectsModule::Check(const wxChar *path)
          out += wxString::Format(wxT("%s%d=%d\n"), OUTPUTKEY, kKeyAutomatable, effect.SupportsAutomation());
          out += wxString::Format(wxT("%s%d=%s\n"), OUTPUTKEY, kKeyEnd, wxEmptyString);
       }
-
-      // We want to output info in one chunk to prevent output
-      // from the effect intermixing with the info
-      const wxCharBuffer buf = out.ToUTF8();
-      fwrite(buf, 1, strlen(buf), stdout);
-      fflush(stdout);
    }
+
+   // Report even failure to load, which is not a crash
+   GetScanner().Finish(out);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
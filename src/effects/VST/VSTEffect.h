@@ -429,6 +429,7 @@ public:
       const PluginPath & path, TranslatableString &errMsg,
       const RegistrationCallback &callback)
          override;
+   void PrepareToDiscoverPluginsAtPaths(const PluginPaths & paths) override;
 
    bool IsPluginValid(const PluginPath & path, bool bFast) override;
 
@@ -24,6 +24,7 @@
 
 #include "../Experimental.h"
 
+#include <algorithm>
 #include <math.h>
 
 #include <wx/intl.h>
@@ -369,11 +370,6 @@ void EffectWahwah::InstanceInit(EffectWahwahState & data, float sampleRate)
 
 size_t EffectWahwah::InstanceProcess(EffectWahwahState & data, float **inBlock, float **outBlock, size_t blockLen)
 {
-   float *ibuf = inBlock[0];
-   float *obuf = outBlock[0];
-   double frequency, omega, sn, cs, alpha;
-   double in, out;
-
    data.lfoskip = mFreq * 2 * M_PI / data.samplerate;
    data.depth = mDepth / 100.0;
    data.freqofs = mFreqOfs / 100.0;
@@ -381,37 +377,57 @@ size_t EffectWahwah::InstanceProcess(EffectWahwahState & data, float **inBlock,
    data.phase = mPhase * M_PI / 180.0;
    data.outgain = DB_TO_LINEAR(mOutGain);
 
-   for (decltype(blockLen) i = 0; i < blockLen; i++)
-   {
-      in = (double) ibuf[i];
+   data.Process(inBlock[0], outBlock[0], blockLen, mRes);
+
+   return blockLen;
+}
+
+void EffectWahwahState::Process(
+   const float *ibuf, float *obuf, size_t len, double resonance)
+{
+   double frequency, omega, sn, cs, alpha;
 
-      if ((data.skipcount++) % lfoskipsamples == 0)
+   for (decltype(len) i = 0; i < len;)
+   {
+      // The lfo only moves once every lfoskipsamples, so process up to the next update in one run
+      const auto offset = skipcount % lfoskipsamples;
+      if (offset == 0)
       {
-         frequency = (1 + cos(data.skipcount * data.lfoskip + data.phase)) / 2;
-         frequency = frequency * data.depth * (1 - data.freqofs) + data.freqofs;
+         frequency = (1 + cos((skipcount + 1) * lfoskip + phase)) / 2;
+         frequency = frequency * depth * (1 - freqofs) + freqofs;
          frequency = exp((frequency - 1) * 6);
          omega = M_PI * frequency;
          sn = sin(omega);
          cs = cos(omega);
-         alpha = sn / (2 * mRes);
-         data.b0 = (1 - cs) / 2;
-         data.b1 = 1 - cs;
-         data.b2 = (1 - cs) / 2;
-         data.a0 = 1 + alpha;
-         data.a1 = -2 * cs;
-         data.a2 = 1 - alpha;
-      };
-      out = (data.b0 * in + data.b1 * data.xn1 + data.b2 * data.xn2 - data.a1 * data.yn1 - data.a2 * data.yn2) / data.a0;
-      data.xn2 = data.xn1;
-      data.xn1 = in;
-      data.yn2 = data.yn1;
-      data.yn1 = out;
-      out *= data.outgain;
-
-      obuf[i] = (float) out;
-   }
+         alpha = sn / (2 * resonance);
 
-   return blockLen;
+         // The remaining coefficients are kept normalized by a0
+         a0 = 1 + alpha;
+         b0 = (1 - cs) / 2 / a0;
+         b1 = (1 - cs) / a0;
+         b2 = (1 - cs) / 2 / a0;
+         a1 = -2 * cs / a0;
+         a2 = (1 - alpha) / a0;
+      }
+
+      const auto run = std::min<size_t>(len - i, lfoskipsamples - offset);
+      double x1 = xn1, x2 = xn2, y1 = yn1, y2 = yn2;
+
+      for (const auto end = i + run; i < end; i++)
+      {
+         double in = ibuf[i];
+         double out = b0 * in + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+         x2 = x1;
+         x1 = in;
+         y2 = y1;
+         y1 = out;
+
+         obuf[i] = (float) (out * outgain);
+      }
+
+      xn1 = x1, xn2 = x2, yn1 = y1, yn2 = y2;
+      skipcount += run;
+   }
 }
 
 void EffectWahwah::OnFreqSlider(wxCommandEvent & evt)
@@ -25,6 +25,10 @@ class ShuttleGui;
 class EffectWahwahState
 {
 public:
+   //! Filters len samples, retuning the filter to the lfo as it goes; the
+   //! filter has the given resonance (Q)
+   void Process(const float *in, float *out, size_t len, double resonance);
+
    float samplerate;
    double depth;
    double freqofs;
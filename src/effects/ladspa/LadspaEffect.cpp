@@ -37,6 +37,7 @@ effects from this one class.
 
 #include <wx/setup.h> // for wxUSE_* macros
 #include <wx/wxprec.h>
+#include <wx/app.h>
 #include <wx/button.h>
 #include <wx/checkbox.h>
 #include <wx/dcbuffer.h>
@@ -44,6 +45,7 @@ effects from this one class.
 #include <wx/filename.h>
 #include <wx/log.h>
 #include <wx/menu.h>
+#include <wx/module.h>
 #include <wx/sizer.h>
 #include <wx/slider.h>
 #include <wx/statbox.h>
@@ -55,6 +57,7 @@ effects from this one class.
 #include <wx/version.h>
 
 #include "../../FileNames.h"
+#include "../../PluginManager.h"
 #include "../../ShuttleGui.h"
 #include "../../widgets/NumericTextCtrl.h"
 #include "../../widgets/valnum.h"
@@ -93,6 +96,144 @@ DECLARE_MODULE_ENTRY(AudacityModule)
 // ============================================================================
 DECLARE_BUILTIN_MODULE(LadspaBuiltin);
 
+///////////////////////////////////////////////////////////////////////////////
+///
+/// Auto created at program start up, this checks a LADSPA library when
+/// Audacity was started only for that.
+///
+///////////////////////////////////////////////////////////////////////////////
+class LadspaSubEntry final : public wxModule
+{
+public:
+   bool OnInit()
+   {
+      // Have we been started to check a library?
+      if (wxTheApp && wxTheApp->argc == 3 && wxStrcmp(wxTheApp->argv[1], LADSPACMDKEY) == 0)
+      {
+         LadspaEffectsModule::Check(wxTheApp->argv[2]);
+
+         // Returning false causes default processing to display a message box, but we don't
+         // want that so disable logging.
+         wxLog::EnableLogging(false);
+
+         return false;
+      }
+
+      return true;
+   };
+
+   void OnExit() {};
+
+   DECLARE_DYNAMIC_CLASS(LadspaSubEntry)
+};
+IMPLEMENT_DYNAMIC_CLASS(LadspaSubEntry, wxModule);
+
+///////////////////////////////////////////////////////////////////////////////
+///
+/// Information about one LADSPA effect, as reported by the checking process.
+///
+///////////////////////////////////////////////////////////////////////////////
+#define OUTPUTKEY wxT("<LADSPALOADCHK>-")
+enum InfoKeys
+{
+   kKeyBegin,
+   kKeyPath,
+   kKeyName,
+   kKeyVendor,
+   kKeyDescription,
+   kKeyEffectType,
+   kKeyInteractive,
+   kKeyRealtime,
+   kKeyAutomatable,
+   kKeyEnd
+};
+
+class LadspaEffectInfo final : public EffectDefinitionInterface
+{
+public:
+   // ComponentInterface implementation
+
+   PluginPath GetPath() override
+   {
+      return mPath;
+   }
+
+   ComponentInterfaceSymbol GetSymbol() override
+   {
+      return mName;
+   }
+
+   VendorSymbol GetVendor() override
+   {
+      return { mVendor };
+   }
+
+   wxString GetVersion() override
+   {
+      return _("n/a");
+   }
+
+   TranslatableString GetDescription() override
+   {
+      return mDescription;
+   }
+
+   // EffectDefinitionInterface implementation
+
+   EffectType GetType() override
+   {
+      return mType;
+   }
+
+   EffectFamilySymbol GetFamily() override
+   {
+      return LADSPAEFFECTS_FAMILY;
+   }
+
+   bool IsInteractive() override
+   {
+      return mInteractive;
+   }
+
+   bool IsDefault() override
+   {
+      return false;
+   }
+
+   bool IsLegacy() override
+   {
+      return false;
+   }
+
+   bool SupportsRealtime() override
+   {
+      return mRealtime;
+   }
+
+   bool SupportsAutomation() override
+   {
+      return mAutomatable;
+   }
+
+public:
+   wxString mPath;
+   wxString mName;
+   wxString mVendor;
+   TranslatableString mDescription;
+   EffectType mType{ EffectTypeNone };
+   bool mInteractive{ false };
+   bool mRealtime{ false };
+   bool mAutomatable{ false };
+};
+
+// Each library is checked by another instance of Audacity, running
+// LadspaEffectsModule::Check(); the argument is its path
+static const PluginScanner &GetScanner()
+{
+   static const PluginScanner scanner{ LADSPACMDKEY, OUTPUTKEY };
+   return scanner;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // LadspaEffectsModule
@@ -217,8 +358,12 @@ bool LadspaEffectsModule::AutoRegisterPlugins(PluginManagerInterface & pm)
          if (!pm.IsPluginRegistered(files[j]))
          {
             // No checking for error ?
-            DiscoverPluginsAtPath(files[j], ignoredErrMsg,
-               PluginManagerInterface::DefaultRegistrationCallback);
+            // These are trusted, so they are loaded right here
+            DiscoverPluginsInProcess(files[j], ignoredErrMsg,
+               [this](LadspaEffect &effect){
+                  PluginManagerInterface::DefaultRegistrationCallback(
+                     this, &effect);
+               });
          }
       }
    }
@@ -265,6 +410,142 @@ unsigned LadspaEffectsModule::DiscoverPluginsAtPath(
       return 0;
    }
 
+   // Load the library in another process, so that a bad one can't crash us
+   wxString output;
+   if (!GetScanner().Scan(path, output)) {
+      wxLogMessage(_("LADSPA plugin registration failed for %s\n"), path);
+      errMsg = XO("Could not load the library");
+      return 0;
+   }
+
+   int nLoaded = 0;
+   int keycount = 0;
+   LadspaEffectInfo info;
+   wxStringTokenizer tzr(output, wxT("\n"));
+   while (tzr.HasMoreTokens())
+   {
+      wxString line = tzr.GetNextToken();
+
+      // Our output may follow any output the plugin may have written.
+      if (!line.StartsWith(OUTPUTKEY))
+         continue;
+
+      long key;
+      if (!line.Mid(wxStrlen(OUTPUTKEY)).BeforeFirst(wxT('=')).ToLong(&key))
+         continue;
+      wxString val = line.AfterFirst(wxT('=')).BeforeFirst(wxT('\r'));
+
+      switch (key)
+      {
+         case kKeyBegin:
+            info = {};
+            keycount = 0;
+         break;
+
+         case kKeyPath:
+            info.mPath = val;
+         break;
+
+         case kKeyName:
+            info.mName = val;
+         break;
+
+         case kKeyVendor:
+            info.mVendor = val;
+         break;
+
+         case kKeyDescription:
+            info.mDescription = Verbatim( val );
+         break;
+
+         case kKeyEffectType:
+            long type;
+            val.ToLong(&type);
+            info.mType = (EffectType) type;
+         break;
+
+         case kKeyInteractive:
+            info.mInteractive = val == wxT("1");
+         break;
+
+         case kKeyRealtime:
+            info.mRealtime = val == wxT("1");
+         break;
+
+         case kKeyAutomatable:
+            info.mAutomatable = val == wxT("1");
+         break;
+
+         case kKeyEnd:
+            // Every key from kKeyBegin on must have been seen
+            if (keycount == kKeyEnd) {
+               ++nLoaded;
+               if (callback)
+                  callback( this, &info );
+            }
+            keycount = 0;
+            continue;
+
+         default:
+            continue;
+      }
+      ++keycount;
+   }
+
+   if (nLoaded == 0)
+      errMsg = XO("Could not load the library");
+
+   return nLoaded;
+}
+
+void LadspaEffectsModule::PrepareToDiscoverPluginsAtPaths(const PluginPaths & paths)
+{
+   // Check in advance, and in parallel, all the libraries not already in the
+   // cache; DiscoverPluginsAtPath will then find them there
+   wxArrayString commands;
+   for (const auto &path : paths)
+      if (wxFileName(path).GetName().CmpNoCase(wxT("vst-bridge")) != 0)
+         commands.push_back(path);
+
+   GetScanner().ScanInParallel(commands, XO("Scanning LADSPA"));
+}
+
+void LadspaEffectsModule::Check(const wxChar *path)
+{
+   wxString out;
+   TranslatableString ignoredErrMsg;
+   // Each value must stay on its own line
+   auto oneLine = [](wxString value){
+      value.Replace(wxT("\r"), wxT(" "));
+      value.Replace(wxT("\n"), wxT(" "));
+      return value;
+   };
+   DiscoverPluginsInProcess(path, ignoredErrMsg, [&](LadspaEffect &effect){
+      out += wxString::Format(wxT("%s%d=%s\n"), OUTPUTKEY, kKeyBegin, wxEmptyString);
+      out += wxString::Format(wxT("%s%d=%s\n"), OUTPUTKEY, kKeyPath, effect.GetPath());
+      out += wxString::Format(wxT("%s%d=%s\n"), OUTPUTKEY, kKeyName, oneLine(effect.GetSymbol().Internal()));
+      out += wxString::Format(wxT("%s%d=%s\n"), OUTPUTKEY, kKeyVendor,
+                              oneLine(effect.GetVendor().Internal()));
+      out += wxString::Format(wxT("%s%d=%s\n"), OUTPUTKEY, kKeyDescription,
+                              oneLine(effect.GetDescription().Translation()));
+      out += wxString::Format(wxT("%s%d=%d\n"), OUTPUTKEY, kKeyEffectType, effect.GetType());
+      out += wxString::Format(wxT("%s%d=%d\n"), OUTPUTKEY, kKeyInteractive, effect.IsInteractive());
+      out += wxString::Format(wxT("%s%d=%d\n"), OUTPUTKEY, kKeyRealtime, effect.SupportsRealtime());
+      out += wxString::Format(wxT("%s%d=%d\n"), OUTPUTKEY, kKeyAutomatable, effect.SupportsAutomation());
+      out += wxString::Format(wxT("%s%d=%s\n"), OUTPUTKEY, kKeyEnd, wxEmptyString);
+   });
+
+   // Report even failure to load, which is not a crash
+   GetScanner().Finish(out);
+}
+
+unsigned LadspaEffectsModule::DiscoverPluginsInProcess(
+   const PluginPath & path, TranslatableString &errMsg,
+   const std::function< void(LadspaEffect &) > &callback)
+{
+   errMsg = {};
+   wxFileName ff(path);
+
    // As a courtesy to some plug-ins that might be bridges to
    // open other plug-ins, we set the current working
    // directory to be the plug-in's directory.
@@ -296,8 +577,7 @@ unsigned LadspaEffectsModule::DiscoverPluginsAtPath(
             LadspaEffect effect(path, index);
             if (effect.SetHost(NULL)) {
                ++nLoaded;
-               if (callback)
-                  callback( this, &effect );
+               callback( effect );
             }
             else
                errMsg = XO("Could not load the library");
@@ -31,6 +31,8 @@ class NumericTextCtrl;
  */
 #define LADSPAEFFECTS_FAMILY XO("LADSPA")
 
+#define LADSPACMDKEY wxT("-checkladspa")
+
 ///////////////////////////////////////////////////////////////////////////////
 //
 // LadspaEffect
@@ -240,11 +242,20 @@ public:
    ComponentInterface *CreateInstance(const PluginPath & path) override;
    void DeleteInstance(ComponentInterface *instance) override;
 
+   void PrepareToDiscoverPluginsAtPaths(const PluginPaths & paths) override;
+
    // LadspaEffectModule implementation
 
    FilePaths GetSearchPaths();
 
+   static void Check(const wxChar *path);
+
 private:
+   // Loads the library into this process
+   static unsigned DiscoverPluginsInProcess(
+      const PluginPath & path, TranslatableString &errMsg,
+      const std::function< void(LadspaEffect &) > &callback);
+
    ModuleManagerInterface *mModMan;
    wxString mPath;
 };
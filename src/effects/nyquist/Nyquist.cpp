@@ -139,6 +139,7 @@ END_EVENT_TABLE()
 NyquistEffect::NyquistEffect(const wxString &fName)
 {
    mOutputTrack[0] = mOutputTrack[1] = nullptr;
+   mCurBufferLen[0] = mCurBufferLen[1] = 0;
 
    mAction = XO("Applying Nyquist Effect...");
    mIsPrompt = false;
@@ -1362,13 +1363,17 @@ bool NyquistEffect::ProcessOne()
    }
 
    // Put the fetch buffers in a clean initial state
-   for (size_t i = 0; i < mCurNumChannels; i++)
+   for (size_t i = 0; i < mCurNumChannels; i++) {
       mCurBuffer[i].Free();
+      mCurBufferLen[i] = 0;
+   }
 
    // Guarantee release of memory when done
    auto cleanup = finally( [&] {
-      for (size_t i = 0; i < mCurNumChannels; i++)
+      for (size_t i = 0; i < mCurNumChannels; i++) {
          mCurBuffer[i].Free();
+         mCurBufferLen[i] = 0;
+      }
    } );
 
    // Evaluate the expression, which may invoke the get callback, but often does
@@ -1528,7 +1533,7 @@ bool NyquistEffect::ProcessOne()
 
       // Clean the initial buffer states again for the get callbacks
       // -- is this really needed?
-      mCurBuffer[i].Free();
+      mCurBufferLen[i] = 0;
    }
 
    // Now fully evaluate the sound
@@ -2308,33 +2313,35 @@ int NyquistEffect::StaticGetCallback(float *buffer, int channel,
 int NyquistEffect::GetCallback(float *buffer, int ch,
                                long start, long len, long WXUNUSED(totlen))
 {
-   if (mCurBuffer[ch].ptr()) {
+   if (mCurBufferLen[ch] > 0) {
       if ((mCurStart[ch] + start) < mCurBufferStart[ch] ||
           (mCurStart[ch] + start)+len >
           mCurBufferStart[ch]+mCurBufferLen[ch]) {
-         mCurBuffer[ch].Free();
+         mCurBufferLen[ch] = 0;
       }
    }
 
-   if (!mCurBuffer[ch].ptr()) {
+   if (mCurBufferLen[ch] == 0) {
       mCurBufferStart[ch] = (mCurStart[ch] + start);
-      mCurBufferLen[ch] = mCurTrack[ch]->GetBestBlockSize(mCurBufferStart[ch]);
+      auto blockLen = mCurTrack[ch]->GetBestBlockSize(mCurBufferStart[ch]);
 
-      if (mCurBufferLen[ch] < (size_t) len) {
-         mCurBufferLen[ch] = mCurTrack[ch]->GetIdealBlockSize();
+      if (blockLen < (size_t) len) {
+         blockLen = mCurTrack[ch]->GetIdealBlockSize();
       }
 
       mCurBufferLen[ch] =
-         limitSampleBufferSize( mCurBufferLen[ch],
+         limitSampleBufferSize( blockLen,
                                 mCurStart[ch] + mCurLen - mCurBufferStart[ch] );
 
-      mCurBuffer[ch].Allocate(mCurBufferLen[ch], floatSample);
+      // The buffer is kept between fetches and only grows
+      mCurBuffer[ch].Resize(mCurBufferLen[ch], floatSample);
       try {
          mCurTrack[ch]->Get(
             mCurBuffer[ch].ptr(), floatSample,
             mCurBufferStart[ch], mCurBufferLen[ch]);
       }
       catch ( ... ) {
+         mCurBufferLen[ch] = 0;
          // Save the exception object for re-throw when out of the library
          mpException = std::current_exception();
          return -1;
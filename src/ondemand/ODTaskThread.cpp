@@ -18,6 +18,17 @@
 
 #include "ODTaskThread.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
 
 #ifdef __WXMAC__
 ODCondition::ODCondition(ODLock *lock)
@@ -46,3 +57,143 @@ void ODCondition::Wait()
 
 #endif
 
+namespace {
+
+// One call of ParallelFor, shared by the threads that work on it
+struct ParallelJob {
+   ParallelJob( size_t count_, const std::function< void(size_t) > &task_ )
+      : count{ count_ }, task{ task_ } {}
+
+   // Runs tasks until none are left
+   void Work()
+   {
+      for (size_t ii; (ii = next++) < count;) {
+         try {
+            task( ii );
+         }
+         catch (...) {
+            std::lock_guard< std::mutex > lock{ errorMutex };
+            if (!error)
+               error = std::current_exception();
+            // Skip the remaining tasks
+            next = count;
+         }
+      }
+   }
+
+   bool Started() const { return next >= count; }
+
+   const size_t count;
+   const std::function< void(size_t) > &task;
+   std::atomic< size_t > next{ 0 };
+   size_t active{ 0 }; // pool threads in Work(), guarded by the pool's mutex
+   std::mutex errorMutex;
+   std::exception_ptr error;
+};
+
+class WorkerPool {
+public:
+   static WorkerPool &Get()
+   {
+      static WorkerPool pool;
+      return pool;
+   }
+
+   void Run( ParallelJob &job, const std::function< void() > &poll )
+   {
+      std::unique_lock< std::mutex > lock{ mMutex };
+      mJobs.push_back( &job );
+      mWork.notify_all();
+
+      if (!poll || mThreads.empty()) {
+         lock.unlock();
+         job.Work();
+         lock.lock();
+      }
+      else {
+         while (!(job.Started() && job.active == 0)) {
+            mDone.wait_for( lock, std::chrono::milliseconds( 20 ) );
+            lock.unlock();
+            poll();
+            lock.lock();
+         }
+      }
+
+      // No pool thread may take the job after this, and those that have it
+      // must finish before it goes out of scope
+      auto iter = std::find( mJobs.begin(), mJobs.end(), &job );
+      if (iter != mJobs.end())
+         mJobs.erase( iter );
+      mDone.wait( lock, [&]{ return job.active == 0; } );
+   }
+
+private:
+   WorkerPool()
+   {
+      const auto nThreads = std::max( 2u, std::thread::hardware_concurrency() );
+      for (size_t tt = 0; tt < nThreads; ++tt) {
+         try {
+            mThreads.emplace_back( [this]{ Loop(); } );
+         }
+         catch (const std::system_error &) {
+            // Make do with the threads already started
+            break;
+         }
+      }
+   }
+
+   ~WorkerPool()
+   {
+      {
+         std::lock_guard< std::mutex > lock{ mMutex };
+         mStopping = true;
+      }
+      mWork.notify_all();
+      for (auto &thread : mThreads)
+         thread.join();
+   }
+
+   void Loop()
+   {
+      std::unique_lock< std::mutex > lock{ mMutex };
+      while (true) {
+         mWork.wait( lock, [this]{ return mStopping || !mJobs.empty(); } );
+         if (mStopping)
+            break;
+
+         auto &job = *mJobs.front();
+         if (job.Started()) {
+            // Nothing more to take; the caller waits for the rest
+            mJobs.pop_front();
+            continue;
+         }
+
+         ++job.active;
+         lock.unlock();
+         job.Work();
+         lock.lock();
+         if (--job.active == 0)
+            mDone.notify_all();
+      }
+   }
+
+   std::mutex mMutex;
+   std::condition_variable mWork, mDone;
+   std::deque< ParallelJob* > mJobs;
+   std::vector< std::thread > mThreads;
+   bool mStopping{ false };
+};
+
+}
+
+void ParallelFor( size_t count, const std::function< void(size_t) > &task,
+   const std::function< void() > &poll )
+{
+   if (count == 0)
+      return;
+
+   ParallelJob job{ count, task };
+   WorkerPool::Get().Run( job, poll );
+   if (job.error)
+      std::rethrow_exception( job.error );
+}
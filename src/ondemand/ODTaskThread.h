@@ -28,6 +28,8 @@
 
 #include "../MemoryX.h"
 
+#include <functional>
+
 class ODTask;
 
 #ifdef __WXMAC__
@@ -149,5 +151,16 @@ public:
    ODLocker &operator= (const ODLocker &that) PROHIBITED;
 };
 
+// Calls task(ii) for each ii less than count, on a pool of threads, one per
+// processor (but at least two), that is made once and kept for the life of
+// the program.  Returns when all are done, rethrowing the first exception;
+// the tasks not yet begun are then skipped.
+// Without poll, this thread does a share of the tasks, so that a task may
+// itself call ParallelFor.  With poll, this thread only calls poll() now and
+// then, as to update a progress dialog; a task may not then call ParallelFor.
+AUDACITY_DLL_API
+void ParallelFor( size_t count, const std::function< void(size_t) > &task,
+   const std::function< void() > &poll = {} );
+
 #endif //__AUDACITY_ODTASKTHREAD__
 
@@ -33,6 +33,7 @@
 #include <wx/utils.h>
 
 #include "../FileNames.h"
+#include "../blockfile/SimpleBlockFile.h"
 #include "../Prefs.h"
 #include "../ShuttleGui.h"
 #include "../widgets/AudacityMessageBox.h"
@@ -120,6 +121,35 @@ void DirectoriesPrefs::PopulateOrExchange(ShuttleGui & S)
    }
    S.EndStatic();
 
+   S.StartStatic(XO("Block cache"));
+   {
+      S.StartTwoColumn();
+      {
+         S.TieIntegerTextBox(XO("&Memory for recently read audio (MB):"),
+                             {wxT("/Directories/BlockCacheSize"), 64},
+                             9);
+      }
+      S.EndTwoColumn();
+
+      if (S.GetMode() == eIsCreating) {
+         const auto stats = SampleBlockCache::Get().GetStatistics();
+         S.AddVariableText(
+            XO("In use: %.1f MB.  Hits: %llu, misses: %llu, evictions: %llu.")
+               .Format( stats.bytes / (1024.0 * 1024.0),
+                  stats.hits, stats.misses, stats.evictions ),
+            false, 0, 600);
+      }
+   }
+   S.EndStatic();
+
+   S.StartStatic(XO("Project data"));
+   {
+      S.TieCheckBox(XO("Compress audio data of new projects &losslessly"),
+                    wxT("/Directories/CompressBlocks"),
+                    false);
+   }
+   S.EndStatic();
+
 #ifdef DEPRECATED_AUDIO_CACHE
    // See http://bugzilla.audacityteam.org/show_bug.cgi?id=545.
    S.StartStatic(XO("Audio cache"));
@@ -286,6 +316,8 @@ bool DirectoriesPrefs::Commit()
    ShuttleGui S(this, eIsSavingToPrefs);
    PopulateOrExchange(S);
 
+   SampleBlockCache::Get().ReadPrefs();
+
    return true;
 }
 
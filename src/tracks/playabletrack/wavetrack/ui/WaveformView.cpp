@@ -21,10 +21,13 @@ Paul Licameli split from WaveTrackView.cpp
 #include "../../../ui/EnvelopeHandle.h"
 #include "../../../ui/TimeShiftHandle.h"
 #include "../../../../AColor.h"
+#include "../../../../AllThemeResources.h"
 #include "../../../../Envelope.h"
 #include "../../../../EnvelopeEditor.h"
 #include "../../../../ProjectSettings.h"
 #include "../../../../SelectedRegion.h"
+#include "../../../../Sequence.h"
+#include "../../../../Theme.h"
 #include "../../../../TrackArtist.h"
 #include "../../../../TrackPanelDrawingContext.h"
 #include "../../../../TrackPanelMouseEvent.h"
@@ -33,8 +36,16 @@ Paul Licameli split from WaveTrackView.cpp
 #include "../../../../WaveTrack.h"
 #include "../../../../prefs/WaveformSettings.h"
 
+#include <algorithm>
+#include <cstring>
+#include <list>
+#include <vector>
+
 #include <wx/graphics.h>
 #include <wx/dc.h>
+#include <wx/dcmemory.h>
+#include <wx/gdicmn.h>
+#include <wx/image.h>
 
 static WaveTrackSubView::Type sType{
    WaveTrackViewConstants::Waveform,
@@ -281,6 +292,55 @@ void DrawWaveformBackground(TrackPanelDrawingContext &context,
    }
 }
 
+// Vertical runs of pixels, painted into an image with alpha, which is then
+// drawn in one step.  This is much cheaper than a DC call for each pixel
+// column when many wide tracks are visible.
+class WaveRaster
+{
+public:
+   explicit WaveRaster(const wxRect &rect)
+      : mRect{ rect }
+      , mImage{ rect.width, rect.height, false }
+   {
+      // Transparent where nothing is painted, so the background shows
+      mImage.SetAlpha();
+      mData = mImage.GetData();
+      mAlpha = mImage.GetAlpha();
+      memset(mAlpha, 0, size_t(rect.width) * rect.height);
+   }
+
+   // Paint rows y0 through y1 of column x, relative to the rectangle
+   void Column(int x, int y0, int y1, const wxColour &colour)
+   {
+      if (x < 0 || x >= mRect.width)
+         return;
+      if (y0 > y1)
+         std::swap(y0, y1);
+      y0 = std::max(y0, 0);
+      y1 = std::min(y1, mRect.height - 1);
+      const auto red = colour.Red(), green = colour.Green(),
+         blue = colour.Blue();
+      for (int yy = y0; yy <= y1; ++yy) {
+         const size_t px = size_t(yy) * mRect.width + x;
+         mData[3 * px] = red;
+         mData[3 * px + 1] = green;
+         mData[3 * px + 2] = blue;
+         mAlpha[px] = 255;
+      }
+   }
+
+   void Draw(wxDC &dc) const
+   {
+      dc.DrawBitmap(wxBitmap(mImage), mRect.x, mRect.y);
+   }
+
+private:
+   const wxRect mRect;
+   wxImage mImage;
+   unsigned char *mData{};
+   unsigned char *mAlpha{};
+};
+
 struct WavePortion {
    wxRect rect;
    CONST double averageZoom;
@@ -328,6 +388,8 @@ void DrawMinMaxRMS(
    bool /* showProgress */, bool muted)
 {
    auto &dc = context.dc;
+   if (rect.width <= 0 || rect.height <= 0)
+      return;
 
    // Display a line representing the
    // min and max of the samples in this region
@@ -352,18 +414,19 @@ void DrawMinMaxRMS(
    bool drawStripes = true;
    bool drawWaveform = true;
 
-   const auto &muteSamplePen = artist->muteSamplePen;
-   const auto &samplePen = artist->samplePen;
+   const auto &muteSampleColour = artist->muteSamplePen.GetColour();
+   const auto &sampleColour = artist->samplePen.GetColour();
+
+   WaveRaster raster{ rect };
 
-   dc.SetPen(muted ? muteSamplePen : samplePen);
+   const auto &colour = muted ? muteSampleColour : sampleColour;
    for (int x0 = 0; x0 < rect.width; ++x0) {
-      int xx = rect.x + x0;
       double v;
       v = min[x0] * env[x0];
       if (clipped && bShowClipping && (v <= -MAX_AUDIO))
       {
-         if (clipcnt == 0 || clipped[clipcnt - 1] != xx) {
-            clipped[clipcnt++] = xx;
+         if (clipcnt == 0 || clipped[clipcnt - 1] != x0) {
+            clipped[clipcnt++] = x0;
          }
       }
       h1 = GetWaveYPos(v, zoomMin, zoomMax,
@@ -372,8 +435,8 @@ void DrawMinMaxRMS(
       v = max[x0] * env[x0];
       if (clipped && bShowClipping && (v >= MAX_AUDIO))
       {
-         if (clipcnt == 0 || clipped[clipcnt - 1] != xx) {
-            clipped[clipcnt++] = xx;
+         if (clipcnt == 0 || clipped[clipcnt - 1] != x0) {
+            clipped[clipcnt++] = x0;
          }
       }
       h2 = GetWaveYPos(v, zoomMin, zoomMax,
@@ -410,14 +473,11 @@ void DrawMinMaxRMS(
       if (bl[x0] <= -1) {
          if (drawStripes) {
             // TODO:unify with buffer drawing.
-            dc.SetPen((bl[x0] % 2) ? muteSamplePen : samplePen);
+            const auto &stripeColour =
+               (bl[x0] % 2) ? muteSampleColour : sampleColour;
             for (int yy = 0; yy < rect.height / 25 + 1; ++yy) {
-               // we are drawing over the buffer, but I think DrawLine takes care of this.
-               AColor::Line(dc,
-                            xx,
-                            rect.y + 25 * yy + (x0 /*+pixAnimOffset*/) % 25,
-                            xx,
-                            rect.y + 25 * yy + (x0 /*+pixAnimOffset*/) % 25 + 6); //take the min so we don't draw past the edge
+               const int top = 25 * yy + (x0 /*+pixAnimOffset*/) % 25;
+               raster.Column(x0, top, top + 6, stripeColour);
             }
          }
 
@@ -425,48 +485,39 @@ void DrawMinMaxRMS(
          // Lets use a triangle wave for now since it's easier - I don't want to use sin() or make a wavetable just for this.
          if (drawWaveform) {
             int triX;
-            dc.SetPen(samplePen);
             triX = fabs((double)((x0 + pixAnimOffset) % (2 * rect.height)) - rect.height) + rect.height;
             for (int yy = 0; yy < rect.height; ++yy) {
                if ((yy + triX) % rect.height == 0) {
-                  dc.DrawPoint(xx, rect.y + yy);
+                  raster.Column(x0, yy, yy, sampleColour);
                }
             }
          }
-
-         // Restore the pen for remaining pixel columns!
-         dc.SetPen(muted ? muteSamplePen : samplePen);
       }
       else {
-         AColor::Line(dc, xx, rect.y + h2, xx, rect.y + h1);
+         raster.Column(x0, h2, h1, colour);
       }
    }
 
    // Stroke rms over the min-max
-   const auto &muteRmsPen = artist->muteRmsPen;
-   const auto &rmsPen = artist->rmsPen;
-
-   dc.SetPen(muted ? muteRmsPen : rmsPen);
+   const auto &rmsColour =
+      (muted ? artist->muteRmsPen : artist->rmsPen).GetColour();
    for (int x0 = 0; x0 < rect.width; ++x0) {
-      int xx = rect.x + x0;
       if (bl[x0] <= -1) {
       }
       else if (r1[x0] != r2[x0]) {
-         AColor::Line(dc, xx, rect.y + r2[x0], xx, rect.y + r1[x0]);
+         raster.Column(x0, r2[x0], r1[x0], rmsColour);
       }
    }
 
    // Draw the clipping lines
    if (clipcnt) {
-      const auto &muteClippedPen = artist->muteClippedPen;
-      const auto &clippedPen = artist->clippedPen;
-
-      dc.SetPen(muted ? muteClippedPen : clippedPen);
-      while (--clipcnt >= 0) {
-         int xx = clipped[clipcnt];
-         AColor::Line(dc, xx, rect.y, xx, rect.y + rect.height);
-      }
+      const auto &clippedColour =
+         (muted ? artist->muteClippedPen : artist->clippedPen).GetColour();
+      while (--clipcnt >= 0)
+         raster.Column(clipped[clipcnt], 0, rect.height, clippedColour);
    }
+
+   raster.Draw(dc);
 }
 
 void DrawIndividualSamples(TrackPanelDrawingContext &context,
@@ -564,35 +615,43 @@ void DrawIndividualSamples(TrackPanelDrawingContext &context,
    }
 
    const auto sampleDisplay = artist->mSampleDisplay;
-   if (showPoints && (sampleDisplay == (int) WaveTrackViewConstants::StemPlot)) {
+   const bool stems =
+      showPoints && (sampleDisplay == (int) WaveTrackViewConstants::StemPlot);
+   if (!stems) {
+      // Connect samples with straight lines, as one polyline; only its ends
+      // need drawing again to include them on all platforms
+      std::vector<wxPoint> points;
+      points.reserve(slen);
+      for (decltype(slen) s = 0; s < slen; s++)
+         points.emplace_back(rect.x + xpos[s], rect.y + ypos[s]);
+      if (slen > 1)
+         dc.DrawLines(points.size(), points.data());
+      dc.DrawPoint(points.front());
+      dc.DrawPoint(points.back());
+   }
+
+   if (!(stems || clipcnt) || rect.width <= 0 || rect.height <= 0)
+      return;
+
+   WaveRaster raster{ rect };
+
+   if (stems) {
       // Draw vertical lines
       int yZero = GetWaveYPos(0.0, zoomMin, zoomMax, rect.height, dB, true, dBRange, false);
-      yZero = rect.y + std::max(-1, std::min(rect.height, yZero));
-      for (decltype(slen) s = 0; s < slen; s++) {
-         AColor::Line(dc,
-                     rect.x + xpos[s], rect.y + ypos[s],
-                     rect.x + xpos[s], yZero);
-      }
-   }
-   else {
-      // Connect samples with straight lines
-      for (decltype(slen) s = 0; s < slen - 1; s++) {
-         AColor::Line(dc,
-                     rect.x + xpos[s], rect.y + ypos[s],
-                     rect.x + xpos[s + 1], rect.y + ypos[s + 1]);
-      }
+      yZero = std::max(-1, std::min(rect.height, yZero));
+      for (decltype(slen) s = 0; s < slen; s++)
+         raster.Column(xpos[s], ypos[s], yZero, pen.GetColour());
    }
 
    // Draw clipping
    if (clipcnt) {
-      const auto &muteClippedPen = artist->muteClippedPen;
-      const auto &clippedPen = artist->clippedPen;
-      dc.SetPen(muted ? muteClippedPen : clippedPen);
-      while (--clipcnt >= 0) {
-         auto s = clipped[clipcnt];
-         AColor::Line(dc, rect.x + s, rect.y, rect.x + s, rect.y + rect.height);
-      }
+      const auto &clippedColour =
+         (muted ? artist->muteClippedPen : artist->clippedPen).GetColour();
+      while (--clipcnt >= 0)
+         raster.Column(clipped[clipcnt], 0, rect.height, clippedColour);
    }
+
+   raster.Draw(dc);
 }
 
 void DrawEnvLine(
@@ -669,7 +728,8 @@ void DrawClipWaveform(TrackPanelDrawingContext &context,
                                    const WaveClip *clip,
                                    const wxRect & rect,
                                    bool dB,
-                                   bool muted)
+                                   bool muted,
+                                   bool &anyLoadingOD)
 {
    auto &dc = context.dc;
    const auto artist = TrackArtist::Get( context );
@@ -791,6 +851,7 @@ void DrawClipWaveform(TrackPanelDrawingContext &context,
          if (!clip->GetWaveDisplay(display,
             t0, pps, isLoadingOD))
             return;
+         anyLoadingOD = anyLoadingOD || isLoadingOD;
       }
    }
 
@@ -843,6 +904,7 @@ void DrawClipWaveform(TrackPanelDrawingContext &context,
                      fisheyeDisplay, t0, -1.0, // ignored
                      isLoadingOD))
                   continue; // serious error.  just don't draw??
+            anyLoadingOD = anyLoadingOD || isLoadingOD;
             useMin = fisheyeDisplay.min;
             useMax = fisheyeDisplay.max;
             useRms = fisheyeDisplay.rms;
@@ -975,7 +1037,7 @@ void DrawTimeSlider( TrackPanelDrawingContext &context,
 void WaveformView::DoDraw(TrackPanelDrawingContext &context,
                                const WaveTrack *track,
                                const wxRect & rect,
-                               bool muted)
+                               bool muted, bool &loadingOD)
 {
    auto &dc = context.dc;
    const auto artist = TrackArtist::Get( context );
@@ -997,7 +1059,7 @@ void WaveformView::DoDraw(TrackPanelDrawingContext &context,
 
    for (const auto &clip: track->GetClips())
       DrawClipWaveform(context, track, clip.get(), rect,
-                       dB, muted);
+                       dB, muted, loadingOD);
 
    DrawBoldBoundaries( context, track, rect );
 
@@ -1008,6 +1070,149 @@ void WaveformView::DoDraw(TrackPanelDrawingContext &context,
    }
 }
 
+struct WaveformView::DrawingCache
+{
+   DrawingCache() = default;
+   DrawingCache(const DrawingCache&) = delete;
+   DrawingCache &operator=(const DrawingCache&) = delete;
+   ~DrawingCache() { Unlist(); }
+
+   // Everything the drawing depends on, but the identities of objects
+   std::vector<double> key;
+   std::vector<const void*> objects;
+
+   wxBitmap bitmap;
+   // The display rectangles that drawing set in the clips, which must be
+   // set again when the bitmap is reused
+   std::vector<wxRect> displayRects;
+
+   // Marks this as the most recently shown, and frees the bitmaps of the
+   // least recently shown beyond twice the area of the display, so that
+   // tracks scrolled away or hidden do not hold theirs
+   void Touch();
+
+private:
+   void Unlist();
+   void Free();
+
+   using List = std::list<DrawingCache*>;
+   static List &LRU(); // most recent at the front
+   List::iterator position;
+   bool listed{ false };
+};
+
+auto WaveformView::DrawingCache::LRU() -> List &
+{
+   static List list;
+   return list;
+}
+
+void WaveformView::DrawingCache::Unlist()
+{
+   if (listed) {
+      LRU().erase(position);
+      listed = false;
+   }
+}
+
+void WaveformView::DrawingCache::Free()
+{
+   Unlist();
+   bitmap = wxBitmap{};
+   key.clear();
+   objects.clear();
+   displayRects.clear();
+}
+
+void WaveformView::DrawingCache::Touch()
+{
+   auto &lru = LRU();
+   Unlist();
+   if (!bitmap.IsOk())
+      return;
+   lru.push_front(this);
+   position = lru.begin();
+   listed = true;
+
+   const auto displaySize = ::wxGetDisplaySize();
+   const auto budget =
+      2 * std::max(1, displaySize.x) * size_t(std::max(1, displaySize.y));
+   size_t pixels = 0;
+   for (auto iter = lru.begin(); iter != lru.end();) {
+      auto pCache = *iter++;
+      const auto &cached = pCache->bitmap;
+      pixels += size_t(cached.GetWidth()) * cached.GetHeight();
+      // Always keep the one just shown
+      if (pixels > budget && pCache != this)
+         pCache->Free();
+   }
+}
+
+namespace {
+
+void MakeDrawingKey(TrackPanelDrawingContext &context,
+   const WaveTrack *track, const wxRect &rect, bool muted,
+   std::vector<double> &key, std::vector<const void*> &objects)
+{
+   const auto artist = TrackArtist::Get( context );
+   const auto &zoomInfo = *artist->pZoomInfo;
+   const auto &settings = track->GetWaveformSettings();
+
+   float zoomMin, zoomMax;
+   track->GetDisplayBounds(&zoomMin, &zoomMax);
+
+   const bool selected = track->GetSelected();
+   const bool syncLockSelected = track->IsSyncLockSelected();
+
+   key = {
+      double(rect.x), double(rect.y), double(rect.width), double(rect.height),
+      zoomInfo.h, zoomInfo.GetZoom(),
+      double(selected), double(syncLockSelected), double(muted),
+      zoomMin, zoomMax, double(settings.scaleType), settings.dBRange,
+      double(artist->drawEnvelope), double(artist->drawSliders),
+      double(artist->bigPoints), double(artist->mShowClipping),
+      double(artist->mSampleDisplay),
+      // Changes of theme
+      double(theTheme.Colour(clrBlank).GetRGB()),
+      double(theTheme.Colour(clrSelected).GetRGB()),
+      double(theTheme.Colour(clrSample).GetRGB()),
+   };
+   // Only selected tracks show the selection
+   if (selected || syncLockSelected) {
+      key.push_back(artist->pSelectedRegion->t0());
+      key.push_back(artist->pSelectedRegion->t1());
+   }
+
+   objects = { track };
+   for (const auto &clip : track->GetClips()) {
+      objects.push_back(clip.get());
+      // Clips made by undo might reuse the address and count of changes
+      // of another, but not its block files
+      const auto &blocks = *clip->GetSequenceBlockArray();
+      if (!blocks.empty()) {
+         objects.push_back(blocks.front().f.get());
+         objects.push_back(blocks.back().f.get());
+      }
+      const auto &envelope = *clip->GetEnvelope();
+      const auto nPoints = envelope.GetNumberOfPoints();
+      key.insert(key.end(), {
+         double(clip->GetDirty()), clip->GetOffset(), double(clip->GetRate()),
+         clip->GetNumSamples().as_double(), double(clip->GetColourIndex()),
+         envelope.GetOffset(), envelope.GetTrackLen(),
+         double(envelope.GetExponential()),
+         envelope.GetMinValue(), envelope.GetMaxValue(),
+         double(envelope.GetDragPoint()), double(envelope.GetDragPointValid()),
+         double(nPoints),
+      });
+      for (size_t ii = 0; ii < nPoints; ++ii) {
+         key.push_back(envelope[ii].GetT());
+         key.push_back(envelope[ii].GetVal());
+      }
+   }
+}
+
+}
+
 void WaveformView::Draw(
    TrackPanelDrawingContext &context, const wxRect &rect, unsigned iPass )
 {
@@ -1024,17 +1229,88 @@ void WaveformView::Draw(
       const auto hasSolo = artist->hasSolo;
       bool muted = (hasSolo || wt->GetMute()) &&
       !wt->GetSolo();
-      
+
+      // Printing draws at the resolution of the printer
+      if (!dynamic_cast<wxMemoryDC*>(&dc)) {
 #if defined(__WXMAC__)
-      wxAntialiasMode aamode = dc.GetGraphicsContext()->GetAntialiasMode();
-      dc.GetGraphicsContext()->SetAntialiasMode(wxANTIALIAS_NONE);
+         wxAntialiasMode aamode = dc.GetGraphicsContext()->GetAntialiasMode();
+         dc.GetGraphicsContext()->SetAntialiasMode(wxANTIALIAS_NONE);
+#endif
+         bool loadingOD = false;
+         DoDraw(context, wt.get(), rect, muted, loadingOD);
+#if defined(__WXMAC__)
+         dc.GetGraphicsContext()->SetAntialiasMode(aamode);
+#endif
+         CommonTrackView::Draw( context, rect, iPass );
+         return;
+      }
+
+      // Draw into a bitmap, kept for the next repaint, so that editing one
+      // track or moving the play head does not redraw all the others.
+      // (Drawing cannot move off the main thread, because DCs are not
+      // thread-safe.)
+      if (!mpDrawingCache)
+         mpDrawingCache = std::make_unique<DrawingCache>();
+      auto &cache = *mpDrawingCache;
+
+      std::vector<double> key;
+      std::vector<const void*> objects;
+      MakeDrawingKey(context, wt.get(), rect, muted, key, objects);
+#ifdef EXPERIMENTAL_TRACK_PANEL_HIGHLIGHTING
+      // The drawing also depends on the hovered handle
+      objects.push_back(context.target.get());
 #endif
-      
-      DoDraw(context, wt.get(), rect, muted);
+
+      const auto &clips = wt->GetClips();
+      if (cache.bitmap.IsOk() &&
+          key == cache.key && objects == cache.objects &&
+          clips.size() == cache.displayRects.size()) {
+         size_t ii = 0;
+         for (const auto &clip : clips)
+            clip->SetDisplayRect(cache.displayRects[ii++]);
+      }
+      else if (rect.width > 0 && rect.height > 0) {
+         if (!(cache.bitmap.IsOk() &&
+               cache.bitmap.GetWidth() == rect.width &&
+               cache.bitmap.GetHeight() == rect.height))
+            cache.bitmap.Create(rect.width, rect.height);
+         wxMemoryDC memDC;
+         memDC.SelectObject(cache.bitmap);
+         // Draw at the same coordinates as in the panel
+         memDC.SetDeviceOrigin(-rect.x, -rect.y);
+         TrackPanelDrawingContext cacheContext{
+            memDC, context.target, context.lastState, context.pUserData };
 
 #if defined(__WXMAC__)
-      dc.GetGraphicsContext()->SetAntialiasMode(aamode);
+         memDC.GetGraphicsContext()->SetAntialiasMode(wxANTIALIAS_NONE);
 #endif
+
+         bool loadingOD = false;
+         DoDraw(cacheContext, wt.get(), rect, muted, loadingOD);
+         memDC.SelectObject(wxNullBitmap);
+
+         cache.displayRects.clear();
+         for (const auto &clip : clips) {
+            wxRect displayRect;
+            clip->GetDisplayRect(&displayRect);
+            cache.displayRects.push_back(displayRect);
+         }
+         // Placeholders for data not yet loaded are animated
+         if (loadingOD) {
+            cache.key.clear();
+            cache.objects.clear();
+         }
+         else {
+            cache.key = std::move(key);
+            cache.objects = std::move(objects);
+         }
+      }
+      else
+         cache.bitmap = wxBitmap{};
+
+      cache.Touch();
+      if (cache.bitmap.IsOk())
+         dc.DrawBitmap(cache.bitmap, rect.x, rect.y);
    }
    CommonTrackView::Draw( context, rect, iPass );
 }
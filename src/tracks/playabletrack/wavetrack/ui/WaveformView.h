@@ -36,10 +36,12 @@ private:
    void Draw(
       TrackPanelDrawingContext &context,
       const wxRect &rect, unsigned iPass ) override;
+   // Sets loadingOD if any of the drawing is a placeholder for data not
+   // yet loaded
    static void DoDraw(TrackPanelDrawingContext &context,
                                const WaveTrack *track,
                                const wxRect & rect,
-                               bool muted);
+                               bool muted, bool &loadingOD);
 
    std::vector<UIHandlePtr> DetailedHitTest(
       const TrackPanelMouseState &state,
@@ -51,6 +53,12 @@ protected:
 
    std::weak_ptr<SampleHandle> mSampleHandle;
    std::weak_ptr<EnvelopeHandle> mEnvelopeHandle;
+
+private:
+   // The last drawing of the track area, reused while nothing that it
+   // depends on has changed
+   struct DrawingCache;
+   std::unique_ptr<DrawingCache> mpDrawingCache;
 };
 
 #endif
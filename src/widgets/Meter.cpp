@@ -63,6 +63,12 @@
 
 #include <math.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+   (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define METER_SSE2
+#include <emmintrin.h>
+#endif
+
 #include "../AudioIO.h"
 #include "../AColor.h"
 #include "../ImageManipulation.h"
@@ -71,6 +77,7 @@
 #include "../ProjectAudioManager.h"
 #include "../ProjectStatus.h"
 #include "../Prefs.h"
+#include "../RingBuffer.h"
 #include "../ShuttleGui.h"
 
 #include "../AllThemeResources.h"
@@ -157,6 +164,10 @@ public:
 static const long MIN_REFRESH_RATE = 1;
 static const long MAX_REFRESH_RATE = 100;
 
+// Samples in the tap: a quarter second of stereo at 384 kHz, or of more
+// channels at lower rates
+static const size_t kMeterTapSize = 1 << 18;
+
 /* Updates to the meter are passed across via meter updates, each contained in
  * a MeterUpdateMsg object */
 wxString MeterUpdateMsg::toString()
@@ -210,23 +221,30 @@ void MeterUpdateQueue::Clear()
    mEnd = 0;
 }
 
-// Add a message to the end of the queue.  Return false if the
-// queue was full.
-bool MeterUpdateQueue::Put(MeterUpdateMsg &msg)
+// For the writer only: whether Put would fail
+bool MeterUpdateQueue::IsFull() const
 {
-   // mStart can be greater than mEnd because it is all mod mBufferSize
-   wxASSERT( (mEnd + mBufferSize - mStart) >= 0 );
-   int len = (mEnd + mBufferSize - mStart) % mBufferSize;
+   auto start = mStart.load( std::memory_order_acquire );
+   auto end = mEnd.load( std::memory_order_relaxed );
+   int len = (end + mBufferSize - start) % mBufferSize;
 
    // Never completely fill the queue, because then the
    // state is ambiguous (mStart==mEnd)
-   if (len + 1 >= (int)(mBufferSize))
+   return len + 1 >= (int)(mBufferSize);
+}
+
+// Add a message to the end of the queue.  Return false if the
+// queue was full.
+bool MeterUpdateQueue::Put(MeterUpdateMsg &msg)
+{
+   if (IsFull())
       return false;
 
    //wxLogDebug(wxT("Put: %s"), msg.toString());
 
-   mBuffer[mEnd] = msg;
-   mEnd = (mEnd+1)%mBufferSize;
+   auto end = mEnd.load( std::memory_order_relaxed );
+   mBuffer[end] = msg;
+   mEnd.store( (end+1)%mBufferSize, std::memory_order_release );
 
    return true;
 }
@@ -235,13 +253,15 @@ bool MeterUpdateQueue::Put(MeterUpdateMsg &msg)
 // Return false if the queue was empty.
 bool MeterUpdateQueue::Get(MeterUpdateMsg &msg)
 {
-   int len = (mEnd + mBufferSize - mStart) % mBufferSize;
+   auto start = mStart.load( std::memory_order_relaxed );
+   auto end = mEnd.load( std::memory_order_acquire );
+   int len = (end + mBufferSize - start) % mBufferSize;
 
    if (len == 0)
       return false;
 
-   msg = mBuffer[mStart];
-   mStart = (mStart+1)%mBufferSize;
+   msg = mBuffer[start];
+   mStart.store( (start+1)%mBufferSize, std::memory_order_release );
 
    return true;
 }
@@ -333,6 +353,10 @@ MeterPanel::MeterPanel(AudacityProject *project,
    SetAccessible(safenew MeterAx(this));
 #endif
 
+   // The tap is never reallocated, because UpdateDisplay may be putting
+   // samples into it at any time
+   mTap = std::make_unique<RingBuffer>(floatSample, kMeterTapSize);
+
    // Do this BEFORE UpdatePrefs()!
    mRuler.SetFonts(GetFont(), GetFont(), GetFont());
    mRuler.SetFlip(mStyle != MixerTrackCluster);
@@ -405,9 +429,13 @@ MeterPanel::MeterPanel(AudacityProject *project,
    Reset(44100.0, true);
 }
 
+MeterPanel::~MeterPanel()
+{
+}
+
 void MeterPanel::Clear()
 {
-   mQueue.Clear();
+   DiscardQueue();
 }
 
 void MeterPanel::UpdatePrefs()
@@ -925,7 +953,10 @@ void MeterPanel::Reset(double sampleRate, bool resetClipping)
    mTimer.Stop();
 
    // While it's stopped, empty the queue
-   mQueue.Clear();
+   DiscardQueue();
+
+   if (resetClipping)
+      mChannelLevels.clear();
 
    mLayoutValid = false;
 
@@ -971,42 +1002,192 @@ static float ToDB(float v, float range)
    return ClipZeroToOne((db + range) / range);
 }
 
-void MeterPanel::UpdateDisplay(unsigned numChannels, int numFrames, float *sampleData)
+// Finds the peak, the sum of squares and the runs of clipped samples of each
+// of numChannels channels in a block of interleaved samples
+static void AnalyzeMeterBlock(const float *samples, unsigned stride,
+   unsigned numChannels, int numFrames, int numPeakSamplesToClip,
+   MeterChannelStats *stats)
 {
-   float *sptr = sampleData;
-   auto num = std::min(numChannels, mNumBars);
-   MeterUpdateMsg msg;
+   for (unsigned j = 0; j < numChannels; j++)
+      stats[j] = MeterChannelStats{};
+   if (numChannels == 0 || numFrames <= 0)
+      return;
 
-   memset(&msg, 0, sizeof(msg));
-   msg.numFrames = numFrames;
+   unsigned j = 0;
+#ifdef METER_SSE2
+   const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+   float lanePeak[4], laneSum[4];
+   if (numChannels == stride && 4 % stride == 0) {
+      // Mono, stereo or quad: each lane always holds the same channel
+      const size_t count = size_t(numFrames) * stride;
+      __m128 peak = _mm_setzero_ps(), sum = _mm_setzero_ps();
+      size_t i = 0;
+      for (; i + 4 <= count; i += 4) {
+         const __m128 x = _mm_loadu_ps(samples + i);
+         peak = _mm_max_ps(peak, _mm_and_ps(x, absMask));
+         sum = _mm_add_ps(sum, _mm_mul_ps(x, x));
+      }
+      _mm_storeu_ps(lanePeak, peak);
+      _mm_storeu_ps(laneSum, sum);
+      for (unsigned k = 0; k < 4; k++) {
+         auto &s = stats[k % stride];
+         s.peak = std::max(s.peak, lanePeak[k]);
+         s.sumSquares += laneSum[k];
+      }
+      for (; i < count; i++) {
+         auto &s = stats[i % stride];
+         s.peak = std::max(s.peak, fabsf(samples[i]));
+         s.sumSquares += samples[i] * samples[i];
+      }
+      j = numChannels;
+   }
+   else {
+      // Four adjacent channels at a time
+      for (; j + 4 <= numChannels; j += 4) {
+         __m128 peak = _mm_setzero_ps(), sum = _mm_setzero_ps();
+         const float *sptr = samples + j;
+         for (int i = 0; i < numFrames; i++, sptr += stride) {
+            const __m128 x = _mm_loadu_ps(sptr);
+            peak = _mm_max_ps(peak, _mm_and_ps(x, absMask));
+            sum = _mm_add_ps(sum, _mm_mul_ps(x, x));
+         }
+         _mm_storeu_ps(lanePeak, peak);
+         _mm_storeu_ps(laneSum, sum);
+         for (unsigned k = 0; k < 4; k++) {
+            stats[j + k].peak = lanePeak[k];
+            stats[j + k].sumSquares = laneSum[k];
+         }
+      }
+   }
+#endif
+
+   for (; j < numChannels; j++) {
+      auto &s = stats[j];
+      const float *sptr = samples + j;
+      for (int i = 0; i < numFrames; i++, sptr += stride) {
+         s.peak = std::max(s.peak, fabsf(*sptr));
+         s.sumSquares += *sptr * *sptr;
+      }
+   }
 
-   for(int i=0; i<numFrames; i++) {
-      for(unsigned int j=0; j<num; j++) {
-         msg.peak[j] = floatMax(msg.peak[j], fabs(sptr[j]));
-         msg.rms[j] += sptr[j]*sptr[j];
-
-         // In addition to looking for mNumPeakSamplesToClip peaked
-         // samples in a row, also send the number of peaked samples
-         // at the head and tail, in case there's a run of peaked samples
-         // that crosses block boundaries
-         if (fabs(sptr[j])>=MAX_AUDIO) {
-            if (msg.headPeakCount[j]==i)
-               msg.headPeakCount[j]++;
-            msg.tailPeakCount[j]++;
-            if (msg.tailPeakCount[j] > mNumPeakSamplesToClip)
-               msg.clipping[j] = true;
+   // In addition to looking for mNumPeakSamplesToClip peaked
+   // samples in a row, also send the number of peaked samples
+   // at the head and tail, in case there's a run of peaked samples
+   // that crosses block boundaries.  Only channels that reached the
+   // limit need the second pass.
+   for (j = 0; j < numChannels; j++) {
+      auto &s = stats[j];
+      if (s.peak < MAX_AUDIO)
+         continue;
+      const float *sptr = samples + j;
+      for (int i = 0; i < numFrames; i++, sptr += stride) {
+         if (fabs(*sptr)>=MAX_AUDIO) {
+            if (s.headPeakCount==i)
+               s.headPeakCount++;
+            s.tailPeakCount++;
+            if (s.tailPeakCount > numPeakSamplesToClip)
+               s.clipping = true;
          }
          else
-            msg.tailPeakCount[j] = 0;
+            s.tailPeakCount = 0;
       }
-      sptr += numChannels;
    }
-   for(unsigned int j=0; j<mNumBars; j++)
-      msg.rms[j] = sqrt(msg.rms[j]/numFrames);
+}
+
+static void SetMessageLevels(
+   MeterUpdateMsg &msg, const MeterChannelStats *stats, unsigned num)
+{
+   for(unsigned int j=0; j<num; j++) {
+      msg.peak[j] = stats[j].peak;
+      msg.rms[j] = sqrt(stats[j].sumSquares/msg.numFrames);
+      msg.clipping[j] = stats[j].clipping;
+      msg.headPeakCount[j] = stats[j].headPeakCount;
+      msg.tailPeakCount[j] = stats[j].tailPeakCount;
+   }
+}
+
+void MeterPanel::UpdateDisplay(unsigned numChannels, int numFrames, float *sampleData)
+{
+   MeterUpdateMsg msg;
+
+   memset(&msg, 0, sizeof(msg));
+   msg.numFrames = numFrames;
+   msg.numChannels = numChannels;
+
+   // Usually just pass the samples on to OnMeterUpdate
+   const size_t count = size_t(std::max(numFrames, 0)) * numChannels;
+   if (!mQueue.IsFull() && mTap->AvailForPut() >= count) {
+      mTap->Put((samplePtr)sampleData, floatSample, count);
+      msg.inTap = true;
+      mQueue.Put(msg);
+      return;
+   }
+
+   // Otherwise measure the first channels here, as many as can be displayed
+   MeterChannelStats stats[kMaxMeterBars];
+   auto num = std::min(numChannels, (unsigned)kMaxMeterBars);
+   AnalyzeMeterBlock(sampleData, numChannels, num, numFrames,
+      mNumPeakSamplesToClip, stats);
+   SetMessageLevels(msg, stats, num);
 
    mQueue.Put(msg);
 }
 
+// Computes the levels of a block that UpdateDisplay left in the tap
+void MeterPanel::AnalyzeTap(MeterUpdateMsg &msg)
+{
+   const auto numChannels = msg.numChannels;
+   const size_t count = size_t(msg.numFrames) * numChannels;
+
+   mTapBlock.resize(count);
+   mTap->Get((samplePtr)mTapBlock.data(), floatSample, count);
+
+   mTapStats.resize(numChannels);
+   AnalyzeMeterBlock(mTapBlock.data(), numChannels, numChannels,
+      msg.numFrames, mNumPeakSamplesToClip, mTapStats.data());
+   SetMessageLevels(msg, mTapStats.data(), std::min(numChannels, mNumBars));
+
+   // Keep the levels of all channels for scripting
+   mChannelLevels.resize(numChannels, MeterChannelLevels{});
+   for (unsigned j = 0; j < numChannels; j++) {
+      auto &levels = mChannelLevels[j];
+      const auto &stats = mTapStats[j];
+      levels.peak = stats.peak;
+      levels.rms = sqrt(stats.sumSquares / msg.numFrames);
+      levels.clipping = levels.clipping || stats.clipping;
+   }
+}
+
+// Keeps the levels of a block that UpdateDisplay measured itself.  Only the
+// first channels were measured, and the others keep their previous levels.
+void MeterPanel::KeepMessageLevels(const MeterUpdateMsg &msg)
+{
+   if (mChannelLevels.size() < msg.numChannels)
+      mChannelLevels.resize(msg.numChannels, MeterChannelLevels{});
+   const auto num = std::min(msg.numChannels, (unsigned)kMaxMeterBars);
+   for (unsigned j = 0; j < num; j++) {
+      auto &levels = mChannelLevels[j];
+      levels.peak = msg.peak[j];
+      levels.rms = msg.rms[j];
+      levels.clipping = levels.clipping || msg.clipping[j];
+   }
+}
+
+// Empties the queue through its messages, so that a block UpdateDisplay is
+// still adding stays paired with its message
+void MeterPanel::DiscardQueue()
+{
+   MeterUpdateMsg msg;
+   while (mQueue.Get(msg))
+      if (msg.inTap)
+         mTap->Discard(size_t(msg.numFrames) * msg.numChannels);
+}
+
+std::vector<MeterChannelLevels> MeterPanel::GetChannelLevels() const
+{
+   return mChannelLevels;
+}
+
 // Vaughan, 2010-11-29: This not currently used. See comments in MixerTrackCluster::UpdateMeter().
 //void MeterPanel::UpdateDisplay(int numChannels, int numFrames,
 //                           // Need to make these double-indexed arrays if we handle more than 2 channels.
@@ -1063,7 +1244,7 @@ void MeterPanel::OnMeterUpdate(wxTimerEvent & WXUNUSED(event))
 
    // We shouldn't receive any events if the meter is disabled, but clear it to be safe
    if (mMeterDisabled) {
-      mQueue.Clear();
+      DiscardQueue();
       return;
    }
 
@@ -1075,6 +1256,11 @@ void MeterPanel::OnMeterUpdate(wxTimerEvent & WXUNUSED(event))
    // to process all of them, otherwise we won't handle peaks and
    // peak-hold bars correctly.
    while(mQueue.Get(msg)) {
+      if (msg.inTap)
+         AnalyzeTap(msg);
+      else
+         KeepMessageLevels(msg);
+
       numChanges++;
       double deltaT = msg.numFrames / mRate;
 
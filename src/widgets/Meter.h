@@ -16,6 +16,8 @@
 #ifndef __AUDACITY_METER__
 #define __AUDACITY_METER__
 
+#include <atomic>
+#include <vector>
 #include <wx/setup.h> // for wxUSE_* macros
 #include <wx/brush.h> // member variable
 #include <wx/defs.h>
@@ -27,6 +29,7 @@
 #include "Ruler.h" // member variable
 
 class AudacityProject;
+class RingBuffer;
 
 // Increase this when we add support for multichannel meters
 // (most of the code is already there)
@@ -51,6 +54,8 @@ class MeterUpdateMsg
 {
    public:
    int numFrames;
+   unsigned numChannels;
+   bool inTap; // samples wait in the tap, and the levels are not yet computed
    float peak[kMaxMeterBars];
    float rms[kMaxMeterBars];
    bool clipping[kMaxMeterBars];
@@ -76,16 +81,28 @@ class MeterUpdateQueue
 
    bool Put(MeterUpdateMsg &msg);
    bool Get(MeterUpdateMsg &msg);
+   bool IsFull() const;
 
    void Clear();
 
  private:
-   int              mStart;
-   int              mEnd;
+   // One writer and one reader may use the queue from different threads
+   std::atomic<int> mStart;
+   std::atomic<int> mEnd;
    size_t           mBufferSize;
    ArrayOf<MeterUpdateMsg> mBuffer{mBufferSize};
 };
 
+// Levels of one channel in one block of samples
+struct MeterChannelStats
+{
+   float peak;
+   float sumSquares;
+   bool clipping;
+   int headPeakCount;
+   int tailPeakCount;
+};
+
 class MeterAx;
 
 /********************************************************************//**
@@ -116,6 +133,7 @@ class MeterPanel final : public MeterPanelBase, private PrefsListener
          const wxSize& size = wxDefaultSize,
          Style style = HorizontalStereo,
          float fDecayRate = 60.0f);
+   ~MeterPanel() override;
 
    void SetFocusFromKbd() override;
 
@@ -134,9 +152,10 @@ class MeterPanel final : public MeterPanelBase, private PrefsListener
 
    /** \brief Update the meters with a block of audio data
     *
-    * Process the supplied block of audio data, extracting the peak and RMS
-    * levels to send to the meter. Also record runs of clipped samples to detect
-    * clipping that lies on block boundaries.
+    * Pass the supplied block of audio data to the meter's timer, which
+    * extracts the peak and RMS levels of every channel, and records runs of
+    * clipped samples to detect clipping that lies on block boundaries.  If
+    * the block does not fit in the tap, the levels are extracted here.
     * This method is thread-safe!  Feel free to call from a different thread
     * (like from an audio I/O callback).
     *
@@ -185,6 +204,8 @@ class MeterPanel final : public MeterPanelBase, private PrefsListener
 
    int GetDBRange() const override { return mDB ? mDBRange : -1; }
 
+   std::vector<MeterChannelLevels> GetChannelLevels() const override;
+
  private:
    void UpdatePrefs() override;
    void UpdateSelectedPrefs( int ) override;
@@ -207,6 +228,9 @@ class MeterPanel final : public MeterPanelBase, private PrefsListener
    void OnAudioIOStatus(wxCommandEvent &evt);
 
    void OnMeterUpdate(wxTimerEvent &evt);
+   void AnalyzeTap(MeterUpdateMsg &msg);
+   void KeepMessageLevels(const MeterUpdateMsg &msg);
+   void DiscardQueue();
 
    void HandleLayout(wxDC &dc);
    void SetActiveStyle(Style style);
@@ -229,6 +253,14 @@ class MeterPanel final : public MeterPanelBase, private PrefsListener
    MeterUpdateQueue mQueue;
    wxTimer          mTimer;
 
+   // UpdateDisplay only copies blocks into the tap, and the timer computes
+   // their levels, so that the audio thread does no per-sample work.  It is
+   // allocated once, and blocks that don't fit are measured in UpdateDisplay.
+   std::unique_ptr<RingBuffer> mTap;
+   std::vector<float> mTapBlock;
+   std::vector<MeterChannelStats> mTapStats;
+   std::vector<MeterChannelLevels> mChannelLevels;
+
    int       mWidth;
    int       mHeight;
 
@@ -11,8 +11,17 @@ Paul Licameli split from Meter.h
 #ifndef __AUDACITY_METER_PANEL_BASE__
 #define __AUDACITY_METER_PANEL_BASE__
 
+#include <vector>
 #include "wxPanelWrapper.h"
 
+// The levels of one channel of a meter, as reported to scripting
+struct MeterChannelLevels
+{
+   float peak;    // linear, over the latest block
+   float rms;     // linear, over the latest block
+   bool clipping; // since the last reset
+};
+
 class MeterPanelBase /* not final */
    : public wxPanelWrapper
 {
@@ -30,6 +39,9 @@ public:
    virtual bool IsClipping() const = 0;
    virtual int GetDBRange() const = 0;
 
+   // Levels of every channel the meter has been sent, not only those shown
+   virtual std::vector<MeterChannelLevels> GetChannelLevels() const = 0;
+
    bool AcceptsFocus() const override { return s_AcceptsFocus; }
    bool AcceptsFocusFromKeyboard() const override { return true; }
 
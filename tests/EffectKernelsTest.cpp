@@ -0,0 +1,254 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "effects/Compressor.h"
+#include "effects/Reverb_libSoX.h"
+#include "effects/Wahwah.h"
+
+/* The vector kernels of the effects must give what the scalar code gives,
+ * up to float rounding.  The tolerances are relative to the magnitudes of
+ * the expected results. */
+class EffectKernelsTest
+{
+private:
+   std::vector<float> mInput;
+
+   // Largest difference, relative to the peak of expected
+   static double PeakError(const std::vector<float> &expected,
+                           const std::vector<float> &actual)
+   {
+      double error = 0, peak = 0;
+      for (size_t i = 0; i < expected.size(); i++) {
+         error = std::max<double>(error, fabs(expected[i] - actual[i]));
+         peak = std::max<double>(peak, fabs(expected[i]));
+      }
+      return peak > 0 ? error / peak : error;
+   }
+
+   // Largest difference, relative to each expected value
+   static double SampleError(const std::vector<float> &expected,
+                             const std::vector<float> &actual)
+   {
+      double error = 0;
+      for (size_t i = 0; i < expected.size(); i++) {
+         const double diff = fabs(expected[i] - actual[i]);
+         if (diff > 0)
+            error = std::max(error, diff / fabs(expected[i]));
+      }
+      return error;
+   }
+
+public:
+   EffectKernelsTest()
+   {
+      std::cout << "==> Testing effect kernels\n";
+   }
+
+   void SetUp()
+   {
+      /* Noise with louder bursts, of a length that no vector width
+       * divides */
+      srand(1);
+      mInput.resize(100003);
+      for (size_t i = 0; i < mInput.size(); i++) {
+         const float scale = (i / 5000) % 3 ? 0.01f : 1.0f;
+         mInput[i] = scale * (2.0f * rand() / RAND_MAX - 1.0f);
+      }
+   }
+
+   void TearDown()
+   {
+      mInput.clear();
+   }
+
+   void TestCompressorGain()
+   {
+      std::cout << "\tcompressor gain kernels should agree with the scalar one..." << std::flush;
+
+      const auto &kernels = CompressorKernels::All();
+      std::vector<float> env(mInput.size());
+      for (size_t i = 0; i < env.size(); i++)
+         env[i] = 0.01f + 3.0f * rand() / RAND_MAX;
+
+      for (double compression : { 0.0, 0.5, 0.9 }) {
+         for (double level : { 1.0, 0.1 }) {
+            auto expected = mInput;
+            const float expectedMax = kernels[0].second.gain(
+               expected.data(), env.data(), expected.size(),
+               level, compression, 0);
+
+            for (size_t k = 1; k < kernels.size(); k++) {
+               auto actual = mInput;
+               const float max = kernels[k].second.gain(
+                  actual.data(), env.data(), actual.size(),
+                  level, compression, 0);
+               assert(SampleError(expected, actual) < 1e-6);
+               assert(fabs(max - expectedMax) <= 1e-6 * expectedMax);
+            }
+         }
+      }
+
+      std::cout << "ok (" << kernels.back().first << ")\n";
+   }
+
+   void TestCompressorDecay()
+   {
+      std::cout << "\tcompressor envelope kernels should agree with the scalar one..." << std::flush;
+
+      const auto &kernels = CompressorKernels::All();
+      std::vector<float> levels(mInput.size());
+      for (size_t i = 0; i < levels.size(); i++)
+         levels[i] = fabs(mInput[i]);
+
+      for (bool backward : { false, true }) {
+         for (double factor : { 0.99995, 0.9, 0.5 }) {
+            // Lengths about the vector widths, and the whole input
+            const size_t lengths[] = { 0, 1, 2, 3, 5, 8, 9, levels.size() };
+            for (size_t len : lengths) {
+               std::vector<float> expected(levels.begin(), levels.begin() + len);
+               double expectedLast = 0.3;
+               kernels[0].second.decay(expected.data(), len,
+                  factor, 0.05, expectedLast, backward);
+
+               for (size_t k = 1; k < kernels.size(); k++) {
+                  std::vector<float> actual(levels.begin(), levels.begin() + len);
+                  double last = 0.3;
+                  kernels[k].second.decay(actual.data(), len,
+                     factor, 0.05, last, backward);
+                  assert(SampleError(expected, actual) < 1e-6);
+                  assert(fabs(last - expectedLast) <= 1e-9 * expectedLast);
+               }
+            }
+         }
+      }
+
+      std::cout << "ok (" << kernels.back().first << ")\n";
+   }
+
+   void TestReverb()
+   {
+      std::cout << "\treverb vector kernel should agree with the scalar one..." << std::flush;
+
+#ifdef REVERB_SSE2
+      const float feedback = 0.8f, hfDamping = 0.4f, gain = 0.5f;
+      std::vector<float> expected(mInput.size()), actual(mInput.size());
+      filter_array_t scalar, vector;
+      memset(&scalar, 0, sizeof(scalar));
+      memset(&vector, 0, sizeof(vector));
+      filter_array_create(&scalar, 48000, 0.75, 0.3, 100, 8000);
+      filter_array_create(&vector, 48000, 0.75, 0.3, 100, 8000);
+
+      /* Uneven blocks, so that runs end both at block ends and where the
+       * delay lines wrap */
+      for (size_t pos = 0, len = 1; pos < mInput.size(); len = len * 7 % 4099 + 1) {
+         len = std::min(len, mInput.size() - pos);
+         filter_array_process_scalar(&scalar, len, &mInput[pos], &expected[pos],
+            &feedback, &hfDamping, &gain);
+         filter_array_process_sse2(&vector, len, &mInput[pos], &actual[pos],
+            &feedback, &hfDamping, &gain);
+         pos += len;
+      }
+      filter_array_delete(&scalar);
+      filter_array_delete(&vector);
+
+      assert(PeakError(expected, actual) < 2e-6);
+      std::cout << "ok\n";
+#else
+      std::cout << "skipped, no vector kernel\n";
+#endif
+   }
+
+   void TestWahwah()
+   {
+      std::cout << "\twahwah with normalized coefficients should agree with the original..." << std::flush;
+
+      for (double resonance : { 0.1, 2.5, 100.0 }) {
+         for (double depth : { 0.0, 0.7, 1.0 }) {
+            EffectWahwahState original{}, state;
+            original.samplerate = 44100;
+            original.lfoskip = 1.5 * 2 * M_PI / 44100;
+            original.depth = depth;
+            original.freqofs = 0.3;
+            original.phase = 0.5;
+            original.outgain = 0.5;
+            state = original;
+
+            std::vector<float> expected(mInput.size()), actual(mInput.size());
+            Wahwah(original, mInput.data(), expected.data(), mInput.size(), resonance);
+            for (size_t pos = 0, len = 1; pos < mInput.size(); len = len * 7 % 1031 + 1) {
+               len = std::min(len, mInput.size() - pos);
+               state.Process(&mInput[pos], &actual[pos], len, resonance);
+               pos += len;
+            }
+
+            assert(PeakError(expected, actual) < 1e-6);
+         }
+      }
+
+      std::cout << "ok\n";
+   }
+
+private:
+   /* The wahwah filter as it was before its coefficients were divided by
+    * a0 ahead of time, retuned every 30 samples as in Wahwah.cpp */
+   static void Wahwah(EffectWahwahState &data,
+      const float *ibuf, float *obuf, size_t len, double resonance)
+   {
+      for (size_t i = 0; i < len; i++) {
+         double in = ibuf[i];
+
+         if ((data.skipcount++) % 30 == 0) {
+            double frequency =
+               (1 + cos(data.skipcount * data.lfoskip + data.phase)) / 2;
+            frequency = frequency * data.depth * (1 - data.freqofs) + data.freqofs;
+            frequency = exp((frequency - 1) * 6);
+            const double omega = M_PI * frequency;
+            const double sn = sin(omega);
+            const double cs = cos(omega);
+            const double alpha = sn / (2 * resonance);
+            data.b0 = (1 - cs) / 2;
+            data.b1 = 1 - cs;
+            data.b2 = (1 - cs) / 2;
+            data.a0 = 1 + alpha;
+            data.a1 = -2 * cs;
+            data.a2 = 1 - alpha;
+         }
+         double out = (data.b0 * in + data.b1 * data.xn1 + data.b2 * data.xn2
+            - data.a1 * data.yn1 - data.a2 * data.yn2) / data.a0;
+         data.xn2 = data.xn1;
+         data.xn1 = in;
+         data.yn2 = data.yn1;
+         data.yn1 = out;
+
+         obuf[i] = (float) (out * data.outgain);
+      }
+   }
+};
+
+int main()
+{
+   EffectKernelsTest tester;
+
+   tester.SetUp();
+   tester.TestCompressorGain();
+   tester.TearDown();
+
+   tester.SetUp();
+   tester.TestCompressorDecay();
+   tester.TearDown();
+
+   tester.SetUp();
+   tester.TestReverb();
+   tester.TearDown();
+
+   tester.SetUp();
+   tester.TestWahwah();
+   tester.TearDown();
+
+   return 0;
+}